@@ -0,0 +1,495 @@
+#include "lib.hpp"
+
+#include <cmath>
+#include <filesystem>
+#include <sys/resource.h>
+#include <unistd.h>
+
+// bench.cpp
+//
+// Micro and macro benchmarks for the hashing and tree code. Every benchmark runs warmup untimed
+// rounds, then repeat timed rounds, and reports the median with p50 / p90 / p99 of the samples
+// and its own peak resident memory. Inputs come from fixed seeds so runs are repeatable. --json
+// writes one result per line, and --compare reads such a file back and prints the speedup of this
+// run against it.
+
+
+// one reported measurement
+struct BenchResult {
+    string name;
+    string unit;
+
+    // median throughput in unit, or median latency for ns/op results
+    double value;
+
+    // samples in nanoseconds, per round for throughput and per operation for latency
+    vector<double> samples;
+
+    // resident memory high-water mark during the benchmark, 0 where it cannot be measured
+    size_t peakRssKb;
+};
+
+struct BenchConfig {
+    size_t maxLeaves = 1000000;
+    size_t repeat = 5;
+    size_t warmup = 1;
+    size_t threads = 0;
+    string filter;
+    string jsonPath;
+    string comparePath;
+};
+
+static BenchConfig config;
+static vector<BenchResult> results;
+
+// keeps the optimizer from discarding benchmarked work
+static volatile uint8_t sink;
+
+
+/**
+ * @note percentile() returns the p-th percentile of sorted samples, nearest rank
+*/
+static double percentile(const vector<double>& sorted, double p){
+    if (sorted.empty()) { return 0; }
+    size_t rank = size_t(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, rank == 0 ? 0 : rank - 1)];
+}
+
+static bool selected(const string& name){
+    return config.filter.empty() || name.find(config.filter) != string::npos;
+}
+
+/**
+ * @note resetPeakRss() restarts the kernel's resident memory high-water mark at the current RSS, so
+ * peakRssKb() covers only the benchmark that follows. Linux only, elsewhere the peak reads as 0.
+*/
+static void resetPeakRss(){
+    std::ofstream clear("/proc/self/clear_refs");
+    clear << "5";
+}
+
+static size_t peakRssKb(){
+    std::ifstream status("/proc/self/status");
+    for (string line; std::getline(status, line);){
+        if (line.rfind("VmHWM:", 0) == 0){
+            return std::stoull(line.substr(6));
+        }
+    }
+    return 0;
+}
+
+/**
+ * @note report() records a result and prints it as one table row
+*/
+static void report(const string& name, const string& unit, double value, vector<double> samples, size_t peakKb){
+    std::sort(samples.begin(), samples.end());
+    cout << std::left << std::setw(34) << name << std::right << std::fixed << std::setprecision(2)
+         << std::setw(14) << value << " " << std::left << std::setw(9) << unit << std::right
+         << "  p50 " << std::setw(12) << percentile(samples, 50) << " ns"
+         << "  p90 " << std::setw(12) << percentile(samples, 90) << " ns"
+         << "  p99 " << std::setw(12) << percentile(samples, 99) << " ns"
+         << "  peak " << std::setw(9) << std::setprecision(1) << peakKb / 1024.0 << " MiB" << endl;
+    results.push_back({name, unit, value, std::move(samples), peakKb});
+}
+
+/**
+ * @note timeRounds() runs body warmup times untimed, then repeat times timed
+ * @returns nanoseconds per timed round
+*/
+template <class Body>
+static vector<double> timeRounds(Body body){
+    for (size_t i=0; i<config.warmup; i++){
+        body();
+    }
+    vector<double> samples;
+    for (size_t i=0; i<config.repeat; i++){
+        auto start = std::chrono::steady_clock::now();
+        body();
+        samples.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+    }
+    return samples;
+}
+
+/**
+ * @note throughput() times body and reports items per second of the median round, scaled by unitScale
+*/
+template <class Body>
+static void throughput(const string& name, const string& unit, double items, double unitScale, Body body){
+    if (!selected(name)) { return; }
+    resetPeakRss();
+    vector<double> samples = timeRounds(body);
+    size_t peakKb = peakRssKb();
+    vector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+    double median = percentile(sorted, 50);
+    report(name, unit, items / (median * 1e-9) / unitScale, samples, peakKb);
+}
+
+/**
+ * @note latency() times every call of op(i) for i in [0, count) separately and reports the median
+*/
+template <class Op>
+static void latency(const string& name, size_t count, Op op){
+    if (!selected(name)) { return; }
+    resetPeakRss();
+    for (size_t r=0; r<config.warmup; r++){
+        for (size_t i=0; i<count; i++) { op(i); }
+    }
+    vector<double> samples;
+    for (size_t r=0; r<config.repeat; r++){
+        for (size_t i=0; i<count; i++){
+            auto start = std::chrono::steady_clock::now();
+            op(i);
+            samples.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+    size_t peakKb = peakRssKb();
+    vector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+    report(name, "ns/op", percentile(sorted, 50), samples, peakKb);
+}
+
+/**
+ * @note makeInputs() returns n distinct leaf strings
+*/
+static vector<string> makeInputs(size_t n){
+    vector<string> inputs(n);
+    for (size_t i=0; i<n; i++){
+        inputs[i] = "record " + std::to_string(i);
+    }
+    return inputs;
+}
+
+static string sizeName(size_t bytes){
+    if (bytes >= (size_t(1) << 20)) { return std::to_string(bytes >> 20) + "MiB"; }
+    if (bytes >= (size_t(1) << 10)) { return std::to_string(bytes >> 10) + "KiB"; }
+    return std::to_string(bytes) + "B";
+}
+
+static string countName(size_t n){
+    size_t exponent = 0;
+    size_t power = 1;
+    while (power < n) { power *= 10; exponent++; }
+    return (power == n) ? "1e" + std::to_string(exponent) : std::to_string(n);
+}
+
+
+/**
+ * @note benchSHA256() measures single message hashing across message sizes, and multi-buffer batches
+*/
+static void benchSHA256(){
+    vector<uint8_t> data(size_t(1) << 20);
+    uint32_t seed = 1;
+    for (uint8_t& byte : data){
+        seed = seed * 1103515245 + 12345;
+        byte = uint8_t(seed >> 16);
+    }
+
+    SHA256 sha256;
+    for (size_t len : {size_t(0), size_t(64), size_t(1) << 10, size_t(64) << 10, size_t(1) << 20}){
+        // hash enough messages per round for the timer to be meaningful
+        size_t count = std::max<size_t>(16, (size_t(8) << 20) / std::max<size_t>(len, 64));
+        double bytes = double(std::max<size_t>(len, 1)) * count;
+        throughput("sha256/" + sizeName(len), len == 0 ? "Mhash/s" : "MB/s", len == 0 ? count : bytes, 1e6, [&]{
+            uint8_t digest[32];
+            for (size_t i=0; i<count; i++){
+                sha256.init();
+                sha256.update(data.data(), len);
+                sha256.final(digest);
+            }
+            sink = digest[0];
+        });
+    }
+
+    // 64 byte messages through the active batch backend
+    size_t count = 1 << 16;
+    vector<BatchMessage> msgs(count);
+    for (size_t i=0; i<count; i++){
+        msgs[i] = {&data[(i * 64) % (data.size() - 64)], 64};
+    }
+    vector<Digest> digests(count);
+    throughput(string("sha256_batch/64B/") + SHA256Batch::active().name, "MB/s", 64.0 * count, 1e6, [&]{
+        SHA256Batch::hash(msgs.data(), count, digests.data()->data());
+        sink = digests[0][0];
+    });
+}
+
+/**
+ * @note benchTrees() measures leaf hashing and tree construction from 10^3 leaves up to --max-leaves
+*/
+static void benchTrees(ThreadPool& pool){
+    for (size_t n=1000; n<=config.maxLeaves; n*=10){
+        vector<string> inputs = makeInputs(n);
+        string suffix = "/" + countName(n);
+        vector<std::string_view> views(inputs.begin(), inputs.end());
+
+        for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+            MerkleTree merkelTree = MerkleTree(mode);
+            string modeName = (mode == HashMode::Hex) ? "hex" : "binary";
+
+            if (mode == HashMode::Hex){
+                throughput("hashStrings" + suffix, "Mleaf/s", n, 1e6, [&]{
+                    sink = merkelTree.hashStrings(inputs)[0][0];
+                });
+                throughput("assembleTree" + suffix, "Mleaf/s", n, 1e6, [&]{
+                    TreeNode* root = merkelTree.assembleTree(inputs);
+                    sink = root->digest[0];
+                    merkelTree.freeTree(&root);
+                });
+            }
+            throughput("buildTree/" + modeName + suffix, "Mleaf/s", n, 1e6, [&]{
+                sink = merkelTree.buildTree(inputs).root()[0];
+            });
+            throughput("buildTree_views/" + modeName + suffix, "Mleaf/s", n, 1e6, [&]{
+                sink = merkelTree.buildTree(std::span<const std::string_view>(views)).root()[0];
+            });
+            throughput("buildTree_parallel/" + modeName + suffix, "Mleaf/s", n, 1e6, [&]{
+                sink = merkelTree.buildTree(inputs, pool).root()[0];
+            });
+            throughput("basicTree/" + modeName + suffix, "Mleaf/s", n, 1e6, [&]{
+                if (mode == HashMode::Hex){
+                    BasicMerkleTree<SHA256HexPolicy> tree;
+                    tree.build(inputs);
+                    sink = tree.root()[0];
+                }
+                else {
+                    BasicMerkleTree<SHA256BinaryPolicy> tree;
+                    tree.build(inputs);
+                    sink = tree.root()[0];
+                }
+            });
+
+            // rebuild of unchanged leaves, served from the cache the first round fills
+            HashCache cache(2 * n * (HashCache::entryOverhead + 80));
+            MerkleTree cachedTree = MerkleTree(mode);
+            cachedTree.cache = &cache;
+            throughput("buildTree_cached/" + modeName + suffix, "Mleaf/s", n, 1e6, [&]{
+                sink = cachedTree.buildTree(inputs).root()[0];
+            });
+        }
+    }
+}
+
+/**
+ * @note benchQueries() measures proof generation and verification, and incremental update latency
+*/
+static void benchQueries(){
+    size_t n = std::min<size_t>(config.maxLeaves, 1000000);
+    string suffix = "/" + countName(n);
+    vector<string> inputs = makeInputs(n);
+    MerkleTree merkelTree = MerkleTree(HashMode::Binary);
+    FlatTree tree = merkelTree.buildTree(inputs);
+    MerkleProof prover(HashMode::Binary);
+
+    // a fixed pseudo random sequence of leaves
+    const size_t ops = 1000;
+    vector<size_t> indices(ops);
+    uint64_t state = 42;
+    for (size_t& index : indices){
+        state = state * 6364136223846793005 + 1442695040888963407;
+        index = size_t(state >> 33) % n;
+    }
+
+    vector<AuditPath> paths(ops);
+    latency("prove" + suffix, ops, [&](size_t i){
+        paths[i] = prover.prove(tree, indices[i]);
+    });
+    latency("verify" + suffix, ops, [&](size_t i){
+        sink = prover.verify(tree.node(0, indices[i]), paths[i], tree.root());
+    });
+    latency("updateLeaf" + suffix, ops, [&](size_t i){
+        merkelTree.updateLeaf(tree, indices[i], "updated " + std::to_string(i));
+    });
+
+    vector<std::pair<size_t, string>> updates(ops);
+    for (size_t i=0; i<ops; i++){
+        updates[i] = {indices[i], "batch " + std::to_string(i)};
+    }
+    throughput("updateLeaves/1000" + suffix, "Mleaf/s", ops, 1e6, [&]{
+        merkelTree.updateLeaves(tree, updates);
+    });
+
+    // wire format, all paths back to back in one buffer
+    vector<uint8_t> wire;
+    for (size_t i=0; i<ops; i++){
+        paths[i] = prover.prove(tree, indices[i]);
+        ProofCodec::encode(paths[i], wire);
+    }
+    vector<uint8_t> encoded;
+    throughput("encodePath/1000" + suffix, "Mproof/s", ops, 1e6, [&]{
+        encoded.clear();
+        for (const AuditPath& path : paths){
+            ProofCodec::encode(path, encoded);
+        }
+    });
+    throughput("decodePath/1000" + suffix, "Mproof/s", ops, 1e6, [&]{
+        std::span<const uint8_t> rest(wire);
+        AuditPathView view;
+        while (!rest.empty()){
+            rest = rest.subspan(ProofCodec::decode(rest, view));
+        }
+        sink = uint8_t(view.siblings.size());
+    });
+    throughput("decodeVerify/1000" + suffix, "Mproof/s", ops, 1e6, [&]{
+        std::span<const uint8_t> rest(wire);
+        AuditPathView view;
+        Digest root;
+        for (size_t i=0; i<ops; i++){
+            rest = rest.subspan(ProofCodec::decode(rest, view));
+            sink = prover.computeRoot(tree.node(0, view.leafIndex), view.leafIndex, view.leafCount, view.siblings, root);
+        }
+    });
+}
+
+/**
+ * @note benchIngest() measures the root of a record file read and hashed one after the other,
+ * against the pipeline that overlaps reading, hashing and combining
+*/
+static void benchIngest(ThreadPool& pool){
+    size_t n = config.maxLeaves;
+    string suffix = "/" + countName(n);
+    if (!selected("ingest_sequential" + suffix) && !selected("ingest_pipeline" + suffix)){
+        return;
+    }
+    string path = (std::filesystem::temp_directory_path() / ("merkle_bench_ingest_" + std::to_string(getpid()) + ".rec")).string();
+    vector<string> inputs = makeInputs(n);
+    vector<std::string_view> views(inputs.begin(), inputs.end());
+    RecordFile::write(views, path, RecordFormat::Lines);
+    size_t bytes = 0;
+    for (const string& input : inputs){
+        bytes += input.size() + 1;
+    }
+    inputs.clear();
+
+    MerkleTree merkelTree = MerkleTree(HashMode::Binary);
+    throughput("ingest_sequential" + suffix, "MB/s", bytes, 1e6, [&]{
+        std::ifstream in(path);
+        vector<string> records;
+        for (string line; std::getline(in, line);){
+            records.push_back(line);
+        }
+        sink = merkelTree.buildTree(records).root()[0];
+    });
+
+    MerklePipeline pipeline(HashMode::Binary, pool.size());
+    throughput("ingest_pipeline" + suffix, "MB/s", bytes, 1e6, [&]{
+        sink = pipeline.start(path, RecordFormat::Lines).get()[0];
+    });
+    std::remove(path.c_str());
+}
+
+/**
+ * @note writeJson() saves the results, one per line so runs can be diffed and compared
+*/
+static void writeJson(const string& path){
+    std::ofstream out(path);
+    if (!out){
+        throw std::runtime_error("bench: cannot write " + path);
+    }
+
+    out << "{\n";
+    out << "  \"compress_backend\": \"" << SHA256Compress::active().name << "\",\n";
+    out << "  \"batch_backend\": \"" << SHA256Batch::active().name << "\",\n";
+    out << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+    out << "  \"repeat\": " << config.repeat << ", \"warmup\": " << config.warmup << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i=0; i<results.size(); i++){
+        vector<double> sorted = results[i].samples;
+        std::sort(sorted.begin(), sorted.end());
+        out << std::fixed << std::setprecision(3)
+            << "    {\"name\": \"" << results[i].name << "\", \"unit\": \"" << results[i].unit
+            << "\", \"value\": " << results[i].value << ", \"p50_ns\": " << percentile(sorted, 50)
+            << ", \"p90_ns\": " << percentile(sorted, 90) << ", \"p99_ns\": " << percentile(sorted, 99)
+            << ", \"samples\": " << sorted.size() << ", \"peak_rss_kb\": " << results[i].peakRssKb << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ],\n";
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    out << "  \"max_rss_kb\": " << usage.ru_maxrss << "\n";
+    out << "}\n";
+}
+
+/**
+ * @note compare() reads the results of an earlier --json run and prints how this run relates to it.
+ * Higher is better for throughput, lower for ns/op, so the speedup is flipped for latencies.
+*/
+static void compare(const string& path){
+    std::ifstream in(path);
+    if (!in){
+        throw std::runtime_error("bench: cannot read " + path);
+    }
+
+    auto field = [](const string& line, const string& key) -> string {
+        size_t pos = line.find("\"" + key + "\": ");
+        if (pos == string::npos) { return ""; }
+        pos += key.size() + 4;
+        if (line[pos] == '"'){
+            return line.substr(pos + 1, line.find('"', pos + 1) - pos - 1);
+        }
+        return line.substr(pos, line.find_first_of(",}", pos) - pos);
+    };
+
+    cout << endl << "Compared to " << path << ":" << endl;
+    string line;
+    while (std::getline(in, line)){
+        string name = field(line, "name");
+        if (name.empty()) { continue; }
+        double before = std::stod(field(line, "value"));
+        for (const BenchResult& result : results){
+            if (result.name != name || before <= 0) { continue; }
+            double speedup = (result.unit == "ns/op") ? before / result.value : result.value / before;
+            cout << std::left << std::setw(34) << name << std::right << std::fixed << std::setprecision(2)
+                 << std::setw(8) << speedup << "x" << endl;
+        }
+    }
+}
+
+
+int main(int argc, char* argv[]){
+
+    for (int i=1; i<argc; i++){
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--max-leaves" && hasValue) { config.maxLeaves = std::stoull(argv[++i]); }
+        else if (arg == "--repeat" && hasValue) { config.repeat = std::max<size_t>(1, std::stoull(argv[++i])); }
+        else if (arg == "--warmup" && hasValue) { config.warmup = std::stoull(argv[++i]); }
+        else if (arg == "--threads" && hasValue) { config.threads = std::stoull(argv[++i]); }
+        else if (arg == "--filter" && hasValue) { config.filter = argv[++i]; }
+        else if (arg == "--json" && hasValue) { config.jsonPath = argv[++i]; }
+        else if (arg == "--compare" && hasValue) { config.comparePath = argv[++i]; }
+        else {
+            cout << "Usage: " << argv[0] << " [--max-leaves N] [--repeat N] [--warmup N] [--threads N]"
+                 << " [--filter TEXT] [--json OUT] [--compare OLD.json]" << endl;
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    ThreadPool pool(config.threads);
+    cout << "compress backend " << SHA256Compress::active().name << ", batch backend " << SHA256Batch::active().name
+         << ", " << pool.size() << " threads" << endl << endl;
+
+    try {
+        benchSHA256();
+        benchTrees(pool);
+        benchQueries();
+        benchIngest(pool);
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        cout << endl << "max rss: " << usage.ru_maxrss << " KiB" << endl;
+
+        if (!config.jsonPath.empty()){
+            writeJson(config.jsonPath);
+        }
+        if (!config.comparePath.empty()){
+            compare(config.comparePath);
+        }
+    }
+    catch (const std::runtime_error& error){
+        cout << error.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+// BasicMerkleTree.hpp
+
+template <class Hasher = SHA256HexPolicy>
+class BasicMerkleTree {
+    /**
+     * @notice BasicMerkleTree is a merkle tree whose hash function is fixed at compile time by a
+     * policy (see HashPolicy.hpp). Nodes are arrays of exactly Hasher::digestSize bytes, stored
+     * level by level in one buffer like FlatTree, so a 16 byte policy uses half the memory of
+     * SHA-256. The build loops call the policy's static functions directly, and use its batch hooks
+     * when it has them. A node without a sibling is hashed alone.
+     *
+     * The default policy, SHA256HexPolicy, gives the same roots as MerkleTree in HashMode::Hex,
+     * and SHA256BinaryPolicy as HashMode::Binary.
+    */
+
+    public:
+        static constexpr size_t digestSize = Hasher::digestSize;
+        typedef array<uint8_t, digestSize> NodeDigest;
+        static_assert(sizeof(NodeDigest) == digestSize, "nodes are stored back to back without padding");
+
+        // builds from strings, or from byte ranges hashed in place
+        void build(const vector<string>& input){
+            vector<BatchMessage> msgs(input.size());
+            for (size_t i=0; i<input.size(); i++){
+                msgs[i] = {reinterpret_cast<const uint8_t*>(input[i].data()), input[i].size()};
+            }
+            build(msgs.data(), msgs.size());
+        }
+
+        void build(const BatchMessage* msgs, size_t count){
+            assert(count > 0);
+            shape(count);
+
+            NodeDigest* leaves = level(0);
+            if constexpr (requires { Hasher::leaves(msgs, count, leaves->data()); }){
+                Hasher::leaves(msgs, count, leaves->data());
+            }
+            else {
+                for (size_t i=0; i<count; i++){
+                    Hasher::leaf(msgs[i].data, msgs[i].len, leaves[i].data());
+                }
+            }
+
+            for (size_t l=1; l<levelCount(); l++){
+                hashLevel(level(l - 1), levelSize(l - 1), level(l));
+            }
+        }
+
+        // shape
+        size_t leafCount() const { return sizes.empty() ? 0 : sizes[0]; }
+        size_t levelCount() const { return sizes.size(); }
+        size_t levelSize(size_t level) const { return sizes[level]; }
+
+        // node access
+        NodeDigest* level(size_t level) { return nodes.data() + offsets[level]; }
+        const NodeDigest* level(size_t level) const { return nodes.data() + offsets[level]; }
+        const NodeDigest& node(size_t level, size_t index) const { return nodes[offsets[level] + index]; }
+        const NodeDigest& root() const { return nodes.back(); }
+        string rootHex() const { return SHA256::toHex(root().data(), digestSize); }
+
+    private:
+        vector<NodeDigest> nodes;
+
+        // start of each level in nodes and its number of nodes, leaves first
+        vector<size_t> offsets;
+        vector<size_t> sizes;
+
+        // lays the levels out back to back in the shape FlatTree uses
+        void shape(size_t leafCount){
+            FlatTree::shape(leafCount, sizes);
+            offsets.resize(sizes.size());
+            size_t total = 0;
+            for (size_t l=0; l<sizes.size(); l++){
+                offsets[l] = total;
+                total += sizes[l];
+            }
+            nodes.resize(total);
+        }
+
+        // hashes one level into its parents, full pairs first and an odd last node alone
+        static void hashLevel(const NodeDigest* children, size_t count, NodeDigest* parents){
+            size_t numPairs = count / 2;
+            if constexpr (requires { Hasher::nodes(children->data(), numPairs, parents->data()); }){
+                Hasher::nodes(children->data(), numPairs, parents->data());
+            }
+            else {
+                for (size_t i=0; i<numPairs; i++){
+                    Hasher::node(children[2*i].data(), children[2*i + 1].data(), parents[i].data());
+                }
+            }
+            if (count % 2 == 1){
+                Hasher::alone(children[count - 1].data(), parents[numPairs].data());
+            }
+        }
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+// BoundedQueue.hpp
+
+template <class T>
+class BoundedQueue {
+    /**
+     * @notice BoundedQueue is a fixed capacity multi-producer multi-consumer queue without locks
+     * (D. Vyukov's bounded MPMC queue). It is a ring of cells, and each cell carries a sequence
+     * number that tells whose turn it is. A producer claims the cell at the enqueue position with
+     * one compare-and-swap, stores its item, and publishes it by advancing the cell's sequence.
+     * A consumer does the same at the dequeue position. Producers and consumers only contend on
+     * their own position counter, which sit on separate cache lines.
+     *
+     * push() blocks while the queue is full, which is the backpressure between pipeline stages.
+     * pop() blocks while it is empty. A blocked call spins briefly, then yields, then naps, since
+     * the items passed through these queues are large batches and a wait of microseconds does not
+     * matter. After close(), pop() drains what is left and then returns false.
+    */
+
+    public:
+        explicit BoundedQueue(size_t capacity) : cells(std::bit_ceil(std::max<size_t>(capacity, 2))), mask(cells.size() - 1) {
+            for (size_t i=0; i<cells.size(); i++){
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+        BoundedQueue(const BoundedQueue&) = delete;
+        BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+        size_t capacity() const { return cells.size(); }
+
+        // non-blocking, false when full or empty; item is only moved from on success
+        bool tryPush(T& item){
+            size_t pos = enqueuePos.load(std::memory_order_relaxed);
+            while (true){
+                Cell& cell = cells[pos & mask];
+                intptr_t diff = intptr_t(cell.sequence.load(std::memory_order_acquire)) - intptr_t(pos);
+                if (diff == 0){
+                    if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                        cell.value = std::move(item);
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0){
+                    return false;
+                }
+                else {
+                    pos = enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool tryPop(T& item){
+            size_t pos = dequeuePos.load(std::memory_order_relaxed);
+            while (true){
+                Cell& cell = cells[pos & mask];
+                intptr_t diff = intptr_t(cell.sequence.load(std::memory_order_acquire)) - intptr_t(pos + 1);
+                if (diff == 0){
+                    if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                        item = std::move(cell.value);
+                        cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0){
+                    return false;
+                }
+                else {
+                    pos = dequeuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // blocking, push() must not be called after close()
+        void push(T item){
+            assert(!isClosed.load(std::memory_order_relaxed));
+            for (size_t attempt=0; !tryPush(item); attempt++){
+                backoff(attempt);
+            }
+        }
+
+        bool pop(T& item){
+            for (size_t attempt=0; ; attempt++){
+                if (tryPop(item)){
+                    return true;
+                }
+
+                // every push happened before close(), so one more try after seeing it drains them
+                if (isClosed.load(std::memory_order_acquire)){
+                    return tryPop(item);
+                }
+                backoff(attempt);
+            }
+        }
+
+        // no more pushes, consumers return false once the queue is empty
+        void close(){ isClosed.store(true, std::memory_order_release); }
+        bool closed() const { return isClosed.load(std::memory_order_acquire); }
+
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        vector<Cell> cells;
+        size_t mask;
+        alignas(64) std::atomic<size_t> enqueuePos{0};
+        alignas(64) std::atomic<size_t> dequeuePos{0};
+        alignas(64) std::atomic<bool> isClosed{false};
+
+        static void backoff(size_t attempt){
+            if (attempt < 64){
+                return;
+            }
+            if (attempt < 1024){
+                std::this_thread::yield();
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+};
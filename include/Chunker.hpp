@@ -0,0 +1,42 @@
+#pragma once
+
+// Chunker.hpp
+
+class Chunker {
+    /**
+     * @notice Chunker splits a byte stream into content defined chunks (FastCDC). A gear hash rolls over
+     * the data with fp = (fp << 1) + gear[byte]. The high bits of fp depend only on the last 64 bytes,
+     * and a chunk ends where those high bits are all zero. Boundaries therefore move with the content:
+     * inserting or deleting bytes changes the chunks around the edit, and the chunks after it
+     * resynchronize and keep their hashes.
+     *
+     * The first minSize bytes of a chunk are skipped without hashing. Up to avgSize a stricter mask
+     * (more bits) is used, and after it a looser one. This normalizes chunk sizes around avgSize, and
+     * a chunk is cut unconditionally at maxSize. The scan is one table lookup, one shift and one add
+     * per byte, with no data dependent branches except the cut test.
+     *
+     * split() returns the chunks as BatchMessages pointing into the input, ready for
+     * SHA256Batch::hash() or MerkleTree::buildTree().
+    */
+
+    public:
+        Chunker(size_t minSize = size_t(2) << 10, size_t avgSize = size_t(8) << 10, size_t maxSize = size_t(64) << 10);
+
+        // chunk size bounds, 0 < minSize <= avgSize <= maxSize
+        size_t minSize;
+        size_t avgSize;
+        size_t maxSize;
+
+        // length of the chunk starting at data, at most len
+        size_t nextCut(const uint8_t* data, size_t len) const;
+
+        // every chunk of data, in order
+        vector<BatchMessage> split(const uint8_t* data, size_t len) const;
+
+        // the 256 gear values, fixed so boundaries are stable across builds
+        static const array<uint64_t, 256>& gearTable();
+
+    private:
+        uint64_t maskSmall;
+        uint64_t maskLarge;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+// ExternalBuilder.hpp
+
+class ExternalBuilder {
+    /**
+     * @notice ExternalBuilder builds a tree over more leaves than fit in memory. Its memory use is
+     * fixed by memoryBudget, whatever the leaf count.
+     *
+     * Leaves are streamed in and hashed into a block of blockLeaves() slots, a power of two that
+     * takes half the budget together with the levels above it. When a block fills up, the levels
+     * of its perfect subtree are hashed in memory, and each level is appended to that level's
+     * scratch file with one sequential write. Blocks start at multiples of their size, so they pair
+     * the same nodes as MerkleTree::buildTree(). The last, partial block applies the odd node rule
+     * at the end of each of its levels, as in the parallel build.
+     *
+     * The levels above the blocks are built in passes. A pass reads a level file in large buffered
+     * reads of an even number of nodes, hashes them with MerkleTree::hashLevel(), and writes the
+     * next level file. Each pass reads half as much as the one before.
+     *
+     * finish() returns the root. With a treePath, it also writes all levels to a TreeFile, streamed
+     * from the scratch files, so the result can be mapped and queried. Without one, only the block
+     * roots are written to disk. Scratch files are deleted by finish() or by the destructor, and
+     * I/O failures throw std::runtime_error.
+    */
+
+    public:
+        ExternalBuilder(HashMode mode = HashMode::Hex, size_t memoryBudget = size_t(64) << 20,
+                        const string& treePath = "", const string& scratchDir = "");
+        ExternalBuilder(const ExternalBuilder&) = delete;
+        ExternalBuilder& operator=(const ExternalBuilder&) = delete;
+        ~ExternalBuilder();
+
+        // streaming leaves, in tree order
+        void append(std::string_view data);
+        void append(std::span<const std::string_view> input);
+        void append(const BatchMessage* msgs, size_t count);
+        void appendDigest(const Digest& leaf);
+
+        // builds the levels above the blocks, writes the tree file if one was asked for, returns the root
+        Digest finish();
+
+        uint64_t leafCount() const { return leaves; }
+        size_t blockLeaves() const { return blockSize; }
+
+    private:
+        MerkleTree tree;
+        string treePath;
+        string scratchPrefix;
+        bool finished;
+
+        // leaves appended, and the leaves in the current block
+        uint64_t leaves;
+        size_t filled;
+
+        // the current block's levels back to back, level 0 first, and its number of levels above the leaves
+        size_t blockSize;
+        size_t blockHeight;
+        vector<Digest> block;
+
+        // one scratch file per level, opened on first write
+        vector<std::unique_ptr<std::ofstream>> levelFiles;
+
+        string levelPath(size_t level) const;
+        void writeLevel(size_t level, const Digest* nodes, size_t count);
+        void flushBlock(bool last);
+        void removeScratch();
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+// FileHasher.hpp
+
+// one input file and the leaves its chunks occupy
+typedef struct fileEntry{
+
+    // path as found on the command line or while walking a directory
+    string path;
+
+    // size in bytes
+    uint64_t size;
+
+    // last modification time in nanoseconds since the epoch
+    int64_t mtime;
+
+    // position of the file's first chunk among all leaves, and its number of chunks
+    size_t firstLeaf;
+    size_t leafCount;
+}FileEntry;
+
+class FileHasher {
+    /**
+     * @notice FileHasher fingerprints files and directory trees. Every file is cut into fixed size
+     * chunks, and each chunk becomes one leaf, hashed as SHA-256 of its bytes. The tree is built
+     * over the chunks of all files in order. Directories are walked recursively, and their regular
+     * files are taken in sorted path order so the root does not depend on the order the filesystem
+     * lists them in. An empty file contributes one leaf, the hash of no bytes. Only file contents
+     * are hashed, so renaming a file without moving it in the order keeps the root.
+     *
+     * Chunk hashing is cut into tasks of about taskBytes from one file each. The tasks run on a
+     * thread pool, and each one reads its window of the file with pread() into a buffer reused
+     * across the tasks of a thread, then hashes the chunks in one multi-buffer batch.
+     * With a cache attached, a task whose chunks are all cached for the file's current path, size
+     * and mtime does not open the file at all. A task checks that the open file still has the size
+     * and mtime scan() recorded before it reads the window and again before it caches the digests.
+     * A file that changed in between, or ends before its window does, fails the hash with a
+     * std::runtime_error, so it has to be scanned again.
+    */
+
+    public:
+        FileHasher(size_t chunkSize = size_t(1) << 20, HashMode mode = HashMode::Hex);
+
+        // bytes per leaf, > 0
+        size_t chunkSize;
+
+        // parent hashing scheme of the tree
+        HashMode mode;
+
+        // target bytes per hashing task
+        size_t taskBytes;
+
+        // optional cache of chunk digests keyed by path, size and mtime, owned by the caller
+        HashCache* cache;
+
+        // expands directories and sizes every file, throws std::runtime_error on unreadable paths
+        vector<FileEntry> scan(const vector<string>& paths) const;
+
+        // hashes every chunk of the scanned files into one leaf digest each
+        vector<Digest> hashChunks(const vector<FileEntry>& files, ThreadPool& pool) const;
+
+        // tree over all chunks, and the root of one file's chunks
+        FlatTree buildTree(const vector<Digest>& leaves) const;
+        Digest fileRoot(const FileEntry& file, const vector<Digest>& leaves) const;
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+// FlatTree.hpp
+
+class FlatTree {
+    /**
+     * @notice FlatTree holds every level of a merkle tree in one contiguous, cache line aligned buffer
+     * of digests. Level 0 holds the leaves, and the last level holds only the root. Each level
+     * follows the previous one in the buffer. Nodes are addressed as (level, index), and relatives
+     * are found by index arithmetic instead of pointers: the parent of i is i / 2, its children are
+     * 2i and 2i + 1, and its sibling is i ^ 1. A node at the end of a level with no sibling is
+     * hashed alone, as in MerkleTree::assembleTree().
+     *
+     * The whole tree is allocated in a single shot and released in O(1). The buffer can be laid
+     * out for more leaves than the tree holds (reserve()). Leaves can then be appended by filling
+     * the spare slots of each level, and only the right edge of the tree has to be rehashed.
+    */
+
+    public:
+        FlatTree();
+        explicit FlatTree(HashMode mode);
+        FlatTree(size_t leafCount, HashMode mode);
+        FlatTree(const FlatTree& other);
+        FlatTree(FlatTree&& other) noexcept;
+        FlatTree& operator=(FlatTree other) noexcept;
+        ~FlatTree();
+
+        // shape
+        size_t leafCount() const { return leaves; }
+        size_t levelCount() const { return sizes.size(); }
+        size_t levelSize(size_t level) const { return sizes[level]; }
+        size_t leafCapacity() const { return reservedLeaves; }
+        HashMode hashMode() const { return mode; }
+
+        // reshaping, new nodes are left for the caller to hash
+        void reserve(size_t leafCapacity);
+        void resize(size_t leafCount);
+
+        // node access
+        Digest* level(size_t level) { return buffer + offsets[level]; }
+        const Digest* level(size_t level) const { return buffer + offsets[level]; }
+        Digest& node(size_t level, size_t index) { return buffer[offsets[level] + index]; }
+        const Digest& node(size_t level, size_t index) const { return buffer[offsets[level] + index]; }
+        const Digest& root() const { return buffer[offsets[sizes.size() - 1]]; }
+        string rootHex() const;
+
+        // level sizes of a tree of leafCount leaves, shared with the on-disk layout of TreeFile
+        static void shape(size_t leafCount, vector<size_t>& sizes);
+
+        // the same shape one level at a time, for builders that never hold the whole tree. Each
+        // level halves the one below, rounding up, so level l has ceil(leafCount / 2^l) nodes
+        static size_t levelCountOf(size_t leafCount) { return std::bit_width(leafCount - 1) + 1; }
+        static size_t levelSizeOf(size_t leafCount, size_t level) { return ((leafCount - 1) >> level) + 1; }
+
+        // index arithmetic
+        static size_t parent(size_t index) { return index / 2; }
+        static size_t leftChild(size_t index) { return 2 * index; }
+        static size_t rightChild(size_t index) { return 2 * index + 1; }
+        static size_t sibling(size_t index) { return index ^ 1; }
+
+        // node pointer view for existing callers, release with MerkleTree::freeTree()
+        TreeNode* toNodes() const;
+
+        // alignment of the digest buffer
+        static constexpr size_t alignment = 64;
+
+    private:
+        Digest* buffer;
+        size_t capacity;
+        size_t leaves;
+        size_t reservedLeaves;
+        HashMode mode;
+
+        // start of each level in the buffer (laid out for reservedLeaves) and its number of nodes
+        vector<size_t> offsets;
+        vector<size_t> sizes;
+
+        static size_t layout(size_t leafCapacity, vector<size_t>& offsets);
+        void allocate(size_t numDigests);
+        void release();
+};
+
+/**
+ * @note buildTree() builds the tree over a range of records, read in place. It is defined here
+ * because it needs the complete FlatTree.
+ * @param first, last are the records, at least one
+ * @returns the flat tree
+*/
+template <class It>
+FlatTree MerkleTree::buildTree(It first, It last){
+    size_t count = size_t(std::distance(first, last));
+    assert(count > 0);
+
+    MERKLE_STATS_ONLY(stats = BuildStats(); HashCounters before = Stats::snapshot();)
+    MERKLE_SCOPE("buildTree", &stats.totalNs);
+
+    FlatTree tree(count, mode);
+    {
+        MERKLE_SCOPE("leaves", &stats.leafNs);
+        hashLeaves(first, last, tree.level(0));
+    }
+    hashLevels(tree, 1);
+
+    MERKLE_STATS_ONLY(stats.counters = Stats::delta(before);)
+    return tree;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+// HashCache.hpp
+
+// what a cache key holds, so keys of different kinds never collide
+enum class CacheKind : uint8_t {
+
+    // the bytes of a leaf
+    Leaf,
+
+    // a chunk of a file: path, size, modification time, chunk size and chunk index
+    File,
+
+    // the hash mode and the two child digests of a parent
+    Pair
+};
+
+// hit and miss counters, summed over all shards
+typedef struct cacheStats{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t insertions;
+    uint64_t evictions;
+
+    // entries held, and the bytes they are charged for
+    size_t entries;
+    size_t bytes;
+}CacheStats;
+
+class HashCache {
+    /**
+     * @notice HashCache maps inputs to digests it has already computed, so that repeated leaves,
+     * unchanged file chunks and identical subtrees are not hashed again. A key is the full input
+     * (the leaf bytes, or the two children of a parent), or a file chunk's path, size and mtime.
+     * The whole key is stored and compared, so a hit can never return the digest of different
+     * bytes.
+     *
+     * The cache is bounded by capacityBytes, charged as key bytes plus a fixed overhead per entry.
+     * Eviction follows CLOCK: a hit only sets the entry's referenced bit, and the hand clears bits
+     * until it finds an entry that was not used since its last pass. Each shard is one open
+     * addressing table, so a hit costs a probe and a key compare without walking list or map
+     * nodes. Keys are spread over independently locked shards, so the threads of a parallel build
+     * rarely contend.
+     *
+     * A lookup still touches memory that hashing does not. It pays off for inputs that cost more
+     * to hash than a probe: large leaves and file chunks, or hosts without SHA instructions.
+     * MerkleTree and FileHasher use a cache only when one is attached through their cache member.
+     * The caller owns it, and it can be shared across trees and rebuilds.
+    */
+
+    public:
+        HashCache(size_t capacityBytes = size_t(64) << 20, size_t numShards = 16);
+        HashCache(const HashCache&) = delete;
+        HashCache& operator=(const HashCache&) = delete;
+
+        // digest cached for a key, returns false on a miss
+        bool lookup(CacheKind kind, std::string_view key, Digest& digest);
+        void insert(CacheKind kind, std::string_view key, const Digest& digest);
+
+        // parents memoized by their children
+        bool lookupPair(const Digest& left, const Digest& right, HashMode mode, Digest& parent);
+        void insertPair(const Digest& left, const Digest& right, HashMode mode, const Digest& parent);
+
+        CacheStats stats() const;
+        void clear();
+        size_t capacity() const { return shardCapacity * shards.size(); }
+
+        // bookkeeping charged per entry on top of its key bytes, covers a slot at half load
+        static constexpr size_t entryOverhead = 192;
+
+    private:
+
+        // one open addressing slot, the key bytes are owned by the slot
+        struct Slot {
+            size_t hash;
+            Digest digest;
+            CacheKind kind;
+            bool used;
+            bool referenced;
+            string key;
+        };
+
+        // one independently locked table, linear probing, with a CLOCK hand for eviction
+        struct Shard {
+            mutable std::mutex lock;
+            vector<Slot> slots;
+            size_t hand = 0;
+            size_t entries = 0;
+            size_t bytes = 0;
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t insertions = 0;
+            uint64_t evictions = 0;
+        };
+
+        size_t shardCapacity;
+        vector<std::unique_ptr<Shard>> shards;
+
+        static size_t keyHash(CacheKind kind, std::string_view key);
+        Shard& shardFor(size_t hash);
+        static size_t find(const Shard& shard, CacheKind kind, std::string_view key, size_t hash);
+        static void erase(Shard& shard, size_t index);
+        static void evictOne(Shard& shard);
+        static void grow(Shard& shard);
+        static std::string_view pairKey(const Digest& left, const Digest& right, HashMode mode, uint8_t* buffer);
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+// HashPolicy.hpp
+
+/**
+ * @notice Hash policies tell BasicMerkleTree how to hash at compile time. A policy is a struct of
+ * static inline functions:
+ *
+ *   static constexpr size_t digestSize;                                   bytes per node
+ *   static void leaf(const uint8_t* data, size_t len, uint8_t* out);      leaf from its data
+ *   static void node(const uint8_t* left, const uint8_t* right, uint8_t* out);   parent of a pair
+ *   static void alone(const uint8_t* child, uint8_t* out);                parent of a node without a sibling
+ *
+ * and optionally hooks that hash many at once, which the tree uses when they exist:
+ *
+ *   static void leaves(const BatchMessage* msgs, size_t count, uint8_t* out);
+ *   static void nodes(const uint8_t* children, size_t numPairs, uint8_t* out);   children back to back
+ *
+ * The tree calls the policy directly, so there is no virtual dispatch, and the compiler inlines and
+ * specializes everything the policy defines inline.
+*/
+
+// SHA-256 of several byte ranges catted together, without copying them
+struct SHA256Parts {
+    static inline void hash(std::initializer_list<std::pair<const uint8_t*, size_t>> parts, uint8_t* out) {
+        SHA256 sha256;
+        sha256.init();
+        for (const auto& [data, len] : parts) {
+            sha256.update(data, len);
+        }
+        sha256.final(out);
+    }
+};
+
+// SHA-256 with parents over the children's hex text, the scheme of MerkleTree in HashMode::Hex
+struct SHA256HexPolicy {
+    static constexpr size_t digestSize = 32;
+    static constexpr HashMode mode = HashMode::Hex;
+
+    static inline void leaf(const uint8_t* data, size_t len, uint8_t* out) {
+        SHA256Parts::hash({{data, len}}, out);
+    }
+    static inline void node(const uint8_t* left, const uint8_t* right, uint8_t* out) {
+        SHA256Pair::active(mode)(left, right, out);
+    }
+    static inline void alone(const uint8_t* child, uint8_t* out) {
+        char text[64];
+        SHA256::toHex(child, 32, text);
+        SHA256Parts::hash({{reinterpret_cast<const uint8_t*>(text), 64}}, out);
+    }
+    static inline void leaves(const BatchMessage* msgs, size_t count, uint8_t* out) {
+        SHA256Batch::hash(msgs, count, out);
+    }
+    static inline void nodes(const uint8_t* children, size_t numPairs, uint8_t* out) {
+        SHA256Pair::hashPairs(reinterpret_cast<const Digest*>(children), numPairs, reinterpret_cast<Digest*>(out), mode);
+    }
+};
+
+// SHA-256 with parents over the children's raw bytes, the scheme of MerkleTree in HashMode::Binary
+struct SHA256BinaryPolicy : SHA256HexPolicy {
+    static constexpr HashMode mode = HashMode::Binary;
+
+    static inline void node(const uint8_t* left, const uint8_t* right, uint8_t* out) {
+        SHA256Pair::active(mode)(left, right, out);
+    }
+    static inline void alone(const uint8_t* child, uint8_t* out) {
+        SHA256Parts::hash({{child, 32}}, out);
+    }
+    static inline void nodes(const uint8_t* children, size_t numPairs, uint8_t* out) {
+        SHA256Pair::hashPairs(reinterpret_cast<const Digest*>(children), numPairs, reinterpret_cast<Digest*>(out), mode);
+    }
+};
+
+// double SHA-256, SHA-256 of the SHA-256 digest, with raw byte parents
+struct SHA256dPolicy {
+    static constexpr size_t digestSize = 32;
+
+    static inline void leaf(const uint8_t* data, size_t len, uint8_t* out) {
+        uint8_t inner[32];
+        SHA256Parts::hash({{data, len}}, inner);
+        SHA256Parts::hash({{inner, 32}}, out);
+    }
+    static inline void node(const uint8_t* left, const uint8_t* right, uint8_t* out) {
+        uint8_t inner[32];
+        SHA256Pair::active(HashMode::Binary)(left, right, inner);
+        SHA256Parts::hash({{inner, 32}}, out);
+    }
+    static inline void alone(const uint8_t* child, uint8_t* out) {
+        leaf(child, 32, out);
+    }
+};
+
+// domain separated SHA-256 with RFC 6962 style leaf/node tags: leaves hash 0x00 || data, parents
+// hash 0x01 || children, so a leaf can never be passed off as a parent. The tree shape is still
+// MerkleTree's, a lone node hashes 0x01 || child, so roots match RFC 6962 only for powers of two.
+struct SHA256DomainPolicy {
+    static constexpr size_t digestSize = 32;
+    static constexpr uint8_t leafTag = 0x00;
+    static constexpr uint8_t nodeTag = 0x01;
+
+    static inline void leaf(const uint8_t* data, size_t len, uint8_t* out) {
+        SHA256Parts::hash({{&leafTag, 1}, {data, len}}, out);
+    }
+    static inline void node(const uint8_t* left, const uint8_t* right, uint8_t* out) {
+        SHA256Parts::hash({{&nodeTag, 1}, {left, 32}, {right, 32}}, out);
+    }
+    static inline void alone(const uint8_t* child, uint8_t* out) {
+        SHA256Parts::hash({{&nodeTag, 1}, {child, 32}}, out);
+    }
+};
+
+// SHA-256 truncated to its first bytes bytes, parents hash the truncated children
+template <size_t bytes>
+struct SHA256TruncatedPolicy {
+    static_assert(bytes > 0 && bytes <= 32, "a truncated SHA-256 digest holds 1 to 32 bytes");
+    static constexpr size_t digestSize = bytes;
+
+    static inline void leaf(const uint8_t* data, size_t len, uint8_t* out) {
+        uint8_t full[32];
+        SHA256Parts::hash({{data, len}}, full);
+        std::memcpy(out, full, bytes);
+    }
+    static inline void node(const uint8_t* left, const uint8_t* right, uint8_t* out) {
+        uint8_t full[32];
+        SHA256Parts::hash({{left, bytes}, {right, bytes}}, full);
+        std::memcpy(out, full, bytes);
+    }
+    static inline void alone(const uint8_t* child, uint8_t* out) {
+        leaf(child, bytes, out);
+    }
+};
@@ -1,28 +1,111 @@
 #pragma once
 
-// tree node 
+// how parent hashes are formed from their children
+enum class HashMode {
+
+    // parents hash the 64 char hex text of their children (original scheme, reproduces existing roots)
+    Hex,
+
+    // parents hash the raw 32 byte digests of their children, hex only appears at the API boundary
+    Binary
+};
+
+// tree node
 typedef struct node{
-            
-    // hash data
+
+    // hash data as hex, only set in HashMode::Hex
     string hash;
 
+    // raw hash data
+    Digest digest;
+
     // relative nodes in tree
     struct node* ancestors[2];
 }TreeNode;
 
+class FlatTree;
+class HashCache;
+
 class MerkleTree{
 
     public:
-        MerkleTree();   
+        MerkleTree(HashMode mode = HashMode::Hex);
 
         // hash function
         SHA256 sha256;
 
+        // parent hashing scheme
+        HashMode mode;
+
+        // statistics of the last build, only filled in when built with MERKLE_STATS. They are kept
+        // here rather than returned, since the builds already return the tree
+        BuildStats stats;
+
+        // optional cache of leaf digests and parents, owned by the caller, nullptr hashes everything
+        HashCache* cache;
+
         // merkle -tree funcs
-        vector<string> hashStrings(vector<string> input);
-        string computeRootHash(vector<string> input);
+        vector<string> hashStrings(const vector<string>& input);
+        void hashStrings(std::span<const std::string_view> input, char* hex);
+        vector<Digest> hashLeaves(const vector<string>& input);
+        void hashLeaves(const vector<string>& input, Digest* digests);
+        void hashLeaves(const string* input, size_t count, Digest* digests);
+        void hashLeaves(std::span<const std::string_view> input, Digest* digests);
+        void hashMessages(const BatchMessage* msgs, size_t count, Digest* digests);
+        void hashLeavesCached(const BatchMessage* msgs, size_t count, Digest* digests);
+        void hashLevel(const Digest* nodes, size_t count, Digest* parents);
+        void hashLevels(FlatTree& tree, size_t firstLevel);
+        string computeRootHash(const vector<string>& input);
         TreeNode* newTreeNode(TreeNode* inputHash1, TreeNode* inputHash2);
-        TreeNode* assembleTree(vector<string> input);
+        TreeNode* assembleTree(const vector<string>& input);
+        TreeNode* assembleTree(std::span<const std::string_view> input);
+        FlatTree buildTree(const vector<string>& input);
+        FlatTree buildTree(std::span<const std::string_view> input);
+        FlatTree buildTree(const vector<string>& input, ThreadPool& pool, size_t subtreeLeaves = 0);
+        FlatTree buildTree(std::span<const std::string_view> input, ThreadPool& pool, size_t subtreeLeaves = 0);
+        FlatTree buildTree(const Digest* leaves, size_t count);
+        FlatTree buildTree(std::span<const BatchMessage> chunks);
         void freeTree(TreeNode** root);
 
-};
\ No newline at end of file
+        // leaves read in place from any range of strings, string_views or BatchMessages, hashed in
+        // blocks of leafBlock messages on the stack, so no memory is allocated per leaf
+        template <class It> void hashLeaves(It first, It last, Digest* digests);
+        template <class It> FlatTree buildTree(It first, It last);
+        static constexpr size_t leafBlock = 256;
+
+        // incremental updates of a built tree, only the paths above the changed leaves are rehashed
+        void updateLeaf(FlatTree& tree, size_t index, const string& data);
+        void updateLeaves(FlatTree& tree, const vector<std::pair<size_t, string>>& updates, ThreadPool* pool = nullptr);
+        void appendLeaves(FlatTree& tree, const vector<string>& input, ThreadPool* pool = nullptr);
+        void truncateLeaves(FlatTree& tree, size_t leafCount);
+        void rehashPaths(FlatTree& tree, vector<size_t> dirty, ThreadPool* pool = nullptr);
+        void rehashParents(FlatTree& tree, size_t level, const size_t* parents, size_t count);
+
+    private:
+
+        // the bytes of one record
+        static BatchMessage leafMessage(std::string_view record) { return {reinterpret_cast<const uint8_t*>(record.data()), record.size()}; }
+        static BatchMessage leafMessage(const BatchMessage& record) { return record; }
+
+        // parallel build, hashLeaves(begin, end, digests) hashes one range of leaves
+        FlatTree buildParallel(size_t n, ThreadPool& pool, size_t subtreeLeaves, const std::function<void(size_t, size_t, Digest*)>& hashLeaves);
+};
+
+/**
+ * @note hashLeaves() hashes a range of records in place. Records are gathered into a block of
+ * leafBlock BatchMessages on the stack, and each block is hashed as one batch.
+ * @param first, last are the records, anything viewable as a string_view, or BatchMessages
+ * @param digests is the output array of one digest per record
+*/
+template <class It>
+void MerkleTree::hashLeaves(It first, It last, Digest* digests){
+    BatchMessage block[leafBlock];
+    while (first != last){
+        size_t count = 0;
+        for (; count < leafBlock && first != last; ++first, ++count){
+            block[count] = leafMessage(*first);
+        }
+        hashMessages(block, count, digests);
+        digests += count;
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+// MerkleAccumulator.hpp
+
+class MerkleAccumulator {
+    /**
+     * @notice MerkleAccumulator computes the root of an append only sequence of leaves without keeping
+     * the leaves. It stores only the frontier: the root of one perfect subtree for every set bit of
+     * the leaf count, at most 64 digests. Appending a leaf works like incrementing a binary counter.
+     * Equal height subtrees merge into their parent, and the carry stops at the first empty height.
+     *
+     * root() folds the frontier right to left with the tree's odd node rule. A partial subtree that
+     * ends a level without a sibling is hashed alone. The root therefore matches
+     * MerkleTree::buildTree() and assembleTree() for the same prefix of leaves.
+     *
+     * checkpoint() serializes the frontier to a small blob and restore() resumes from it:
+     *
+     *   magic "MACC" | version (1 byte) | hash mode (1 byte) | 2 reserved bytes |
+     *   leaf count (8 bytes, little endian) | one 32 byte digest per set bit, lowest height first
+    */
+
+    public:
+        MerkleAccumulator(HashMode mode = HashMode::Hex);
+
+        // appending leaves
+        void append(const uint8_t* data, size_t len);
+        void append(const string& data);
+        void append(const vector<string>& input);
+        void appendDigest(const Digest& leaf);
+        void appendSubtree(const Digest& root, size_t height);
+
+        // state
+        uint64_t leafCount() const { return count; }
+        HashMode hashMode() const { return mode; }
+        Digest root();
+        string rootHex();
+
+        // checkpoints, restore() throws std::runtime_error on a malformed blob
+        vector<uint8_t> checkpoint() const;
+        static MerkleAccumulator restore(const vector<uint8_t>& blob);
+
+    private:
+        SHA256 sha256;
+        HashMode mode;
+        uint64_t count;
+
+        // frontier[h] is the root of a perfect subtree of 2^h leaves, valid when bit h of count is set
+        array<Digest, 64> frontier;
+
+        Digest nodeHash(const Digest& left, const Digest* right);
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+// MerkleDiff.hpp
+
+// result of comparing two trees
+typedef struct diffResult{
+
+    // half open [begin, end) ranges of leaf positions that differ, sorted and merged. Leaves present
+    // in only one of the trees count as differing.
+    vector<std::pair<size_t, size_t>> ranges;
+
+    // number of differing leaves, the total length of the ranges
+    size_t differingLeaves;
+
+    // node pairs compared, and equal subtrees skipped without descending
+    size_t nodesVisited;
+    size_t subtreesPruned;
+}DiffResult;
+
+class MerkleDiff {
+    /**
+     * @notice MerkleDiff locates the leaves where two trees differ. It descends from the roots level by
+     * level and keeps only node pairs whose hashes differ. A subtree whose hash matches in both trees
+     * is skipped with all its leaves. Comparing two trees with k differing leaves visits
+     * O(k log n) nodes instead of n.
+     *
+     * Trees of different leaf counts are compared over their common prefix. The extra leaves of the
+     * longer tree are reported as one range. Right edge nodes that cover different leaf ranges in the
+     * two trees are never treated as equal. Both trees must use the same HashMode for equal subtrees
+     * to be pruned.
+    */
+
+    public:
+        static DiffResult diff(const FlatTree& a, const FlatTree& b, ThreadPool* pool = nullptr);
+};
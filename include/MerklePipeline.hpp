@@ -0,0 +1,97 @@
+#pragma once
+
+// MerklePipeline.hpp
+
+class MerklePipeline {
+    /**
+     * @notice MerklePipeline builds the root of a record stream while it is still being read. Three
+     * stages run at the same time, connected by BoundedQueues:
+     *
+     *   reader --batches--> leaf hashers --subtree roots--> combiner
+     *
+     * The reader fills batches of about batchBytes with whole records (RecordFormat framing, as in
+     * RecordFile) and numbers them by their first leaf. Each hasher takes a batch, hashes its leaves
+     * in one SHA256Batch batch, and reduces them to the roots of the largest aligned perfect
+     * subtrees the batch covers. The combiner appends those roots in leaf order to a
+     * MerkleAccumulator, so two subtrees are merged as soon as the second one is done, and the root
+     * is ready as soon as the last batch is. The root is the same as MerkleTree::buildTree() over
+     * the same records.
+     *
+     * The queues hold at most queueDepth batches each. A reader that outruns the hashers blocks
+     * on a full queue, and so do hashers that outrun the combiner, so memory stays bounded by
+     * about (2 * queueDepth + numHashers) * batchBytes. With enough hashers the wall time is close
+     * to max(read time, hash time) rather than their sum.
+     *
+     * start() returns a future of the root, and onComplete, when set, is called from the combiner
+     * thread with the root and leaf count before the future is ready. A malformed stream or an
+     * empty one sets a std::runtime_error on the future. An exception in a hasher or the combiner
+     * is set on the future too: the reader stops, and the later stages drain what is already
+     * queued so no stage is left blocked. One pipeline runs one stream at a time.
+    */
+
+    public:
+        MerklePipeline(HashMode mode = HashMode::Hex, size_t numHashers = 0);
+        MerklePipeline(const MerklePipeline&) = delete;
+        MerklePipeline& operator=(const MerklePipeline&) = delete;
+        ~MerklePipeline();
+
+        // parent hashing scheme
+        HashMode mode;
+
+        // target bytes per batch, and batches each queue holds
+        size_t batchBytes;
+        size_t queueDepth;
+
+        // optional completion callback, called with the root and the number of leaves
+        std::function<void(const Digest&, uint64_t)> onComplete;
+
+        // starts hashing a stream, which must outlive the run, or a file the pipeline opens
+        std::future<Digest> start(std::istream& in, RecordFormat format);
+        std::future<Digest> start(const string& path, RecordFormat format);
+
+        // blocks until the current run has finished
+        void wait();
+
+        // leaves hashed by the last finished run
+        uint64_t leafCount() const { return leaves; }
+        size_t hasherCount() const { return numHashers; }
+
+    private:
+
+        // records read by the reader, viewing into bytes
+        struct Batch {
+            uint64_t firstLeaf;
+            string bytes;
+            vector<BatchMessage> records;
+        };
+
+        // a batch reduced to the roots of its aligned perfect subtrees, left to right
+        struct Subtrees {
+            uint64_t firstLeaf;
+            uint64_t leafCount;
+            vector<std::pair<Digest, uint8_t>> roots;
+        };
+
+        size_t numHashers;
+        uint64_t leaves;
+
+        // the current run
+        std::unique_ptr<std::ifstream> file;
+        std::unique_ptr<BoundedQueue<std::unique_ptr<Batch>>> batches;
+        std::unique_ptr<BoundedQueue<std::unique_ptr<Subtrees>>> results;
+        std::atomic<size_t> activeHashers;
+        std::exception_ptr readError;
+
+        // first exception of a hasher, the reader stops once one is set, as it does on a combiner error
+        std::mutex errorLock;
+        std::exception_ptr hashError;
+        std::atomic<bool> failed;
+
+        vector<std::thread> threads;
+
+        void readStage(std::istream& in, RecordFormat format);
+        void hashStage();
+        void combineStage(std::promise<Digest> promise);
+        static size_t splitRecords(Batch& batch, RecordFormat format, bool last);
+        static void reduce(const Batch& batch, MerkleTree& tree, Subtrees& out, vector<Digest>& leafDigests, vector<Digest>& scratch);
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+// MerkleProof.hpp
+
+// one step of an audit path, from the leaf towards the root
+typedef struct proofStep{
+
+    // hash of the sibling node, unused when the node is alone
+    Digest sibling;
+
+    // the sibling is the left child, so the proven node is on the right
+    bool siblingOnLeft;
+
+    // the node was the last on its level without a sibling and was hashed alone
+    bool alone;
+}ProofStep;
+
+// inclusion proof for a single leaf
+typedef struct auditPath{
+
+    // position of the leaf and number of leaves in the tree
+    size_t leafIndex;
+    size_t leafCount;
+
+    // one step per level below the root
+    vector<ProofStep> steps;
+}AuditPath;
+
+// inclusion proof for a set of leaves, with shared siblings removed
+typedef struct multiProof{
+
+    // number of leaves in the tree
+    size_t leafCount;
+
+    // proven leaf positions, sorted and unique
+    vector<size_t> leafIndices;
+
+    // sibling hashes not derivable from the proven leaves, in the order the verifier consumes them:
+    // level by level from the leaves up, left to right within a level
+    vector<Digest> siblings;
+}MultiProof;
+
+class MerkleProof {
+    /**
+     * @notice MerkleProof generates and checks inclusion proofs against a FlatTree. An audit path
+     * lists, for every level below the root, the hash of the proven node's sibling and which side
+     * it is on. It follows the tree's odd node rule, so a node hashed alone contributes a step
+     * flagged as alone with no sibling. A multiproof covers several leaves at once and ships every
+     * sibling at most once. Siblings that can be computed from other proven leaves are left out.
+     *
+     * The verifier checks the flags against the leaf index and leaf count, so a valid path cannot
+     * be replayed for another position. A MerkleProof keeps one SHA256 context and reuses it for
+     * every hash it computes. verifyBatch() gives each worker its own MerkleProof. Proofs are served
+     * from a FlatTree in memory or directly from a mapped TreeFile.
+    */
+
+    public:
+        MerkleProof(HashMode mode = HashMode::Hex);
+
+        // hashing context, reused across proofs
+        SHA256 sha256;
+
+        // parent hashing scheme, must match the tree
+        HashMode mode;
+
+        // hashing
+        Digest leafHash(const uint8_t* data, size_t len);
+        Digest leafHash(const string& data);
+        Digest nodeHash(const Digest& left, const Digest* right);
+
+        // single leaf proofs
+        AuditPath prove(const FlatTree& tree, size_t leafIndex);
+        AuditPath prove(const TreeFile& tree, size_t leafIndex);
+        bool computeRoot(const Digest& leaf, const AuditPath& path, Digest& root);
+        bool computeRoot(const Digest& leaf, size_t leafIndex, size_t leafCount, std::span<const Digest> siblings, Digest& root);
+        bool verify(const Digest& leaf, const AuditPath& path, const Digest& root);
+        bool verify(const string& leafData, const AuditPath& path, const Digest& root);
+
+        // multiproofs
+        MultiProof proveMany(const FlatTree& tree, vector<size_t> leafIndices);
+        MultiProof proveMany(const TreeFile& tree, vector<size_t> leafIndices);
+        bool computeRoot(const vector<Digest>& leaves, const MultiProof& proof, Digest& root);
+        bool computeRoot(std::span<const Digest> leaves, size_t leafCount, std::span<const size_t> leafIndices,
+                         std::span<const Digest> siblings, Digest& root);
+        bool verifyMany(const vector<Digest>& leaves, const MultiProof& proof, const Digest& root);
+
+        // parallel verification of many single leaf proofs against one root
+        vector<uint8_t> verifyBatch(const vector<Digest>& leaves, const vector<AuditPath>& paths,
+                                    const Digest& root, ThreadPool& pool);
+};
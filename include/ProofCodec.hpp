@@ -0,0 +1,97 @@
+#pragma once
+
+// ProofCodec.hpp
+
+// what an encoded message holds
+enum class WireKind : uint8_t {
+    AuditPath = 1,
+    MultiProof = 2,
+    Subtree = 3
+};
+
+// a decoded audit path, siblings point into the receive buffer
+typedef struct auditPathView{
+    uint64_t leafIndex;
+    uint64_t leafCount;
+
+    // siblings of the steps that have one, from the leaf up
+    std::span<const Digest> siblings;
+}AuditPathView;
+
+// a decoded multiproof, indices are decoded into a vector the caller can reuse
+typedef struct multiProofView{
+    uint64_t leafCount;
+    vector<size_t> leafIndices;
+    std::span<const Digest> siblings;
+}MultiProofView;
+
+// a decoded subtree snapshot, levels point into the receive buffer
+typedef struct subtreeView{
+    HashMode mode;
+
+    // leaves of the whole tree, and the subtree root's level and index in it
+    uint64_t leafCount;
+    uint64_t level;
+    uint64_t index;
+
+    // the nodes under the root on levels 0..level, levels[level] holds only the root
+    array<std::span<const Digest>, 64> levels;
+}SubtreeView;
+
+class ProofCodec {
+    /**
+     * @notice ProofCodec encodes proofs and subtrees into a compact, versioned binary format and
+     * decodes them without copying. Every message starts with a small header:
+     *
+     *   version        1 byte, currently 1
+     *   kind           1 byte, WireKind
+     *   body length    varint
+     *   body
+     *
+     * Integers are unsigned LEB128 varints in their shortest form, and digests are raw 32 bytes.
+     * Bodies:
+     *
+     *   AuditPath    leafIndex | leafCount | sibling count | siblings
+     *   MultiProof   leafCount | index count | first index, then gaps to each next index | sibling count | siblings
+     *   Subtree      hash mode (1 byte) | leafCount | level | index | the nodes under the root, level 0 first
+     *
+     * An audit path carries only the siblings. Which side they are on and which nodes are hashed
+     * alone follow from the leaf index and leaf count, as in MerkleProof::computeRoot(). The node
+     * counts of a subtree follow from its position, so they are not sent either.
+     *
+     * Decoders check the header, that every length stays inside the buffer and the body, that
+     * varints are canonical, and that the counts match the tree shape. A malformed message throws
+     * std::runtime_error. Decoded digests are spans into the buffer, which must outlive the view.
+     * Messages can be sent back to back, and decode() returns the bytes it consumed.
+    */
+
+    public:
+
+        // current format version
+        static constexpr uint8_t version = 1;
+
+        // appends one encoded message to out
+        static void encode(const AuditPath& path, vector<uint8_t>& out);
+        static void encode(const MultiProof& proof, vector<uint8_t>& out);
+        static void encodeSubtree(const FlatTree& tree, size_t level, size_t index, vector<uint8_t>& out);
+
+        // decodes the message at the start of bytes, returns its size
+        static size_t decode(std::span<const uint8_t> bytes, AuditPathView& path);
+        static size_t decode(std::span<const uint8_t> bytes, MultiProofView& proof);
+        static size_t decode(std::span<const uint8_t> bytes, SubtreeView& subtree);
+
+        // kind of the message at the start of bytes, to pick a decoder
+        static WireKind peekKind(std::span<const uint8_t> bytes);
+
+        // rehashes a decoded subtree, false if a node does not match its children
+        static bool checkSubtree(const SubtreeView& subtree);
+
+        // copies a view into the owning proof types
+        static AuditPath toAuditPath(const AuditPathView& path);
+        static MultiProof toMultiProof(const MultiProofView& proof);
+
+        // varints, getVarint() returns the bytes read, 0 if truncated, too long or not canonical
+        static size_t putVarint(uint64_t value, uint8_t* out);
+        static size_t getVarint(const uint8_t* in, size_t len, uint64_t& value);
+        static size_t varintSize(uint64_t value) { return (std::bit_width(value | 1) + 6) / 7; }
+};
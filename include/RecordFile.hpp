@@ -0,0 +1,49 @@
+#pragma once
+
+// RecordFile.hpp
+
+// how records are framed in a record file
+enum class RecordFormat {
+
+    // one record per line, separated by '\n', a final newline is optional
+    Lines,
+
+    // each record follows its length as a 4 byte little endian integer
+    LengthPrefixed
+};
+
+class RecordFile {
+    /**
+     * @notice RecordFile maps a file of records read-only and indexes where each record starts and
+     * ends. The records are string_views into the mapping, so MerkleTree can hash them in place:
+     *
+     *   RecordFile file("records.txt", RecordFormat::Lines);
+     *   FlatTree tree = merkelTree.buildTree(file.records());
+     *
+     * Opening a file reads it once to find the record boundaries, and the only allocation is the
+     * index of one string_view per record. The views are valid while the RecordFile lives.
+    */
+
+    public:
+        RecordFile(const string& path, RecordFormat format);
+        RecordFile(const RecordFile&) = delete;
+        RecordFile& operator=(const RecordFile&) = delete;
+        RecordFile(RecordFile&& other) noexcept;
+        ~RecordFile();
+
+        // writes records in the given framing, throws std::runtime_error on I/O failure or on a
+        // record the framing cannot hold
+        static void write(std::span<const std::string_view> records, const string& path, RecordFormat format);
+
+        // the records, in file order
+        std::span<const std::string_view> records() const { return index; }
+        size_t size() const { return index.size(); }
+        const std::string_view& operator[](size_t i) const { return index[i]; }
+        RecordFormat format() const { return framing; }
+
+    private:
+        const uint8_t* base;
+        size_t mappedSize;
+        RecordFormat framing;
+        vector<std::string_view> index;
+};
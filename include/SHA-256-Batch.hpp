@@ -0,0 +1,70 @@
+#pragma once
+
+// SHA-256-Batch.hpp
+
+// one independent message of a batch
+typedef struct batchMessage{
+
+    // bytes of the message
+    const uint8_t* data;
+
+    // length of the message in bytes
+    size_t len;
+}BatchMessage;
+
+// batch hash function: writes count 32 byte digests back to back into digests
+typedef void (*BatchFunc)(const BatchMessage* msgs, size_t count, uint8_t* digests);
+
+// named batch backend
+typedef struct batchBackend{
+
+    // name used for selection, e.g. through the SHA256_BATCH_BACKEND environment variable
+    const char* name;
+
+    // number of messages hashed side by side
+    size_t lanes;
+
+    // batch hash function implementing this backend
+    BatchFunc hash;
+}BatchBackend;
+
+class SHA256Batch {
+    /**
+     * @notice SHA256Batch hashes many independent messages at once. The AVX2 and AVX-512 backends
+     * interleave 8 or 16 messages across the lanes of a vector register so each instruction
+     * advances every message by one step. When a lane reaches the end of its message, the lane is
+     * refilled with the next message in the batch. A lane with nothing left to hash keeps running
+     * on a dummy block and its result is discarded. The serial backend hashes one message after
+     * another with the active SHA256Compress backend. It is used when no vector backend is
+     * available, or when SHA256Compress has hardware SHA instructions, which beat the vector lanes.
+     *
+     * SHA256_BATCH_BACKEND=serial|avx2|avx512 forces a backend, as SHA256_BACKEND does for
+     * SHA256Compress.
+    */
+
+    public:
+
+        // hash a batch with the selected backend
+        static void hash(const BatchMessage* msgs, size_t count, uint8_t* digests);
+
+        // currently selected backend
+        static const BatchBackend& active();
+
+        // backends usable on this CPU, the serial backend first
+        static vector<BatchBackend> available();
+
+        // force a backend by name, returns false if it is unknown or unsupported on this CPU
+        static bool select(const string& name);
+
+        // backends
+        static void hashSerial(const BatchMessage* msgs, size_t count, uint8_t* digests);
+        static void hashAVX2(const BatchMessage* msgs, size_t count, uint8_t* digests);
+        static void hashAVX512(const BatchMessage* msgs, size_t count, uint8_t* digests);
+
+        // cpu feature detection
+        static bool hasAVX2();
+        static bool hasAVX512();
+
+    private:
+        static const BatchBackend* detect();
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+// SHA-256-Compress.hpp
+
+// compression function: folds numBlocks consecutive 64 byte message blocks into the 8 word state
+typedef void (*CompressFunc)(uint32_t* state, const uint8_t* blocks, size_t numBlocks);
+
+// named compression backend
+typedef struct compressBackend{
+
+    // name used for selection, e.g. through the SHA256_BACKEND environment variable
+    const char* name;
+
+    // compression function implementing this backend
+    CompressFunc compress;
+}CompressBackend;
+
+class SHA256Compress {
+    /**
+     * @notice SHA256Compress owns the SHA-256 compression backends and the choice between them.
+     * The backend is picked once, on first use, from what the CPU supports: x86 SHA-NI, ARMv8 SHA2
+     * instructions, or an unrolled scalar implementation that runs anywhere. Setting the
+     * SHA256_BACKEND environment variable to a backend name forces that backend, which is how the
+     * tests exercise each of them.
+    */
+
+    public:
+
+        // currently selected backend
+        static const CompressBackend& active();
+
+        // backends usable on this CPU, the portable scalar backend first
+        static vector<CompressBackend> available();
+
+        // force a backend by name, returns false if it is unknown or unsupported on this CPU
+        static bool select(const string& name);
+
+        // backends
+        static void compressScalar(uint32_t* state, const uint8_t* blocks, size_t numBlocks);
+        static void compressSHANI(uint32_t* state, const uint8_t* blocks, size_t numBlocks);
+        static void compressARMv8(uint32_t* state, const uint8_t* blocks, size_t numBlocks);
+
+        // cpu feature detection
+        static bool hasSHANI();
+        static bool hasARMv8SHA2();
+
+    private:
+        static const CompressBackend* detect();
+};
@@ -0,0 +1,162 @@
+#pragma once
+
+// SHA-256-Constexpr.hpp
+
+class SHA256Const {
+    /**
+     * @notice SHA256Const is a SHA-256 that runs in constant expressions. Digests of fixed inputs
+     * (the empty string, domain tags, digests embedded in a schema, zero subtree tables) can then be
+     * computed by the compiler and checked with static_assert. Nothing is left for startup.
+     *
+     * It is a plain scalar implementation over the same round constants as SHA256::k and gives the
+     * same digests as SHA256. Its round functions are the ones the runtime kernels use too. It also
+     * works at runtime, but SHA256 with its hardware backends is much faster there.
+    */
+
+    public:
+
+        // initial hash values, the first 32 bits of the fractional parts of the square roots of the first 8 primes
+        static constexpr array<uint32_t, 8> iv {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+        };
+
+        // round functions, shared with the runtime kernels in SHA-256-Kernel.hpp
+        static constexpr uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+        static constexpr uint32_t choice(uint32_t x, uint32_t y, uint32_t z) { return z ^ (x & (y ^ z)); }
+        static constexpr uint32_t majority(uint32_t x, uint32_t y, uint32_t z) { return (x & y) | (z & (x | y)); }
+        static constexpr uint32_t bigSigma0(uint32_t x) { return rotr(x, 2) ^ rotr(x, 13) ^ rotr(x, 22); }
+        static constexpr uint32_t bigSigma1(uint32_t x) { return rotr(x, 6) ^ rotr(x, 11) ^ rotr(x, 25); }
+        static constexpr uint32_t smallSigma0(uint32_t x) { return rotr(x, 7) ^ rotr(x, 18) ^ (x >> 3); }
+        static constexpr uint32_t smallSigma1(uint32_t x) { return rotr(x, 17) ^ rotr(x, 19) ^ (x >> 10); }
+
+        /**
+         * @note expandSchedule() fills in words 16 to 63 of a message schedule
+         * @param w is a 64 word schedule whose first 16 words are the message block
+        */
+        static constexpr void expandSchedule(uint32_t* w) {
+            for (int i = 16; i < 64; i++) {
+                w[i] = w[i-16] + smallSigma0(w[i-15]) + w[i-7] + smallSigma1(w[i-2]);
+            }
+        }
+
+        /**
+         * @note compress() runs the 64 rounds over one 64 byte block
+         * @param state is the 8 word hash state to update
+         * @param block is the message block
+        */
+        static constexpr void compress(array<uint32_t, 8>& state, const array<uint8_t, 64>& block) {
+            uint32_t w[64] = {};
+            for (int i = 0; i < 16; i++) {
+                w[i] = (uint32_t(block[4*i]) << 24) | (uint32_t(block[4*i + 1]) << 16) |
+                       (uint32_t(block[4*i + 2]) << 8) | uint32_t(block[4*i + 3]);
+            }
+            expandSchedule(w);
+
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+            uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+            for (int i = 0; i < 64; i++) {
+                uint32_t t1 = h + bigSigma1(e) + choice(e, f, g) + SHA256::k[i] + w[i];
+                uint32_t t2 = bigSigma0(a) + majority(a, b, c);
+                h = g; g = f; f = e; e = d + t1;
+                d = c; c = b; b = a; a = t1 + t2;
+            }
+
+            state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+            state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        }
+
+        /**
+         * @note hash() pads and hashes a whole message. The bytes can be given as any integral type,
+         * so string literals work without a reinterpret_cast.
+         * @param data is a ptr to the message
+         * @param len is the message length in bytes
+        */
+        template <typename T>
+        static constexpr Digest hash(const T* data, size_t len) {
+            array<uint32_t, 8> state = iv;
+            array<uint8_t, 64> block = {};
+
+            size_t offset = 0;
+            for (; offset + 64 <= len; offset += 64) {
+                for (size_t i = 0; i < 64; i++) {
+                    block[i] = uint8_t(data[offset + i]);
+                }
+                compress(state, block);
+            }
+
+            // tail, the '1' bit, and the 64-bit big endian bit length, in one or two blocks
+            size_t tail = len - offset;
+            block = {};
+            for (size_t i = 0; i < tail; i++) {
+                block[i] = uint8_t(data[offset + i]);
+            }
+            block[tail] = 0x80;
+            if (tail >= 56) {
+                compress(state, block);
+                block = {};
+            }
+            uint64_t bitLen = uint64_t(len) * 8;
+            for (int i = 0; i < 8; i++) {
+                block[63 - i] = uint8_t(bitLen >> (8 * i));
+            }
+            compress(state, block);
+
+            Digest digest = {};
+            for (int i = 0; i < 8; i++) {
+                digest[4*i]     = uint8_t(state[i] >> 24);
+                digest[4*i + 1] = uint8_t(state[i] >> 16);
+                digest[4*i + 2] = uint8_t(state[i] >> 8);
+                digest[4*i + 3] = uint8_t(state[i]);
+            }
+            return digest;
+        }
+
+        static constexpr Digest hash(std::string_view text) {
+            return hash(text.data(), text.size());
+        }
+
+        /**
+         * @note nodeHash() hashes a parent from its children the way MerkleTree does: the 64 char
+         * lowercase hex text of each child when hexText is set, the raw 32 bytes otherwise
+         * @param right is nullptr for a node hashed alone
+        */
+        static constexpr Digest nodeHash(const Digest& left, const Digest* right, bool hexText) {
+            array<uint8_t, 128> pair = {};
+            size_t len = 0;
+            const Digest* children[2] = {&left, right};
+            for (const Digest* child : children) {
+                if (child == nullptr) { continue; }
+                for (size_t i = 0; i < 32; i++) {
+                    if (hexText) {
+                        pair[len++] = uint8_t("0123456789abcdef"[(*child)[i] >> 4]);
+                        pair[len++] = uint8_t("0123456789abcdef"[(*child)[i] & 0xf]);
+                    }
+                    else {
+                        pair[len++] = (*child)[i];
+                    }
+                }
+            }
+            return hash(pair.data(), len);
+        }
+
+        /**
+         * @note fromHex() parses a 64 char hex digest, so known digests can be written as literals
+        */
+        static constexpr Digest fromHex(std::string_view hex) {
+            auto nibble = [](char c) -> uint8_t {
+                if (c >= '0' && c <= '9') { return uint8_t(c - '0'); }
+                if (c >= 'a' && c <= 'f') { return uint8_t(c - 'a' + 10); }
+                if (c >= 'A' && c <= 'F') { return uint8_t(c - 'A' + 10); }
+                throw std::invalid_argument("SHA256Const::fromHex: not a hex digit");
+            };
+            if (hex.size() != 64) {
+                throw std::invalid_argument("SHA256Const::fromHex: a digest is 64 hex chars");
+            }
+
+            Digest digest = {};
+            for (size_t i = 0; i < 32; i++) {
+                digest[i] = uint8_t((nibble(hex[2*i]) << 4) | nibble(hex[2*i + 1]));
+            }
+            return digest;
+        }
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+// SHA-256-Kernel.hpp
+
+// Internal to the compression kernels (SHA-256-Compress.cpp and SHA-256-Pair.cpp), included after
+// lib.hpp. It is not part of lib.hpp because it pulls in the intrinsics headers.
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define SHA256_HAVE_SHANI 1
+#endif
+
+// the ARMv8 kernels are compiled for the SHA2 extension by a target attribute, so a baseline aarch64
+// build has them too and hasARMv8SHA2() decides at run time. GCC declares the SHA2 intrinsics under
+// +crypto, so that is the target it needs to inline them. Clang before 16 only declares them when
+// the whole build targets the extension.
+#if defined(__aarch64__) && (!defined(__clang__) || __clang_major__ >= 16 || defined(__ARM_FEATURE_SHA2))
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#define SHA256_HAVE_ARMV8 1
+#if defined(__clang__)
+#define SHA256_ARMV8_TARGET __attribute__((target("sha2")))
+#else
+#define SHA256_ARMV8_TARGET __attribute__((target("+crypto")))
+#endif
+#endif
+
+// one round over a schedule word that already includes its round constant. instead of shuffling
+// the working variables, callers rotate the argument order
+#define SHA256_ROUND(a, b, c, d, e, f, g, h, kw)                                            \
+    do {                                                                                    \
+        uint32_t t1 = h + SHA256Const::bigSigma1(e) + SHA256Const::choice(e, f, g) + (kw);  \
+        uint32_t t2 = SHA256Const::bigSigma0(a) + SHA256Const::majority(a, b, c);           \
+        d += t1;                                                                            \
+        h = t1 + t2;                                                                        \
+    } while (0)
+
+/**
+ * @note roundsScalar() runs the 64 rounds of one block from its k[i] + w[i] schedule
+*/
+static inline void roundsScalar(uint32_t* state, const uint32_t* kw) {
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+    // rounds, eight per iteration so every variable returns to its own name
+    for (int i = 0; i < 64; i += 8) {
+        SHA256_ROUND(a, b, c, d, e, f, g, h, kw[i + 0]);
+        SHA256_ROUND(h, a, b, c, d, e, f, g, kw[i + 1]);
+        SHA256_ROUND(g, h, a, b, c, d, e, f, kw[i + 2]);
+        SHA256_ROUND(f, g, h, a, b, c, d, e, kw[i + 3]);
+        SHA256_ROUND(e, f, g, h, a, b, c, d, kw[i + 4]);
+        SHA256_ROUND(d, e, f, g, h, a, b, c, kw[i + 5]);
+        SHA256_ROUND(c, d, e, f, g, h, a, b, kw[i + 6]);
+        SHA256_ROUND(b, c, d, e, f, g, h, a, kw[i + 7]);
+    }
+
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+/**
+ * @note blockScalar() expands a schedule whose first 16 words are filled in, adds the round
+ * constants and runs its rounds
+ * @param w is a 64 word schedule, overwritten
+*/
+static inline void blockScalar(uint32_t* state, uint32_t* w) {
+    SHA256Const::expandSchedule(w);
+    for (int i = 0; i < 64; i++) {
+        w[i] += SHA256::k[i];
+    }
+    roundsScalar(state, w);
+}
+
+#if defined(SHA256_HAVE_SHANI)
+
+// the SHA-NI helpers are always inlined into the target("sha") kernels
+#define SHANI_INLINE static inline __attribute__((always_inline, target("sha,sse4.1,ssse3")))
+
+/**
+ * @note loadSHANI() rearranges an ABCDEFGH state into the ABEF / CDGH registers sha256rnds2 works on
+*/
+SHANI_INLINE void loadSHANI(const uint32_t* state, __m128i& state0, __m128i& state1) {
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0]));
+    state1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4]));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+}
+
+/**
+ * @note unloadSHANI() rearranges the ABEF / CDGH registers back to ABCD / EFGH
+*/
+SHANI_INLINE void unloadSHANI(__m128i& state0, __m128i& state1) {
+    __m128i tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+}
+
+/**
+ * @note blockSHANI() runs one block whose 16 big endian words are in msgs[]. Each sha256rnds2
+ * performs two rounds, and sha256msg1/msg2 expand the schedule four words at a time with msgs[]
+ * holding a rolling window of it.
+*/
+SHANI_INLINE void blockSHANI(__m128i& state0, __m128i& state1, __m128i* msgs) {
+
+    __m128i abefSave = state0;
+    __m128i cdghSave = state1;
+
+    // 16 groups of four rounds
+    #pragma GCC unroll 16
+    for (int i = 0; i < 16; i++) {
+        __m128i msg = _mm_add_epi32(msgs[i % 4], _mm_loadu_si128(reinterpret_cast<const __m128i*>(&SHA256::k[4*i])));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        if (i >= 3 && i <= 14) {
+            __m128i t = _mm_alignr_epi8(msgs[i % 4], msgs[(i + 3) % 4], 4);
+            msgs[(i + 1) % 4] = _mm_add_epi32(msgs[(i + 1) % 4], t);
+            msgs[(i + 1) % 4] = _mm_sha256msg2_epu32(msgs[(i + 1) % 4], msgs[i % 4]);
+        }
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        if (i >= 1 && i <= 12) {
+            msgs[(i + 3) % 4] = _mm_sha256msg1_epu32(msgs[(i + 3) % 4], msgs[i % 4]);
+        }
+    }
+
+    state0 = _mm_add_epi32(state0, abefSave);
+    state1 = _mm_add_epi32(state1, cdghSave);
+}
+
+#endif
+
+#if defined(SHA256_HAVE_ARMV8)
+
+// the ARMv8 helpers are always inlined into the SHA2 target kernels
+#define ARMV8_INLINE static inline __attribute__((always_inline)) SHA256_ARMV8_TARGET
+
+/**
+ * @note blockARMv8() runs one block whose 16 words are in msgs[]. sha256h/sha256h2 perform four
+ * rounds on the ABCD/EFGH halves of the state and sha256su0/su1 expand the schedule four words at
+ * a time.
+*/
+ARMV8_INLINE void blockARMv8(uint32x4_t& state0, uint32x4_t& state1, uint32x4_t* msgs) {
+
+    uint32x4_t abcdSave = state0;
+    uint32x4_t efghSave = state1;
+
+    // 16 groups of four rounds, msgs[] holds a rolling window of the schedule
+    for (int i = 0; i < 16; i++) {
+        uint32x4_t wk = vaddq_u32(msgs[i % 4], vld1q_u32(&SHA256::k[4*i]));
+        if (i < 12) {
+            msgs[i % 4] = vsha256su0q_u32(msgs[i % 4], msgs[(i + 1) % 4]);
+        }
+        uint32x4_t abcd = state0;
+        state0 = vsha256hq_u32(state0, state1, wk);
+        state1 = vsha256h2q_u32(state1, abcd, wk);
+        if (i < 12) {
+            msgs[i % 4] = vsha256su1q_u32(msgs[i % 4], msgs[(i + 2) % 4], msgs[(i + 3) % 4]);
+        }
+    }
+
+    state0 = vaddq_u32(state0, abcdSave);
+    state1 = vaddq_u32(state1, efghSave);
+}
+
+#endif
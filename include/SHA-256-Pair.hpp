@@ -0,0 +1,60 @@
+#pragma once
+
+// SHA-256-Pair.hpp
+
+// pair hash function: hashes two 32 byte children into their 32 byte parent
+typedef void (*PairFunc)(const uint8_t* left, const uint8_t* right, uint8_t* parent);
+
+class SHA256Pair {
+    /**
+     * @notice SHA256Pair hashes an internal node from its two children. Every such message is the
+     * same length: 64 raw bytes in HashMode::Binary, or 128 bytes of hex text in HashMode::Hex. So
+     * the message always ends with the same padding block. Its schedule is computed at compile
+     * time with the round constants already added, and its 64 rounds skip the schedule expansion
+     * entirely. The children are loaded straight into the schedule words. In hex mode they are
+     * encoded to text on the fly, so no string, pad or message buffer is built.
+     *
+     * The kernel follows the active SHA256Compress backend (scalar, SHA-NI or ARMv8). A node hashed
+     * alone is not a pair. hashAlone() hashes it as an ordinary one block message.
+    */
+
+    public:
+
+        // hash one parent in the tree's hash mode
+        static void hashPair(const Digest& left, const Digest& right, Digest& parent, HashMode mode);
+        static Digest hashPair(const Digest& left, const Digest& right, HashMode mode);
+
+        // hash the parent of a node without a sibling, from its hex text or raw bytes depending on the mode
+        static void hashAlone(const Digest& node, Digest& parent, HashMode mode);
+        static Digest hashAlone(const Digest& node, HashMode mode);
+
+        // hash numPairs adjacent pairs, parents[i] from nodes[2i] and nodes[2i + 1]
+        static void hashPairs(const Digest* nodes, size_t numPairs, Digest* parents, HashMode mode);
+
+        // kernel for the active compression backend
+        static PairFunc active(HashMode mode);
+
+        // false when only the scalar kernel is available and a vector batch backend hashes a level faster
+        static bool preferred();
+
+        /**
+         * @note paddingSchedule() expands the block that pads a message of messageLen bytes, a
+         * multiple of 64: the '1' bit, zeros and the bit length. Entry i is k[i] + w[i].
+        */
+        static constexpr array<uint32_t, 64> paddingSchedule(size_t messageLen) {
+            array<uint32_t, 64> w = {};
+            w[0] = 0x80000000;
+            w[14] = uint32_t((uint64_t(messageLen) * 8) >> 32);
+            w[15] = uint32_t(uint64_t(messageLen) * 8);
+            SHA256Const::expandSchedule(w.data());
+            for (int i = 0; i < 64; i++) {
+                w[i] += SHA256::k[i];
+            }
+            return w;
+        }
+
+        // backends, instantiated for both hash modes
+        template <HashMode mode> static void pairScalar(const uint8_t* left, const uint8_t* right, uint8_t* parent);
+        template <HashMode mode> static void pairSHANI(const uint8_t* left, const uint8_t* right, uint8_t* parent);
+        template <HashMode mode> static void pairARMv8(const uint8_t* left, const uint8_t* right, uint8_t* parent);
+};
@@ -2,10 +2,15 @@
 
 // SHA-256.hpp
 
+// raw 256-bit digest
+typedef array<uint8_t, 32> Digest;
+
 class SHA256 {
     /**
      * @notice The SHA256 class implements the SHA-256 hashing algorithm. It provides methods for 
-     * loading a a file into the program in binary mode, hashing the file, and returning the hash
+     * loading a a file into the program in binary mode, hashing the file, and returning the hash.
+     * Messages can be hashed in one shot with computeHash() or incrementally with init(), update()
+     * and final(), which only carry a 64 byte partial block between calls.
      * 
      * This implementation is based on the Pseudocode section of this wikipedia page: 
      * https://en.wikipedia.org/wiki/SHA-2#References
@@ -18,10 +23,18 @@ class SHA256 {
         void pad(vector<bool>& bitVec);
         vector<uint32_t> convertToWords(const vector<bool>& bitVec);
 
+        // streaming hash computation
+        void init();
+        void update(const uint8_t* data, size_t len);
+        void final(uint8_t* digest);
+        string hashFile(const string& path);
+
         // hash computation
         void processChunk(const uint32_t* chunk);
         string collectDigest() const;
         string computeHash(vector<bool> bitVec);
+        string computeHash(const uint8_t* data, size_t len);
+        string computeHash(std::span<const std::byte> data);
         
         // bit manipulations for SHA-256 
         uint32_t rightRotate(uint32_t n, uint32_t x);
@@ -34,21 +47,11 @@ class SHA256 {
 
         // helper 
         vector<bool> stringToBinary(const std::string& input);
+        static void loadWords(const uint8_t* block, uint32_t* words);
+        static string toHex(const uint8_t* bytes, size_t len);
+        static void toHex(const uint8_t* bytes, size_t len, char* out);
 
-
-    private:
-
-        // initial hash values: (first 32 bits of the fractional parts of the square roots of the first 8 primes 2..19):
-        uint32_t h0 = 0x6a09e667;
-        uint32_t h1 = 0xbb67ae85;
-        uint32_t h2 = 0x3c6ef372;
-        uint32_t h3 = 0xa54ff53a;
-        uint32_t h4 = 0x510e527f;
-        uint32_t h5 = 0x9b05688c;
-        uint32_t h6 = 0x1f83d9ab;
-        uint32_t h7 = 0x5be0cd19;
-
-        // init array of round constants
+        // init array of round constants, shared with the compression backends
         static constexpr array<uint32_t, 64> k {
             0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
             0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
@@ -59,4 +62,16 @@ class SHA256 {
             0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
             0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
         };
+
+    private:
+
+        // hash values, reset by init() to the first 32 bits of the fractional parts of the square
+        // roots of the first 8 primes 2..19
+        uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                         0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+        // streaming state: the partial 512-bit block and the total message length in bytes
+        uint8_t block[64];
+        size_t blockLen = 0;
+        uint64_t messageLen = 0;
 };
@@ -0,0 +1,96 @@
+#pragma once
+
+// SparseMerkleTree.hpp
+
+// inclusion or exclusion proof for one key
+typedef struct sparseProof{
+
+    // the proven key, and its leaf digest, ZeroHashes::at(mode, 0) when the key is absent
+    Digest key;
+    Digest leaf;
+
+    // bit h set when the sibling at height h is not the empty subtree, stored lowest height first
+    array<uint8_t, 32> nonEmpty;
+
+    // the siblings that are not empty subtrees, from the leaf towards the root
+    vector<Digest> siblings;
+}SparseProof;
+
+class SparseMerkleTree {
+    /**
+     * @notice SparseMerkleTree commits to a map from 256-bit keys to values. It is a perfect binary
+     * tree of depth 256 with one leaf per possible key. The key's bits choose the path from the
+     * root, most significant bit first. A present key's leaf is SHA-256 of its value. An absent
+     * key's leaf is the empty leaf, SHA-256 of no bytes, so a key set to the empty value is absent.
+     * Parents hash their children with SHA256Pair in the tree's hash mode.
+     *
+     * Almost every subtree is empty, and an empty subtree of height h has the root
+     * ZeroHashes::at(mode, h). Only nodes that differ from it are stored, keyed by their height
+     * and key prefix. A key then costs at most 257 nodes, and an update hashes at most 256 parents.
+     * A parent whose children are both empty is taken from the table without hashing.
+     *
+     * Batch updates sort the keys and recompute the dirty parents level by level, so ancestors
+     * shared by several keys are hashed once. Proofs list only the non-empty siblings, with a
+     * bitmap of their heights. They prove membership (the leaf is the hash of the value) or
+     * non-membership (the leaf is empty) against a root.
+    */
+
+    public:
+        SparseMerkleTree(HashMode mode = HashMode::Hex);
+
+        // parent hashing scheme
+        HashMode mode;
+
+        // tree height, the number of bits in a key
+        static constexpr size_t depth = 256;
+
+        // single key updates, erase() of an absent key does nothing
+        void insert(const Digest& key, const string& value);
+        void insertLeaf(const Digest& key, const Digest& leaf);
+        void erase(const Digest& key);
+
+        // batch updates, ancestors shared by several keys are recomputed once
+        void insertMany(const vector<std::pair<Digest, string>>& entries, ThreadPool* pool = nullptr);
+        void eraseMany(const vector<Digest>& keys, ThreadPool* pool = nullptr);
+
+        // queries
+        Digest root() const;
+        bool contains(const Digest& key) const;
+        Digest leaf(const Digest& key) const;
+        size_t size() const { return keyCount; }
+        size_t nodeCount() const { return nodes.size(); }
+
+        // proofs
+        SparseProof prove(const Digest& key) const;
+        static bool computeRoot(const SparseProof& proof, HashMode mode, Digest& root);
+        static bool verifyMember(const SparseProof& proof, const string& value, const Digest& root, HashMode mode);
+        static bool verifyNonMember(const SparseProof& proof, const Digest& root, HashMode mode);
+
+        // leaf digest of a value
+        static Digest leafHash(const string& value);
+
+    private:
+
+        // a stored node: its height and the key bits above it, the lower height bits cleared
+        struct NodeKey {
+            Digest prefix;
+            uint16_t height;
+            bool operator==(const NodeKey& other) const { return height == other.height && prefix == other.prefix; }
+        };
+        struct NodeKeyHash {
+            size_t operator()(const NodeKey& node) const;
+        };
+
+        std::unordered_map<NodeKey, Digest, NodeKeyHash> nodes;
+        size_t keyCount;
+
+        // key bit arithmetic
+        static Digest prefixOf(const Digest& key, size_t height);
+        static bool bitAt(const Digest& key, size_t height);
+        static Digest flipBit(const Digest& key, size_t height);
+
+        Digest nodeAt(size_t height, const Digest& prefix) const;
+        void store(size_t height, const Digest& prefix, const Digest& digest);
+        Digest parentHash(const Digest& left, const Digest& right, size_t childHeight) const;
+        void applyLeaves(vector<std::pair<Digest, Digest>> leaves, ThreadPool* pool);
+};
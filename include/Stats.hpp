@@ -0,0 +1,103 @@
+#pragma once
+
+// Stats.hpp
+
+// snapshot of the global hot path counters
+typedef struct hashCounters{
+
+    // 64 byte blocks run through a compression function, by any backend
+    uint64_t compressions;
+
+    // message bytes absorbed by SHA256 and SHA256Batch
+    uint64_t bytesHashed;
+
+    // bits converted on the vector<bool> path (stringToBinary, computeHash(vector<bool>))
+    uint64_t bitsConverted;
+
+    // TreeNode structs allocated, and bytes allocated for FlatTree buffers
+    uint64_t nodesAllocated;
+    uint64_t bytesAllocated;
+}HashCounters;
+
+// statistics of one tree build
+typedef struct buildStats{
+
+    // counter deltas over the build. Counters are global, so concurrent builds on other threads are included.
+    HashCounters counters;
+
+    // wall time hashing the leaves, hashing each level above them (index l is level l + 1), and in
+    // total. In parallel builds leafNs covers the whole subtree phase, and only the levels above the
+    // subtrees are timed one by one.
+    uint64_t leafNs;
+    vector<uint64_t> levelNs;
+    uint64_t totalNs;
+}BuildStats;
+
+class Stats {
+    /**
+     * @notice Stats holds the instrumentation counters and the trace recorder. They are only fed when
+     * the library is built with -DMERKLE_STATS (make STATS=1). Without the flag, MERKLE_COUNT,
+     * MERKLE_SCOPE and MERKLE_STATS_ONLY expand to nothing, and the hot paths carry no counters,
+     * clock reads or branches.
+     *
+     * Counters are relaxed atomics, incremented once per call rather than per block. Tracing is off
+     * until startTrace(). While it is on, every scope records a complete event ("ph": "X"), and
+     * writeTrace() saves the events as Chrome trace JSON, which Perfetto and chrome://tracing load.
+    */
+
+    public:
+        static HashCounters snapshot();
+        static HashCounters delta(const HashCounters& before);
+        static void reset();
+        static uint64_t now();
+
+        // tracing
+        static void startTrace();
+        static void stopTrace();
+        static void writeTrace(const string& path);
+        static void record(const char* name, int64_t arg, uint64_t startNs, uint64_t durationNs);
+        static bool tracing() { return traceEnabled.load(std::memory_order_relaxed); }
+
+        // live counters, use MERKLE_COUNT
+        struct AtomicCounters {
+            std::atomic<uint64_t> compressions{0};
+            std::atomic<uint64_t> bytesHashed{0};
+            std::atomic<uint64_t> bitsConverted{0};
+            std::atomic<uint64_t> nodesAllocated{0};
+            std::atomic<uint64_t> bytesAllocated{0};
+        };
+        static AtomicCounters counters;
+
+    private:
+        static std::atomic<bool> traceEnabled;
+};
+
+class TraceScope {
+    /**
+     * @notice TraceScope times the enclosing scope. It adds the duration to *elapsed (if given), and
+     * records a trace event while tracing is on. Use it through MERKLE_SCOPE.
+    */
+
+    public:
+        TraceScope(const char* name, uint64_t* elapsed = nullptr, int64_t arg = -1);
+        ~TraceScope();
+
+    private:
+        const char* name;
+        uint64_t* elapsed;
+        int64_t arg;
+        uint64_t start;
+};
+
+#define MERKLE_CONCAT_INNER(a, b) a##b
+#define MERKLE_CONCAT(a, b) MERKLE_CONCAT_INNER(a, b)
+
+#ifdef MERKLE_STATS
+#define MERKLE_COUNT(field, n) Stats::counters.field.fetch_add(uint64_t(n), std::memory_order_relaxed)
+#define MERKLE_SCOPE(...) TraceScope MERKLE_CONCAT(traceScope, __LINE__)(__VA_ARGS__)
+#define MERKLE_STATS_ONLY(...) __VA_ARGS__
+#else
+#define MERKLE_COUNT(field, n) ((void)0)
+#define MERKLE_SCOPE(...) ((void)0)
+#define MERKLE_STATS_ONLY(...)
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+
+// ThreadPool.hpp
+
+class ThreadPool {
+    /**
+     * @notice ThreadPool is a fixed set of worker threads that schedule tasks by work stealing. Each
+     * worker has its own deque: it pushes and pops its own tasks at the back, and an idle worker
+     * steals from the front of another worker's deque. Tasks submitted from outside the pool are
+     * dealt round robin. Tasks submitted from inside a task go to the submitting worker's deque,
+     * so nested work stays local until someone is idle enough to steal it.
+     *
+     * Completion is tracked per TaskGroup. parallelFor() puts its ranges in a group of its own and
+     * waits for that group alone, so it can be called from inside a task and callers sharing the
+     * pool do not wait for each other's work. submit() and wait() without a group use the pool's
+     * default group. The waiting thread runs tasks itself in the meantime, so a pool of one worker
+     * plus the caller uses two cores. An exception thrown by a task is caught on the worker, and the
+     * first one of each group is rethrown by wait() or parallelFor().
+    */
+
+    public:
+        explicit ThreadPool(size_t numThreads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // number of worker threads
+        size_t size() const { return workers.size(); }
+
+        // a set of tasks that is waited for on its own
+        typedef struct taskGroup{
+            std::atomic<size_t> pending{0};
+
+            // first exception thrown by a task of the group
+            std::mutex errorLock;
+            std::exception_ptr error;
+        }TaskGroup;
+
+        // scheduling
+        void submit(std::function<void()> task);
+        void submit(TaskGroup& group, std::function<void()> task);
+        void wait();
+        void wait(TaskGroup& group);
+        void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+    private:
+
+        // a queued task and the group it counts towards
+        typedef struct task{
+            std::function<void()> run;
+            TaskGroup* group;
+        }Task;
+
+        // per worker task deque
+        typedef struct workQueue{
+            std::mutex lock;
+            std::deque<Task> tasks;
+        }WorkQueue;
+
+        vector<std::thread> workers;
+        vector<std::unique_ptr<WorkQueue>> queues;
+
+        // sleeping and shutdown
+        std::mutex sleepLock;
+        std::condition_variable wake;
+        std::condition_variable idle;
+        std::atomic<size_t> queued{0};
+        std::atomic<size_t> nextQueue{0};
+        bool stopping = false;
+
+        // group of submit() and wait() without one
+        TaskGroup defaultGroup;
+
+        void workerLoop(size_t index);
+        bool runOne(size_t home);
+        bool popTask(size_t home, Task& task);
+        void finishTask(TaskGroup& group);
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+// TreeFile.hpp
+
+class TreeFile {
+    /**
+     * @notice TreeFile stores a FlatTree on disk and serves it back through a read-only memory map.
+     * No parsing or rehashing happens at startup. Opening a file reads and checks only the header,
+     * and the pages of a level are faulted in when a query first touches them.
+     *
+     * The format is versioned. All integers are little endian, and every level starts on a 64 byte boundary:
+     *
+     *   0   magic "MKLT"              4 bytes
+     *   4   version                   4 bytes
+     *   8   hash mode                 4 bytes
+     *   12  level count L             4 bytes
+     *   16  leaf count                8 bytes
+     *   24  reserved                  8 bytes
+     *   32  body checksum             32 bytes, SHA-256 of the level data in level order
+     *   64  level offsets             8 bytes each, L entries, byte offset of each level in the file
+     *   ..  header checksum           32 bytes, SHA-256 of everything above
+     *   ..  levels                    levelSize(l) digests of 32 bytes each
+     *
+     * The header checksum is checked on open. The body checksum needs a full read of the file, so it
+     * is only checked by verify().
+    */
+
+    public:
+        explicit TreeFile(const string& path);
+        TreeFile(const TreeFile&) = delete;
+        TreeFile& operator=(const TreeFile&) = delete;
+        TreeFile(TreeFile&& other) noexcept;
+        ~TreeFile();
+
+        // writes a tree, replacing path atomically, throws std::runtime_error on I/O failure
+        static void write(const FlatTree& tree, const string& path);
+
+        // writes a tree streamed level by level, readLevel(level, buffer, capacity) returns the
+        // number of digests it put into buffer
+        typedef std::function<size_t(size_t level, Digest* buffer, size_t capacity)> LevelReader;
+        static void write(const string& path, HashMode mode, size_t leafCount, const LevelReader& readLevel);
+
+        // shape, as in FlatTree
+        size_t leafCount() const { return leaves; }
+        size_t levelCount() const { return sizes.size(); }
+        size_t levelSize(size_t level) const { return sizes[level]; }
+        HashMode hashMode() const { return mode; }
+
+        // node access, pointing into the mapping
+        const Digest* level(size_t level) const { return reinterpret_cast<const Digest*>(base + offsets[level]); }
+        const Digest& node(size_t level, size_t index) const { return this->level(level)[index]; }
+        const Digest& root() const { return node(levelCount() - 1, 0); }
+        string rootHex() const;
+
+        // full integrity check of the level data
+        bool verify() const;
+
+        // copy into memory, e.g. to apply updates
+        FlatTree toFlatTree() const;
+
+        // current format version
+        static constexpr uint32_t version = 1;
+
+        // digests per streamed write
+        static constexpr size_t writeBufferDigests = 8192;
+
+    private:
+        const uint8_t* base;
+        size_t mappedSize;
+        size_t leaves;
+        HashMode mode;
+        Digest bodyChecksum;
+
+        // byte offset of each level in the file and its number of nodes
+        vector<size_t> offsets;
+        vector<size_t> sizes;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+// ZeroHashes.hpp
+
+class ZeroHashes {
+    /**
+     * @notice ZeroHashes holds the roots of empty subtrees, computed at compile time. Height 0 is the
+     * hash of an empty leaf, SHA-256 of no bytes, as MerkleTree hashes the leaf "". Height h + 1
+     * hashes two copies of height h. A perfect tree of 2^h empty leaves therefore has root
+     * at(mode, h). Sparse and padded trees use the table instead of hashing empty subtrees.
+    */
+
+    public:
+        static constexpr size_t maxHeight = 256;
+
+        /**
+         * @note table() computes the empty subtree roots of every height for one hash mode
+        */
+        static constexpr array<Digest, maxHeight + 1> table(HashMode mode) {
+            array<Digest, maxHeight + 1> roots = {};
+            roots[0] = SHA256Const::hash("");
+            for (size_t h = 0; h < maxHeight; h++) {
+                roots[h + 1] = SHA256Const::nodeHash(roots[h], &roots[h], mode == HashMode::Hex);
+            }
+            return roots;
+        }
+
+        static const Digest& at(HashMode mode, size_t height);
+};
@@ -15,6 +15,25 @@
 #include <vector>
 #include <string>
 #include <bitset>
+#include <span>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <exception>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <string_view>
+#include <list>
+#include <unordered_map>
+#include <future>
+#include <map>
 
 // namespace includes
 using std::ifstream;
@@ -28,5 +47,28 @@ using std::cerr;
 using std::endl;
 
 // hpp files
+#include "Stats.hpp"
 #include "SHA-256.hpp"
-#include "MerkelTree.hpp"
\ No newline at end of file
+#include "SHA-256-Constexpr.hpp"
+#include "SHA-256-Compress.hpp"
+#include "SHA-256-Batch.hpp"
+#include "ThreadPool.hpp"
+#include "MerkelTree.hpp"
+#include "SHA-256-Pair.hpp"
+#include "ZeroHashes.hpp"
+#include "HashCache.hpp"
+#include "SparseMerkleTree.hpp"
+#include "FlatTree.hpp"
+#include "HashPolicy.hpp"
+#include "BasicMerkleTree.hpp"
+#include "TreeFile.hpp"
+#include "ExternalBuilder.hpp"
+#include "RecordFile.hpp"
+#include "MerkleProof.hpp"
+#include "ProofCodec.hpp"
+#include "MerkleAccumulator.hpp"
+#include "BoundedQueue.hpp"
+#include "MerklePipeline.hpp"
+#include "MerkleDiff.hpp"
+#include "FileHasher.hpp"
+#include "Chunker.hpp"
\ No newline at end of file
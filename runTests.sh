@@ -16,7 +16,7 @@ echo
 echo "Running All Tests..."
 
 # Define your test binary here
-tests=("test_SHA256" "test_MerkelTree")
+tests=("test_SHA256" "test_MerkelTree" "test_FlatTree" "test_ThreadPool" "test_MerkleProof" "test_ProofCodec" "test_MerkleAccumulator" "test_MerklePipeline" "test_MerkleDiff" "test_TreeFile" "test_ExternalBuilder" "test_RecordFile" "test_FileHasher" "test_Chunker" "test_HashCache" "test_SparseMerkleTree" "test_BasicMerkleTree" "test_Stats")
 
 # Directory where binaries are located
 BIN_DIR="bin"
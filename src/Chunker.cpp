@@ -0,0 +1,100 @@
+#include "lib.hpp"
+
+// Chunker.cpp
+
+/**
+ * @note makeGear() fills the gear table with splitmix64 outputs at compile time
+*/
+static constexpr array<uint64_t, 256> makeGear(){
+    array<uint64_t, 256> table = {};
+    uint64_t state = 0x4d65726b6c654344;
+    for (size_t i=0; i<256; i++){
+        state += 0x9e3779b97f4a7c15;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        table[i] = z ^ (z >> 31);
+    }
+    return table;
+}
+
+static constexpr array<uint64_t, 256> gear = makeGear();
+
+/**
+ * @note topBits() returns a mask of the highest n bits of a 64 bit word
+*/
+static uint64_t topBits(size_t n){
+    return (n == 0) ? 0 : ~uint64_t(0) << (64 - n);
+}
+
+/**
+ * @note constructor derives the two cut masks from the average size. A boundary test on b bits passes
+ * once every 2^b bytes on average. The small mask uses 2 more bits than log2(avgSize), the large
+ * mask 2 fewer.
+ * @param minSize is the smallest chunk, except for the last one
+ * @param avgSize is the target average chunk size
+ * @param maxSize is the largest chunk
+*/
+Chunker::Chunker(size_t minSize, size_t avgSize, size_t maxSize) : minSize(minSize), avgSize(avgSize), maxSize(maxSize) {
+    assert(minSize > 0 && minSize <= avgSize && avgSize <= maxSize);
+
+    size_t bits = std::bit_width(avgSize) - 1;
+    maskSmall = topBits(std::min<size_t>(bits + 2, 63));
+    maskLarge = topBits(bits > 2 ? bits - 2 : 1);
+}
+
+const array<uint64_t, 256>& Chunker::gearTable(){
+    return gear;
+}
+
+/**
+ * @note nextCut() finds the end of the chunk starting at data
+ * @param data is the remaining input
+ * @param len is the number of remaining bytes
+ * @returns the length of the chunk, len if the input ends first
+*/
+size_t Chunker::nextCut(const uint8_t* data, size_t len) const {
+    if (len <= minSize){
+        return len;
+    }
+
+    size_t end = std::min(len, maxSize);
+    size_t normal = std::min(end, avgSize);
+    uint64_t fp = 0;
+    size_t i = minSize;
+
+    for (; i<normal; i++){
+        fp = (fp << 1) + gear[data[i]];
+        if ((fp & maskSmall) == 0){
+            return i + 1;
+        }
+    }
+    for (; i<end; i++){
+        fp = (fp << 1) + gear[data[i]];
+        if ((fp & maskLarge) == 0){
+            return i + 1;
+        }
+    }
+
+    return end;
+}
+
+/**
+ * @note split() cuts data into content defined chunks
+ * @param data is the input
+ * @param len is the input length
+ * @returns the chunks, pointing into data. Empty input gives no chunks.
+*/
+vector<BatchMessage> Chunker::split(const uint8_t* data, size_t len) const {
+    vector<BatchMessage> chunks;
+    chunks.reserve(len / avgSize + 1);
+
+    size_t offset = 0;
+    while (offset < len){
+        size_t cut = nextCut(data + offset, len - offset);
+        chunks.push_back({data + offset, cut});
+        offset += cut;
+    }
+
+    return chunks;
+}
@@ -0,0 +1,220 @@
+#include "lib.hpp"
+
+#include <filesystem>
+#include <unistd.h>
+
+// ExternalBuilder.cpp
+
+/**
+ * @note constructor sizes the block to half the budget, the other half is left for the read and
+ * write buffers of the upper level passes
+ * @param mode is the parent hashing scheme
+ * @param memoryBudget is the memory for leaves and nodes in bytes, at least 4 KiB
+ * @param treePath is the TreeFile to write all levels to, empty for the root only
+ * @param scratchDir is the directory for the level files, empty for the system temp directory
+*/
+ExternalBuilder::ExternalBuilder(HashMode mode, size_t memoryBudget, const string& treePath, const string& scratchDir)
+    : tree(mode), treePath(treePath), finished(false), leaves(0), filled(0) {
+    assert(memoryBudget >= 4096);
+
+    // the block's levels take 2 * blockSize digests
+    blockSize = std::bit_floor(memoryBudget / (4 * sizeof(Digest)));
+    blockHeight = std::countr_zero(blockSize);
+    block.resize(2 * blockSize);
+
+    static std::atomic<uint64_t> builds{0};
+    std::filesystem::path dir = scratchDir.empty() ? std::filesystem::temp_directory_path() : std::filesystem::path(scratchDir);
+    scratchPrefix = (dir / ("merkle-build-" + std::to_string(getpid()) + "-" + std::to_string(builds++))).string();
+}
+
+ExternalBuilder::~ExternalBuilder(){
+    removeScratch();
+}
+
+/**
+ * @note levelPath() returns the scratch file of a level
+*/
+string ExternalBuilder::levelPath(size_t level) const {
+    return scratchPrefix + "-level" + std::to_string(level) + ".tmp";
+}
+
+/**
+ * @note writeLevel() appends nodes to a level's scratch file, opening it on first use
+*/
+void ExternalBuilder::writeLevel(size_t level, const Digest* nodes, size_t count){
+    if (levelFiles.size() <= level){
+        levelFiles.resize(level + 1);
+    }
+    if (levelFiles[level] == nullptr){
+        levelFiles[level] = std::make_unique<std::ofstream>(levelPath(level), ios::binary | ios::trunc);
+    }
+    levelFiles[level]->write(reinterpret_cast<const char*>(nodes), std::streamsize(count * sizeof(Digest)));
+    if (!*levelFiles[level]){
+        throw std::runtime_error("ExternalBuilder: cannot write " + levelPath(level));
+    }
+}
+
+/**
+ * @note removeScratch() closes and deletes every level file
+*/
+void ExternalBuilder::removeScratch(){
+    for (size_t l=0; l<levelFiles.size(); l++){
+        if (levelFiles[l] != nullptr){
+            levelFiles[l].reset();
+            std::remove(levelPath(l).c_str());
+        }
+    }
+    levelFiles.clear();
+}
+
+/**
+ * @note flushBlock() hashes the levels of the current block and appends them to the level files.
+ * Only the block's top level is written when no tree file was asked for.
+ * @param last tells that no leaves follow, so the block may be partial
+*/
+void ExternalBuilder::flushBlock(bool last){
+    if (filled == 0){
+        return;
+    }
+    assert((leaves - filled) % blockSize == 0);
+    size_t top = last ? std::min(blockHeight, FlatTree::levelCountOf(leaves) - 1) : blockHeight;
+
+    Digest* level = block.data();
+    size_t count = filled;
+    if (!treePath.empty() || top == 0){
+        writeLevel(0, level, count);
+    }
+    for (size_t l=1; l<=top; l++){
+        Digest* parents = level + (blockSize >> (l - 1));
+        tree.hashLevel(level, count, parents);
+        level = parents;
+        count = (count + 1) / 2;
+        if (!treePath.empty() || l == top){
+            writeLevel(l, level, count);
+        }
+    }
+    filled = 0;
+}
+
+/**
+ * @note append() hashes leaves into the block, one batch at a time, flushing it when it is full
+*/
+void ExternalBuilder::append(const BatchMessage* msgs, size_t count){
+    assert(!finished);
+    while (count > 0){
+        size_t take = std::min(count, blockSize - filled);
+        tree.hashMessages(msgs, take, &block[filled]);
+        filled += take;
+        leaves += take;
+        msgs += take;
+        count -= take;
+        if (filled == blockSize){
+            flushBlock(false);
+        }
+    }
+}
+
+void ExternalBuilder::append(std::string_view data){
+    BatchMessage msg = {reinterpret_cast<const uint8_t*>(data.data()), data.size()};
+    append(&msg, 1);
+}
+
+void ExternalBuilder::append(std::span<const std::string_view> input){
+    BatchMessage msgs[MerkleTree::leafBlock];
+    for (size_t begin=0; begin<input.size(); begin+=MerkleTree::leafBlock){
+        size_t count = std::min(MerkleTree::leafBlock, input.size() - begin);
+        for (size_t i=0; i<count; i++){
+            msgs[i] = {reinterpret_cast<const uint8_t*>(input[begin + i].data()), input[begin + i].size()};
+        }
+        append(msgs, count);
+    }
+}
+
+/**
+ * @note appendDigest() adds an already hashed leaf
+*/
+void ExternalBuilder::appendDigest(const Digest& leaf){
+    assert(!finished);
+    block[filled++] = leaf;
+    leaves++;
+    if (filled == blockSize){
+        flushBlock(false);
+    }
+}
+
+/**
+ * @note finish() flushes the last block and builds the remaining levels in passes over the level
+ * files, reusing the block's memory as the read and write buffers
+ * @returns the root, at least one leaf must have been appended
+*/
+Digest ExternalBuilder::finish(){
+    assert(!finished && leaves > 0);
+    finished = true;
+    flushBlock(true);
+
+    size_t levelCount = FlatTree::levelCountOf(leaves);
+    size_t level = std::min(blockHeight, levelCount - 1);
+
+    // closes a level file and reopens it for reading
+    auto reopen = [&](size_t l){
+        if (levelFiles[l]->is_open()){
+            levelFiles[l]->close();
+        }
+        if (!*levelFiles[l]){
+            throw std::runtime_error("ExternalBuilder: cannot write " + levelPath(l));
+        }
+        std::ifstream in(levelPath(l), ios::binary);
+        if (!in){
+            throw std::runtime_error("ExternalBuilder: cannot read " + levelPath(l));
+        }
+        return in;
+    };
+
+    // blockSize nodes in, blockSize / 2 parents out, both inside the block
+    Digest* input = block.data();
+    Digest* parents = block.data() + blockSize;
+    for (; level + 1 < levelCount; level++){
+        std::ifstream in = reopen(level);
+        for (uint64_t done=0; done<FlatTree::levelSizeOf(leaves, level); ){
+            size_t count = size_t(std::min<uint64_t>(blockSize, FlatTree::levelSizeOf(leaves, level) - done));
+            if (!in.read(reinterpret_cast<char*>(input), std::streamsize(count * sizeof(Digest)))){
+                throw std::runtime_error("ExternalBuilder: cannot read " + levelPath(level));
+            }
+            tree.hashLevel(input, count, parents);
+            writeLevel(level + 1, parents, (count + 1) / 2);
+            done += count;
+        }
+        if (treePath.empty()){
+            levelFiles[level].reset();
+            std::remove(levelPath(level).c_str());
+        }
+    }
+
+    Digest root;
+    {
+        std::ifstream in = reopen(levelCount - 1);
+        if (!in.read(reinterpret_cast<char*>(root.data()), sizeof(Digest))){
+            throw std::runtime_error("ExternalBuilder: cannot read " + levelPath(levelCount - 1));
+        }
+    }
+
+    // every level is on disk, stream them into the tree file
+    if (!treePath.empty()){
+        for (size_t l=0; l<levelCount; l++){
+            reopen(l).close();
+        }
+        std::ifstream in;
+        size_t open = levelCount;
+        TreeFile::write(treePath, tree.mode, leaves, [&](size_t l, Digest* buffer, size_t capacity){
+            if (open != l){
+                in = std::ifstream(levelPath(l), ios::binary);
+                open = l;
+            }
+            in.read(reinterpret_cast<char*>(buffer), std::streamsize(capacity * sizeof(Digest)));
+            return size_t(in.gcount()) / sizeof(Digest);
+        });
+    }
+
+    removeScratch();
+    return root;
+}
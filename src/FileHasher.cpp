@@ -0,0 +1,221 @@
+#include "lib.hpp"
+
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// FileHasher.cpp
+
+/**
+ * @note constructor sets the chunking and hashing scheme
+ * @param chunkSize is the number of bytes per leaf
+ * @param mode is the parent hashing scheme of the tree
+*/
+FileHasher::FileHasher(size_t chunkSize, HashMode mode)
+    : chunkSize(chunkSize), mode(mode), taskBytes(size_t(64) << 20), cache(nullptr) {
+    assert(chunkSize > 0);
+}
+
+/**
+ * @note scan() lists the files to hash. Files are taken as given, directories contribute their regular
+ * files recursively in sorted order.
+ * @param paths are files and directories
+ * @returns one entry per file, with its leaves laid out one after another
+*/
+vector<FileEntry> FileHasher::scan(const vector<string>& paths) const {
+
+    vector<FileEntry> files;
+    auto addFile = [&](const string& path){
+        struct stat st;
+        if (::stat(path.c_str(), &st) != 0){
+            throw std::runtime_error("FileHasher: cannot stat " + path);
+        }
+        if (!S_ISREG(st.st_mode)){
+            throw std::runtime_error("FileHasher: not a regular file " + path);
+        }
+
+        FileEntry file;
+        file.path = path;
+        file.size = uint64_t(st.st_size);
+        file.mtime = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        file.firstLeaf = files.empty() ? 0 : files.back().firstLeaf + files.back().leafCount;
+        file.leafCount = std::max<uint64_t>(1, (file.size + chunkSize - 1) / chunkSize);
+        files.push_back(file);
+    };
+
+    for (const string& path : paths){
+        std::error_code error;
+        if (!std::filesystem::is_directory(path, error)){
+            addFile(path);
+            continue;
+        }
+
+        vector<string> found;
+        std::filesystem::recursive_directory_iterator it(path, error), end;
+        for (; !error && it != end; it.increment(error)){
+            if (it->is_regular_file(error)){
+                found.push_back(it->path().string());
+            }
+        }
+        if (error){
+            throw std::runtime_error("FileHasher: cannot walk " + path + ": " + error.message());
+        }
+
+        std::sort(found.begin(), found.end());
+        for (const string& file : found){
+            addFile(file);
+        }
+    }
+
+    return files;
+}
+
+/**
+ * @note chunkKey() identifies one chunk of one version of a file: its path, size, mtime, the chunk
+ * size and the chunk index
+*/
+static string chunkKey(const FileEntry& file, size_t chunkSize, size_t chunk){
+    string key = file.path;
+    uint64_t fields[4] = {file.size, uint64_t(file.mtime), uint64_t(chunkSize), uint64_t(chunk)};
+    key.push_back('\0');
+    key.append(reinterpret_cast<const char*>(fields), sizeof(fields));
+    return key;
+}
+
+/**
+ * @note unchanged() checks that an open file still has the size and mtime scan() recorded
+*/
+static bool unchanged(int fd, const FileEntry& file){
+    struct stat st;
+    if (::fstat(fd, &st) != 0){
+        return false;
+    }
+    int64_t mtime = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return uint64_t(st.st_size) == file.size && mtime == file.mtime;
+}
+
+/**
+ * @note hashChunks() hashes every chunk of the scanned files on the pool
+ * @param files are the output of scan()
+ * @param pool is the thread pool to hash on
+ * @returns one digest per chunk, in leaf order
+ * @throws std::runtime_error if a file cannot be read, or changed since scan()
+*/
+vector<Digest> FileHasher::hashChunks(const vector<FileEntry>& files, ThreadPool& pool) const {
+
+    size_t numLeaves = files.empty() ? 0 : files.back().firstLeaf + files.back().leafCount;
+    vector<Digest> leaves(numLeaves);
+
+    // cut every file into tasks of whole chunks
+    struct Task { size_t file; size_t firstChunk; size_t lastChunk; };
+    vector<Task> tasks;
+    size_t chunksPerTask = std::max<size_t>(1, taskBytes / chunkSize);
+    for (size_t f=0; f<files.size(); f++){
+        for (size_t c=0; c<files[f].leafCount; c+=chunksPerTask){
+            tasks.push_back({f, c, std::min(files[f].leafCount, c + chunksPerTask)});
+        }
+    }
+
+    std::atomic<bool> failed = false;
+    string failure;
+    std::mutex failLock;
+
+    pool.parallelFor(tasks.size(), 1, [&](size_t first, size_t last){
+        vector<uint8_t> buffer;
+        for (size_t t=first; t<last; t++){
+            const FileEntry& file = files[tasks[t].file];
+            uint64_t begin = uint64_t(tasks[t].firstChunk) * chunkSize;
+            uint64_t end = std::min<uint64_t>(file.size, uint64_t(tasks[t].lastChunk) * chunkSize);
+            size_t len = size_t(end - begin);
+            Digest* out = &leaves[file.firstLeaf + tasks[t].firstChunk];
+
+            // an empty file is a single empty chunk
+            if (len == 0){
+                static constexpr Digest emptyLeaf = SHA256Const::hash("");
+                *out = emptyLeaf;
+                continue;
+            }
+
+            // unchanged chunks come from the cache, and the file is read only if one is missing
+            size_t numChunks = tasks[t].lastChunk - tasks[t].firstChunk;
+            if (cache != nullptr){
+                bool cached = true;
+                for (size_t c=0; c<numChunks && cached; c++){
+                    cached = cache->lookup(CacheKind::File, chunkKey(file, chunkSize, tasks[t].firstChunk + c), out[c]);
+                }
+                if (cached){
+                    continue;
+                }
+            }
+
+            // the window is read rather than mapped, a file truncated under a mapping would fault
+            // on the hash, while here it only ends the read early
+            int fd = ::open(file.path.c_str(), O_RDONLY);
+            bool same = fd >= 0 && unchanged(fd, file);
+            bool ok = same;
+            if (ok){
+                buffer.resize(len);
+                size_t done = 0;
+                while (done < len){
+                    ssize_t n = ::pread(fd, buffer.data() + done, len - done, off_t(begin + done));
+                    if (n <= 0){
+                        // an early end of file means the file shrank since it was checked
+                        same = n < 0;
+                        ok = false;
+                        break;
+                    }
+                    done += size_t(n);
+                }
+            }
+
+            if (ok){
+                vector<BatchMessage> msgs(numChunks);
+                for (size_t c=0; c<numChunks; c++){
+                    msgs[c] = {buffer.data() + c * chunkSize, std::min(chunkSize, len - c * chunkSize)};
+                }
+                SHA256Batch::hash(msgs.data(), msgs.size(), out->data());
+
+                // a write while hashing would put new bytes under the old key
+                same = unchanged(fd, file);
+                ok = same;
+                for (size_t c=0; ok && cache != nullptr && c<numChunks; c++){
+                    cache->insert(CacheKind::File, chunkKey(file, chunkSize, tasks[t].firstChunk + c), out[c]);
+                }
+            }
+            if (!ok){
+                std::lock_guard<std::mutex> guard(failLock);
+                failed = true;
+                failure = (fd >= 0 && !same ? "changed while hashing " : "cannot read ") + file.path;
+            }
+
+            if (fd >= 0){
+                ::close(fd);
+            }
+        }
+    });
+
+    if (failed){
+        throw std::runtime_error("FileHasher: " + failure);
+    }
+
+    return leaves;
+}
+
+/**
+ * @note buildTree() builds the tree over all chunk digests
+*/
+FlatTree FileHasher::buildTree(const vector<Digest>& leaves) const {
+    MerkleTree merkelTree = MerkleTree(mode);
+    merkelTree.cache = cache;
+    return merkelTree.buildTree(leaves.data(), leaves.size());
+}
+
+/**
+ * @note fileRoot() returns the root of the tree over one file's chunks alone
+*/
+Digest FileHasher::fileRoot(const FileEntry& file, const vector<Digest>& leaves) const {
+    MerkleTree merkelTree = MerkleTree(mode);
+    merkelTree.cache = cache;
+    return merkelTree.buildTree(&leaves[file.firstLeaf], file.leafCount).root();
+}
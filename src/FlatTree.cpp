@@ -0,0 +1,187 @@
+#include "lib.hpp"
+
+#include <new>
+
+// FlatTree.cpp
+
+/**
+ * @note default constructor creates an empty hex mode tree with no levels
+*/
+FlatTree::FlatTree() : FlatTree(HashMode::Hex) {}
+
+/**
+ * @note constructor creates an empty tree with no levels, for leaves to be appended to
+ * @param mode is the hash mode the tree is built with
+*/
+FlatTree::FlatTree(HashMode mode) : buffer(nullptr), capacity(0), leaves(0), reservedLeaves(0), mode(mode) {}
+
+/**
+ * @note constructor lays out the levels for leafCount leaves and allocates them in one buffer. The
+ * digests are left for the builder to fill in.
+ * @param leafCount is the number of leaves, must be > 0
+ * @param mode is the hash mode the tree is built with
+ * @throws std::invalid_argument for 0 leaves
+*/
+FlatTree::FlatTree(size_t leafCount, HashMode mode)
+    : buffer(nullptr), capacity(0), leaves(leafCount), reservedLeaves(leafCount), mode(mode) {
+    shape(leafCount, sizes);
+    allocate(layout(leafCount, offsets));
+}
+
+FlatTree::FlatTree(const FlatTree& other)
+    : buffer(nullptr), capacity(0), leaves(other.leaves), reservedLeaves(other.reservedLeaves), mode(other.mode),
+      offsets(other.offsets), sizes(other.sizes) {
+    if (other.capacity > 0) {
+        allocate(other.capacity);
+        std::memcpy(buffer, other.buffer, capacity * sizeof(Digest));
+    }
+}
+
+FlatTree::FlatTree(FlatTree&& other) noexcept
+    : buffer(other.buffer), capacity(other.capacity), leaves(other.leaves), reservedLeaves(other.reservedLeaves),
+      mode(other.mode), offsets(std::move(other.offsets)), sizes(std::move(other.sizes)) {
+    other.buffer = nullptr;
+    other.capacity = 0;
+    other.leaves = 0;
+    other.reservedLeaves = 0;
+}
+
+FlatTree& FlatTree::operator=(FlatTree other) noexcept {
+    std::swap(buffer, other.buffer);
+    std::swap(capacity, other.capacity);
+    std::swap(leaves, other.leaves);
+    std::swap(reservedLeaves, other.reservedLeaves);
+    std::swap(mode, other.mode);
+    offsets.swap(other.offsets);
+    sizes.swap(other.sizes);
+    return *this;
+}
+
+FlatTree::~FlatTree() {
+    release();
+}
+
+/**
+ * @note layout() computes where each level starts when the buffer is sized for leafCapacity leaves
+ * @returns the total number of digests in the buffer
+ * @throws std::invalid_argument for 0 leaves, which would never halve down to a root
+*/
+size_t FlatTree::layout(size_t leafCapacity, vector<size_t>& offsets) {
+    vector<size_t> sizes;
+    shape(leafCapacity, sizes);
+    offsets.resize(sizes.size());
+    size_t total = 0;
+    for (size_t l = 0; l < sizes.size(); l++) {
+        offsets[l] = total;
+        total += sizes[l];
+    }
+    return total;
+}
+
+/**
+ * @note shape() computes the level sizes of a tree of leafCount leaves, halving (rounding up) until the root
+ * @throws std::invalid_argument for 0 leaves
+*/
+void FlatTree::shape(size_t leafCount, vector<size_t>& sizes) {
+    if (leafCount == 0) {
+        throw std::invalid_argument("FlatTree: a tree needs at least one leaf");
+    }
+    sizes.resize(levelCountOf(leafCount));
+    for (size_t l = 0; l < sizes.size(); l++) {
+        sizes[l] = levelSizeOf(leafCount, l);
+    }
+}
+
+/**
+ * @note reserve() re-lays the buffer out for at least leafCapacity leaves, keeping every node
+ * @param leafCapacity is the number of leaves to make room for
+*/
+void FlatTree::reserve(size_t leafCapacity) {
+    if (leafCapacity <= reservedLeaves) {
+        return;
+    }
+
+    vector<size_t> newOffsets;
+    size_t total = layout(leafCapacity, newOffsets);
+    Digest* newBuffer = static_cast<Digest*>(::operator new(total * sizeof(Digest), std::align_val_t(alignment)));
+    MERKLE_COUNT(bytesAllocated, total * sizeof(Digest));
+    for (size_t l = 0; l < sizes.size(); l++) {
+        std::memcpy(newBuffer + newOffsets[l], buffer + offsets[l], sizes[l] * sizeof(Digest));
+    }
+
+    release();
+    buffer = newBuffer;
+    capacity = total;
+    reservedLeaves = leafCapacity;
+    offsets.swap(newOffsets);
+}
+
+/**
+ * @note resize() changes the number of leaves. Existing nodes keep their values, nodes added on any
+ * level are uninitialized. Growing past the reserved capacity at least doubles it, so a run of appends
+ * costs amortized O(1) copies per leaf.
+ * @param leafCount is the new number of leaves, must be > 0
+ * @throws std::invalid_argument for 0 leaves, before the tree is changed
+*/
+void FlatTree::resize(size_t leafCount) {
+    if (leafCount > reservedLeaves) {
+        reserve(std::max(leafCount, 2 * reservedLeaves));
+    }
+    shape(leafCount, sizes);
+    leaves = leafCount;
+}
+
+/**
+ * @note allocate() reserves an aligned buffer for numDigests digests
+*/
+void FlatTree::allocate(size_t numDigests) {
+    buffer = static_cast<Digest*>(::operator new(numDigests * sizeof(Digest), std::align_val_t(alignment)));
+    capacity = numDigests;
+    MERKLE_COUNT(bytesAllocated, numDigests * sizeof(Digest));
+}
+
+/**
+ * @note release() frees the whole tree in one call
+*/
+void FlatTree::release() {
+    if (buffer != nullptr) {
+        ::operator delete(buffer, std::align_val_t(alignment));
+        buffer = nullptr;
+    }
+    capacity = 0;
+}
+
+/**
+ * @note rootHex() returns the root digest as a hex string
+*/
+string FlatTree::rootHex() const {
+    return SHA256::toHex(root().data(), 32);
+}
+
+/**
+ * @note toNodes() materializes the tree as linked TreeNode structs, as returned by
+ * MerkleTree::assembleTree(). Every node is allocated separately so the result can be released
+ * with MerkleTree::freeTree().
+ * @returns ptr to the root node
+*/
+TreeNode* FlatTree::toNodes() const {
+
+    vector<TreeNode*> below;
+    for (size_t l = 0; l < levelCount(); l++) {
+        vector<TreeNode*> current(sizes[l]);
+        for (size_t i = 0; i < sizes[l]; i++) {
+            TreeNode* node = new TreeNode;
+            MERKLE_COUNT(nodesAllocated, 1);
+            node->digest = this->node(l, i);
+            if (mode == HashMode::Hex) {
+                node->hash = SHA256::toHex(node->digest.data(), 32);
+            }
+            node->ancestors[0] = (l == 0) ? nullptr : below[leftChild(i)];
+            node->ancestors[1] = (l == 0 || rightChild(i) >= below.size()) ? nullptr : below[rightChild(i)];
+            current[i] = node;
+        }
+        below.swap(current);
+    }
+
+    return below[0];
+}
@@ -0,0 +1,217 @@
+#include "lib.hpp"
+
+// HashCache.cpp
+
+static_assert(HashCache::entryOverhead >= 2 * (sizeof(size_t) + sizeof(Digest) + 8 + sizeof(string)));
+
+/**
+ * @note constructor splits the capacity evenly over the shards
+ * @param capacityBytes is the total size the entries may be charged for
+ * @param numShards is the number of independently locked shards, at least 1
+*/
+HashCache::HashCache(size_t capacityBytes, size_t numShards){
+    numShards = std::max<size_t>(1, numShards);
+    shardCapacity = capacityBytes / numShards;
+    for (size_t i=0; i<numShards; i++){
+        shards.push_back(std::make_unique<Shard>());
+        shards.back()->slots.resize(16);
+    }
+}
+
+/**
+ * @note keyHash() hashes a key once. The high bits pick the shard and the low bits the slot.
+*/
+size_t HashCache::keyHash(CacheKind kind, std::string_view key){
+    return std::hash<std::string_view>()(key) ^ (size_t(kind) * 0x9e3779b97f4a7c15ULL);
+}
+
+HashCache::Shard& HashCache::shardFor(size_t hash){
+    return *shards[(hash >> 40) % shards.size()];
+}
+
+/**
+ * @note find() probes for a key from its home slot until it finds it or an empty slot
+ * @returns the slot index, or SIZE_MAX if the key is not cached
+*/
+size_t HashCache::find(const Shard& shard, CacheKind kind, std::string_view key, size_t hash){
+    size_t mask = shard.slots.size() - 1;
+    for (size_t i = hash & mask; shard.slots[i].used; i = (i + 1) & mask){
+        const Slot& slot = shard.slots[i];
+        if (slot.hash == hash && slot.kind == kind && slot.key == key){
+            return i;
+        }
+    }
+    return SIZE_MAX;
+}
+
+/**
+ * @note erase() empties a slot and shifts later entries of the same probe run back into the gap,
+ * so probing never needs tombstones
+*/
+void HashCache::erase(Shard& shard, size_t index){
+    size_t mask = shard.slots.size() - 1;
+    shard.bytes -= shard.slots[index].key.size() + entryOverhead;
+    shard.entries--;
+
+    size_t gap = index;
+    for (size_t j = (gap + 1) & mask; shard.slots[j].used; j = (j + 1) & mask){
+
+        // an entry stays if its home lies cyclically in (gap, j]
+        size_t home = shard.slots[j].hash & mask;
+        bool stays = (gap <= j) ? (gap < home && home <= j) : (gap < home || home <= j);
+        if (!stays){
+            shard.slots[gap] = std::move(shard.slots[j]);
+            gap = j;
+        }
+    }
+    shard.slots[gap].used = false;
+    string().swap(shard.slots[gap].key);
+}
+
+/**
+ * @note evictOne() advances the CLOCK hand, giving referenced entries a second chance, and evicts
+ * the first entry not used since the hand last passed it
+*/
+void HashCache::evictOne(Shard& shard){
+    size_t mask = shard.slots.size() - 1;
+    while (true){
+        Slot& slot = shard.slots[shard.hand];
+        if (slot.used && !slot.referenced){
+            erase(shard, shard.hand);
+            shard.evictions++;
+            return;
+        }
+        slot.referenced = false;
+        shard.hand = (shard.hand + 1) & mask;
+    }
+}
+
+/**
+ * @note grow() doubles the table and reinserts every entry
+*/
+void HashCache::grow(Shard& shard){
+    vector<Slot> old(shard.slots.size() * 2);
+    old.swap(shard.slots);
+    size_t mask = shard.slots.size() - 1;
+    for (Slot& slot : old){
+        if (!slot.used) { continue; }
+        size_t i = slot.hash & mask;
+        while (shard.slots[i].used){
+            i = (i + 1) & mask;
+        }
+        shard.slots[i] = std::move(slot);
+    }
+    shard.hand = 0;
+}
+
+/**
+ * @note lookup() returns the cached digest of a key and marks it as recently used
+ * @param digest receives the digest on a hit
+ * @returns false on a miss
+*/
+bool HashCache::lookup(CacheKind kind, std::string_view key, Digest& digest){
+    size_t hash = keyHash(kind, key);
+    Shard& shard = shardFor(hash);
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    size_t i = find(shard, kind, key, hash);
+    if (i == SIZE_MAX){
+        shard.misses++;
+        return false;
+    }
+    shard.slots[i].referenced = true;
+    digest = shard.slots[i].digest;
+    shard.hits++;
+    return true;
+}
+
+/**
+ * @note insert() caches the digest of a key, evicting entries of its shard until it fits. Keys too
+ * large for a shard are not cached.
+*/
+void HashCache::insert(CacheKind kind, std::string_view key, const Digest& digest){
+    size_t charge = key.size() + entryOverhead;
+    if (charge > shardCapacity){
+        return;
+    }
+
+    size_t hash = keyHash(kind, key);
+    Shard& shard = shardFor(hash);
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    size_t i = find(shard, kind, key, hash);
+    if (i != SIZE_MAX){
+        shard.slots[i].digest = digest;
+        shard.slots[i].referenced = true;
+        return;
+    }
+
+    while (shard.bytes + charge > shardCapacity){
+        evictOne(shard);
+    }
+    if (2 * (shard.entries + 1) > shard.slots.size()){
+        grow(shard);
+    }
+
+    size_t mask = shard.slots.size() - 1;
+    for (i = hash & mask; shard.slots[i].used; i = (i + 1) & mask) {}
+    shard.slots[i] = {hash, digest, kind, true, false, string(key)};
+    shard.entries++;
+    shard.bytes += charge;
+    shard.insertions++;
+}
+
+/**
+ * @note pairKey() lays out the key of a parent, the mode byte and both children, in buffer
+ * @param buffer has room for 65 bytes
+*/
+std::string_view HashCache::pairKey(const Digest& left, const Digest& right, HashMode mode, uint8_t* buffer){
+    buffer[0] = uint8_t(mode);
+    std::memcpy(buffer + 1, left.data(), 32);
+    std::memcpy(buffer + 33, right.data(), 32);
+    return std::string_view(reinterpret_cast<const char*>(buffer), 65);
+}
+
+bool HashCache::lookupPair(const Digest& left, const Digest& right, HashMode mode, Digest& parent){
+    uint8_t buffer[65];
+    return lookup(CacheKind::Pair, pairKey(left, right, mode, buffer), parent);
+}
+
+void HashCache::insertPair(const Digest& left, const Digest& right, HashMode mode, const Digest& parent){
+    uint8_t buffer[65];
+    insert(CacheKind::Pair, pairKey(left, right, mode, buffer), parent);
+}
+
+/**
+ * @note stats() sums the counters of every shard
+*/
+CacheStats HashCache::stats() const {
+    CacheStats total = {};
+    for (const auto& shard : shards){
+        std::lock_guard<std::mutex> guard(shard->lock);
+        total.hits += shard->hits;
+        total.misses += shard->misses;
+        total.insertions += shard->insertions;
+        total.evictions += shard->evictions;
+        total.entries += shard->entries;
+        total.bytes += shard->bytes;
+    }
+    return total;
+}
+
+/**
+ * @note clear() drops every entry and resets the counters
+*/
+void HashCache::clear(){
+    for (auto& shard : shards){
+        std::lock_guard<std::mutex> guard(shard->lock);
+        shard->slots.assign(16, Slot{});
+        shard->hand = 0;
+        shard->entries = 0;
+        shard->bytes = 0;
+        shard->hits = 0;
+        shard->misses = 0;
+        shard->insertions = 0;
+        shard->evictions = 0;
+    }
+}
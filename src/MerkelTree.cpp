@@ -10,14 +10,21 @@
  * 
  * Step 2:
  * Then until the final route node is created, these hash pair concatenations must themselves be 
- * hashed, and paired.
+ * hashed, and paired. A node left without a pair at the end of a level is hashed alone.
+ *
+ * In HashMode::Hex the hashes being concatenated are the 64 char hex strings of the children. In
+ * HashMode::Binary they are the raw 32 byte digests, so a parent hashes 64 bytes (a single block)
+ * instead of 128.
 */
 
 /**
  * @note constructor initializes SHA256 class as hash func for merkle tree
+ * @param mode selects how parents hash their children, HashMode::Hex by default
 */
-MerkleTree::MerkleTree(){
+MerkleTree::MerkleTree(HashMode mode){
     sha256 = SHA256();
+    this->mode = mode;
+    cache = nullptr;
 }
 
 /**
@@ -25,17 +32,198 @@ MerkleTree::MerkleTree(){
  * @param input is a vector of strings containing the data to be hashed
  * @returns vector of hash strings
 */
-vector<string> MerkleTree::hashStrings(vector<string> input){
+vector<string> MerkleTree::hashStrings(const vector<string>& input){
 
-    // hash all input strings after converting to binary vectors
+    vector<Digest> digests = hashLeaves(input);
+
+    // hex encode digests
     vector<string> hashes;
-    for (int i=0; i<input.size(); i++){
-        vector<bool> bin = sha256.stringToBinary(input[i]);
-        hashes.push_back(sha256.computeHash(bin));
+    hashes.reserve(digests.size());
+    for (size_t i=0; i<digests.size(); i++){
+        hashes.push_back(SHA256::toHex(digests[i].data(), 32));
     }
     return hashes;
 }
 
+/**
+ * @note hashStrings() hashes records in place and writes their hex digests into a caller provided
+ * buffer, allocating nothing
+ * @param input are the records
+ * @param hex is the output buffer of 64 * input.size() chars, not null terminated
+*/
+void MerkleTree::hashStrings(std::span<const std::string_view> input, char* hex){
+    Digest digests[leafBlock];
+    for (size_t begin=0; begin<input.size(); begin+=leafBlock){
+        size_t count = std::min(leafBlock, input.size() - begin);
+        hashLeaves(input.begin() + begin, input.begin() + begin + count, digests);
+        for (size_t i=0; i<count; i++){
+            SHA256::toHex(digests[i].data(), 32, hex + 64 * (begin + i));
+        }
+    }
+}
+
+/**
+ * @note hashLeaves() hashes all string inputs as one batch and keeps the raw digests
+ * @param input is a vector of strings containing the data to be hashed
+ * @returns vector of digests, one per input
+*/
+vector<Digest> MerkleTree::hashLeaves(const vector<string>& input){
+    vector<Digest> digests(input.size());
+    hashLeaves(input, digests.data());
+    return digests;
+}
+
+/**
+ * @note hashLeaves() hashes all string inputs as one batch into a caller provided array
+ * @param input is a vector of strings containing the data to be hashed
+ * @param digests is the output array of input.size() digests
+*/
+void MerkleTree::hashLeaves(const vector<string>& input, Digest* digests){
+    hashLeaves(input.data(), input.size(), digests);
+}
+
+/**
+ * @note hashLeaves() hashes count consecutive strings as one batch, e.g. the leaves of one subtree
+ * @param input is a ptr to the first string
+ * @param count is the number of strings
+ * @param digests is the output array of count digests
+*/
+void MerkleTree::hashLeaves(const string* input, size_t count, Digest* digests){
+    hashLeaves(input, input + count, digests);
+}
+
+/**
+ * @note hashLeaves() hashes records viewed in place, e.g. in an arena or a RecordFile
+ * @param input are the records
+ * @param digests is the output array of input.size() digests
+*/
+void MerkleTree::hashLeaves(std::span<const std::string_view> input, Digest* digests){
+    hashLeaves(input.begin(), input.end(), digests);
+}
+
+/**
+ * @note hashMessages() hashes leaf byte ranges as one batch, through the cache when one is attached
+ * @param msgs are the leaf byte ranges
+ * @param count is the number of leaves
+ * @param digests is the output array of count digests
+*/
+void MerkleTree::hashMessages(const BatchMessage* msgs, size_t count, Digest* digests){
+    if (cache != nullptr){
+        hashLeavesCached(msgs, count, digests);
+        return;
+    }
+    SHA256Batch::hash(msgs, count, reinterpret_cast<uint8_t*>(digests));
+}
+
+/**
+ * @note hashLeavesCached() takes what it can from the cache and hashes only the rest, as one batch.
+ * A leaf repeated within the input is hashed once.
+*/
+void MerkleTree::hashLeavesCached(const BatchMessage* input, size_t count, Digest* digests){
+
+    // misses, with each distinct input hashed once
+    vector<BatchMessage> msgs;
+    vector<size_t> missing;
+    vector<size_t> source;
+    std::unordered_map<std::string_view, size_t> firstMiss;
+    for (size_t i=0; i<count; i++){
+        std::string_view bytes(reinterpret_cast<const char*>(input[i].data), input[i].len);
+        if (cache->lookup(CacheKind::Leaf, bytes, digests[i])){
+            continue;
+        }
+        auto [it, fresh] = firstMiss.emplace(bytes, msgs.size());
+        if (fresh){
+            msgs.push_back(input[i]);
+        }
+        missing.push_back(i);
+        source.push_back(it->second);
+    }
+
+    // every leaf was cached
+    if (msgs.empty()){
+        return;
+    }
+
+    vector<Digest> hashed(msgs.size());
+    SHA256Batch::hash(msgs.data(), msgs.size(), reinterpret_cast<uint8_t*>(hashed.data()));
+    for (size_t k=0; k<missing.size(); k++){
+        digests[missing[k]] = hashed[source[k]];
+    }
+    for (auto& [bytes, k] : firstMiss){
+        cache->insert(CacheKind::Leaf, bytes, hashed[k]);
+    }
+}
+
+/**
+ * @note hashLevel() computes the parents of one level of the tree. Parent i hashes nodes 2i and 2i+1,
+ * and an odd last node is hashed alone. With hardware SHA the pairs go through SHA256Pair's fixed length
+ * kernel. Otherwise all parents are hashed as one SHA256Batch batch, and in binary mode the messages
+ * point straight into nodes, whose digests already sit back to back. With a cache attached, known pairs
+ * are copied from it instead.
+ * @param nodes is a ptr to the digests of the level
+ * @param count is the number of nodes on the level
+ * @param parents is the output array of (count + 1) / 2 digests
+*/
+void MerkleTree::hashLevel(const Digest* nodes, size_t count, Digest* parents){
+
+    // memoized pairs, the misses go through the pair kernel one by one
+    if (cache != nullptr){
+        for (size_t i=0; i<count/2; i++){
+            if (!cache->lookupPair(nodes[2*i], nodes[2*i + 1], mode, parents[i])){
+                SHA256Pair::hashPair(nodes[2*i], nodes[2*i + 1], parents[i], mode);
+                cache->insertPair(nodes[2*i], nodes[2*i + 1], mode, parents[i]);
+            }
+        }
+        if (count % 2 == 1){
+            SHA256Pair::hashAlone(nodes[count - 1], parents[count / 2], mode);
+        }
+        return;
+    }
+
+    // full pairs through the fixed length kernel, and an odd last node alone
+    if (SHA256Pair::preferred()){
+        SHA256Pair::hashPairs(nodes, count / 2, parents, mode);
+        if (count % 2 == 1){
+            SHA256Pair::hashAlone(nodes[count - 1], parents[count / 2], mode);
+        }
+        return;
+    }
+
+    size_t numParents = (count + 1) / 2;
+    vector<BatchMessage> msgs(numParents);
+
+    // hex text of every node on the level, only needed in hex mode
+    vector<char> hexText;
+    if (mode == HashMode::Hex){
+        hexText.resize(64 * count);
+        for (size_t i=0; i<count; i++){
+            SHA256::toHex(nodes[i].data(), 32, &hexText[64 * i]);
+        }
+    }
+
+    for (size_t i=0; i<numParents; i++){
+        size_t numChildren = (2*i + 1 < count) ? 2 : 1;
+        if (mode == HashMode::Hex){
+            msgs[i] = {reinterpret_cast<const uint8_t*>(&hexText[128 * i]), 64 * numChildren};
+        }
+        else {
+            msgs[i] = {nodes[2*i].data(), 32 * numChildren};
+        }
+    }
+
+    SHA256Batch::hash(msgs.data(), msgs.size(), parents->data());
+}
+
+/**
+ * @note computeRootHash() computes the root of the tree over input in flat storage, without allocating TreeNode structs
+ * @param input is a vector of strings containing the data to be hashed
+ * @returns the root hash as a hex string
+*/
+string MerkleTree::computeRootHash(const vector<string>& input){
+    assert(input.size() > 0);
+    return buildTree(input).rootHex();
+}
+
 /**
  * @note newTreeNode() allocates memory for a new tree node and computes its hash from the 
  * concatenated hashes of its ancestors.
@@ -43,17 +231,22 @@ vector<string> MerkleTree::hashStrings(vector<string> input){
  * @param ancestor2 is the second ancestor of the new node
 */
 TreeNode* MerkleTree::newTreeNode(TreeNode* ancestor1, TreeNode* ancestor2){
+    assert(ancestor1 != nullptr || ancestor2 != nullptr);
 
     // allocate mem for new node
     TreeNode* treeNode = new TreeNode;
+    MERKLE_COUNT(nodesAllocated, 1);
 
-    // cat hashes if they exist
-    string hashedPair = "";
-    if (ancestor1 != nullptr) { hashedPair.append(ancestor1->hash); }
-    if (ancestor2 != nullptr) { hashedPair.append(ancestor2->hash); }
-
-    // hash catted hashes, and set into treeNode
-    treeNode->hash = sha256.computeHash(sha256.stringToBinary(hashedPair));
+    // two children make a fixed length pair, a lone child is hashed alone
+    if (ancestor1 != nullptr && ancestor2 != nullptr){
+        SHA256Pair::hashPair(ancestor1->digest, ancestor2->digest, treeNode->digest, mode);
+    }
+    else {
+        SHA256Pair::hashAlone(ancestor1 != nullptr ? ancestor1->digest : ancestor2->digest, treeNode->digest, mode);
+    }
+    if (mode == HashMode::Hex){
+        treeNode->hash = SHA256::toHex(treeNode->digest.data(), 32);
+    }
 
     // set ancestors
     treeNode->ancestors[0] = ancestor1;
@@ -63,7 +256,8 @@ TreeNode* MerkleTree::newTreeNode(TreeNode* ancestor1, TreeNode* ancestor2){
 }   
 
 /**
- * @freeTree recursively deallocates all nodes in the tree from the root down
+ * @freeTree deallocates all nodes in the tree from the root down. Nodes are visited with an explicit
+ * stack, so deep trees cannot overflow the call stack.
  * @param root is a ptr to a ptr to the root node
 */
 void MerkleTree::freeTree(TreeNode** root){ 
@@ -73,69 +267,366 @@ void MerkleTree::freeTree(TreeNode** root){
         return;
     }
 
-    // Recursively free remaining subtrees
-    if ((*root)->ancestors[0] != nullptr){
-        freeTree(&((*root)->ancestors[0]));
-    }
-    if ((*root)->ancestors[1] != nullptr){
-        freeTree(&((*root)->ancestors[1]));
+    // pop a node, queue its ancestors, then deallocate it
+    vector<TreeNode*> stack = {*root};
+    while (!stack.empty()){
+        TreeNode* node = stack.back();
+        stack.pop_back();
+        if (node->ancestors[0] != nullptr){ stack.push_back(node->ancestors[0]); }
+        if (node->ancestors[1] != nullptr){ stack.push_back(node->ancestors[1]); }
+        delete node;
     }
 
-    // deallocate the current node, set to nullptr
-    delete *root;
     *root = nullptr;        
 }
 
 /**
  * @note assembleTree() assembles a merkle tree out of treeNode structs by first hashing all string inputs. Then
  * these hashes are packaged within dynamically allocated treeNode structs, forming the base layer of the tree. 
- * the binary tree is then from the lowest level until the root node is formed.
+ * the binary tree is then from the lowest level until the root node is formed. The hashing is done by buildTree(),
+ * and the resulting FlatTree is handed back as a node pointer view. Every node stores its raw digest, and nodes
+ * also carry the hex string in HashMode::Hex.
  * */
-TreeNode* MerkleTree::assembleTree(vector<string> input){
+TreeNode* MerkleTree::assembleTree(const vector<string>& input){
     assert(input.size() > 0);
 
-    // compute initial hashes from input vector
-    vector<string> hashes = hashStrings(input);
-
-    // create base layer of the tree w/ hashes of original str data
-    vector<TreeNode*> nodesVec;
-    for (int i=0; i<hashes.size(); i++){
-
-        // allocate mem for tree node without ancestors and set hash
-        TreeNode* node = newTreeNode(nullptr, nullptr);
-
-        // set hash of nodes manually
-        node->hash = hashes[i];
-        nodesVec.push_back(node);
-    }
-
-    // assemble tree from base up until root node established
-    while (nodesVec.size() != 1){
-        
-        // build next layer of tree, hashing concatted hashes of paired nodes 
-        vector<TreeNode*> tempNodesVec;
-        for (int i=0; i<nodesVec.size(); i++){
-            
-            // new tree node, func sets cat hash within node. 
-            TreeNode* newNode;
-            if (i+1 < nodesVec.size()){ // handle even num nodes
-                newNode = newTreeNode(nodesVec[i], nodesVec[i+1]); 
-                i++; // increment for two nodes added
-            }
-            else { // handle odd num nodes
-                newNode = newTreeNode(nodesVec[i], nullptr);
+    MERKLE_STATS_ONLY(uint64_t start = Stats::now(); HashCounters before = Stats::snapshot();)
+    TreeNode* root = buildTree(input).toNodes();
+    MERKLE_STATS_ONLY(stats.counters = Stats::delta(before); stats.totalNs = Stats::now() - start;)
+
+    return root;
+}
+
+TreeNode* MerkleTree::assembleTree(std::span<const std::string_view> input){
+    assert(input.size() > 0);
+
+    MERKLE_STATS_ONLY(uint64_t start = Stats::now(); HashCounters before = Stats::snapshot();)
+    TreeNode* root = buildTree(input).toNodes();
+    MERKLE_STATS_ONLY(stats.counters = Stats::delta(before); stats.totalNs = Stats::now() - start;)
+
+    return root;
+}
+
+/**
+ * @note buildTree() builds the tree into contiguous level ordered storage. Leaves are hashed straight into
+ * level 0, then each level is hashed by hashLevel() into the level above it.
+ * @param input is a vector of strings containing the data to be hashed
+ * @returns the flat tree
+*/
+FlatTree MerkleTree::buildTree(const vector<string>& input){
+    return buildTree(input.begin(), input.end());
+}
+
+/**
+ * @note buildTree() builds the tree over records viewed in place, without copying them into strings
+ * @param input are the records
+ * @returns the flat tree
+*/
+FlatTree MerkleTree::buildTree(std::span<const std::string_view> input){
+    return buildTree(input.begin(), input.end());
+}
+
+/**
+ * @note hashLevels() hashes every level from firstLevel up to the root from the level below it, and
+ * records the time of each level in stats when built with MERKLE_STATS
+ * @param tree is the tree, with level firstLevel - 1 already hashed
+ * @param firstLevel is the lowest level to hash, > 0
+*/
+void MerkleTree::hashLevels(FlatTree& tree, size_t firstLevel){
+    MERKLE_STATS_ONLY(stats.levelNs.resize(tree.levelCount() - 1, 0);)
+
+    for (size_t l=firstLevel; l<tree.levelCount(); l++){
+        MERKLE_SCOPE("level", &stats.levelNs[l - 1], int64_t(l));
+        hashLevel(tree.level(l - 1), tree.levelSize(l - 1), tree.level(l));
+    }
+}
+
+/**
+ * @note buildTree() builds the tree over leaves that are already hashed, e.g. file chunks
+ * @param leaves are the leaf digests
+ * @param count is the number of leaves, > 0
+ * @returns the flat tree
+*/
+FlatTree MerkleTree::buildTree(const Digest* leaves, size_t count){
+    assert(count > 0);
+
+    MERKLE_STATS_ONLY(stats = BuildStats(); HashCounters before = Stats::snapshot();)
+    MERKLE_SCOPE("buildTree", &stats.totalNs);
+
+    FlatTree tree(count, mode);
+    std::memcpy(tree.level(0), leaves, count * sizeof(Digest));
+    hashLevels(tree, 1);
+
+    MERKLE_STATS_ONLY(stats.counters = Stats::delta(before);)
+    return tree;
+}
+
+/**
+ * @note buildTree() builds the tree over byte ranges, e.g. the chunks returned by Chunker::split().
+ * Each range is one leaf, hashed in place without copying it into a string, through the cache when
+ * one is attached.
+ * @param chunks are the leaf byte ranges
+ * @returns the flat tree
+*/
+FlatTree MerkleTree::buildTree(std::span<const BatchMessage> chunks){
+    assert(chunks.size() > 0);
+
+    MERKLE_STATS_ONLY(stats = BuildStats(); HashCounters before = Stats::snapshot();)
+    MERKLE_SCOPE("buildTree", &stats.totalNs);
+
+    FlatTree tree(chunks.size(), mode);
+    {
+        MERKLE_SCOPE("leaves", &stats.leafNs);
+        hashMessages(chunks.data(), chunks.size(), tree.level(0));
+    }
+    hashLevels(tree, 1);
+
+    MERKLE_STATS_ONLY(stats.counters = Stats::delta(before);)
+    return tree;
+}
+
+/**
+ * @note buildTree() builds the tree on a thread pool. The leaves are cut into aligned blocks of
+ * subtreeLeaves (a power of two), and each block is one task that hashes its leaves and every level of
+ * its subtree. Blocks start at even indices on every level below their root, so they pair the same
+ * nodes as the sequential build. The last, possibly partial, block ends each of its levels, so it
+ * applies the same odd node rule. Once the subtree roots are done, the few levels above them are
+ * hashed on the calling thread. The result is bit for bit the same as buildTree(input).
+ * @param input is a vector of strings containing the data to be hashed
+ * @param pool is the thread pool to build on
+ * @param subtreeLeaves is the number of leaves per task, 0 picks about 8 tasks per worker
+ * @returns the flat tree
+*/
+FlatTree MerkleTree::buildTree(const vector<string>& input, ThreadPool& pool, size_t subtreeLeaves){
+    return buildParallel(input.size(), pool, subtreeLeaves, [&](size_t begin, size_t end, Digest* digests){
+        hashLeaves(input.begin() + begin, input.begin() + end, digests);
+    });
+}
+
+FlatTree MerkleTree::buildTree(std::span<const std::string_view> input, ThreadPool& pool, size_t subtreeLeaves){
+    return buildParallel(input.size(), pool, subtreeLeaves, [&](size_t begin, size_t end, Digest* digests){
+        hashLeaves(input.begin() + begin, input.begin() + end, digests);
+    });
+}
+
+/**
+ * @note buildParallel() is the parallel build behind both buildTree() overloads
+ * @param n is the number of leaves
+ * @param hashLeaves hashes leaves [begin, end) into digests
+*/
+FlatTree MerkleTree::buildParallel(size_t n, ThreadPool& pool, size_t subtreeLeaves, const std::function<void(size_t, size_t, Digest*)>& hashLeaves){
+    assert(n > 0);
+
+    if (subtreeLeaves == 0){
+        subtreeLeaves = std::bit_ceil(std::max<size_t>(1024, n / (8 * pool.size())));
+    }
+    assert(std::has_single_bit(subtreeLeaves));
+
+    MERKLE_STATS_ONLY(stats = BuildStats(); HashCounters before = Stats::snapshot(); uint64_t start = Stats::now();)
+    MERKLE_SCOPE("buildTree", &stats.totalNs);
+
+    FlatTree tree(n, mode);
+    size_t height = std::countr_zero(subtreeLeaves);
+    size_t subtreeLevels = std::min(height, tree.levelCount() - 1);
+    size_t numSubtrees = (n + subtreeLeaves - 1) / subtreeLeaves;
+
+    // build every subtree independently
+    pool.parallelFor(numSubtrees, 1, [&](size_t first, size_t last){
+        for (size_t j=first; j<last; j++){
+            MERKLE_SCOPE("subtree", nullptr, int64_t(j));
+            size_t begin = j * subtreeLeaves;
+            size_t end = std::min(n, begin + subtreeLeaves);
+            hashLeaves(begin, end, &tree.node(0, begin));
+
+            for (size_t l=1; l<=subtreeLevels; l++){
+                size_t childBegin = begin >> (l - 1);
+                size_t childEnd = ((end - 1) >> (l - 1)) + 1;
+                hashLevel(&tree.node(l - 1, childBegin), childEnd - childBegin, &tree.node(l, childBegin / 2));
             }
+        }
+    });
+
+    MERKLE_STATS_ONLY(stats.leafNs = Stats::now() - start;)
+
+    // combine the subtree roots
+    hashLevels(tree, subtreeLevels + 1);
+
+    MERKLE_STATS_ONLY(stats.counters = Stats::delta(before);)
+    return tree;
+}
+
+/**
+ * @note updateLeaf() replaces one leaf and rehashes the path from it to the root, O(log n) hashes
+ * through the same pair and lone-node kernels as a batch of updates
+ * @param tree is a tree built with this MerkleTree's mode
+ * @param index is the position of the leaf
+ * @param data is the new leaf data
+*/
+void MerkleTree::updateLeaf(FlatTree& tree, size_t index, const string& data){
+    assert(tree.hashMode() == mode);
+    assert(index < tree.leafCount());
+
+    BatchMessage msg = {reinterpret_cast<const uint8_t*>(data.data()), data.size()};
+    hashMessages(&msg, 1, &tree.node(0, index));
+    rehashPaths(tree, {index});
+}
+
+/**
+ * @note updateLeaves() replaces many leaves at once. The new leaves are hashed in one batch, then
+ * every dirty ancestor is rehashed exactly once, level by level, however many changed leaves share it.
+ * @param tree is a tree built with this MerkleTree's mode
+ * @param updates are (index, data) pairs, a later update of the same index wins
+ * @param pool spreads large levels across threads, nullptr hashes on the calling thread
+*/
+void MerkleTree::updateLeaves(FlatTree& tree, const vector<std::pair<size_t, string>>& updates, ThreadPool* pool){
+    assert(tree.hashMode() == mode);
+    if (updates.empty()){
+        return;
+    }
 
-            // push to temp vec
-            tempNodesVec.push_back(newNode);
+    vector<BatchMessage> msgs(updates.size());
+    vector<size_t> dirty(updates.size());
+    for (size_t k=0; k<updates.size(); k++){
+        assert(updates[k].first < tree.leafCount());
+        msgs[k] = {reinterpret_cast<const uint8_t*>(updates[k].second.data()), updates[k].second.size()};
+        dirty[k] = updates[k].first;
+    }
+
+    vector<Digest> digests(updates.size());
+    SHA256Batch::hash(msgs.data(), msgs.size(), reinterpret_cast<uint8_t*>(digests.data()));
+    for (size_t k=0; k<updates.size(); k++){
+        tree.node(0, updates[k].first) = digests[k];
+    }
+
+    rehashPaths(tree, std::move(dirty), pool);
+}
+
+/**
+ * @note appendLeaves() adds leaves to the right edge of the tree. The buffer grows geometrically, and
+ * only the new nodes and the old right edge they pair with are hashed.
+ * @param tree is a tree built with this MerkleTree's mode, or an empty FlatTree(mode)
+ * @param input are the new leaves
+ * @param pool spreads large levels across threads, nullptr hashes on the calling thread
+*/
+void MerkleTree::appendLeaves(FlatTree& tree, const vector<string>& input, ThreadPool* pool){
+    assert(tree.hashMode() == mode);
+    if (input.empty()){
+        return;
+    }
+
+    size_t n = tree.leafCount();
+    tree.resize(n + input.size());
+    hashLeaves(input.data(), input.size(), &tree.node(0, n));
+
+    // the old last leaf may have been hashed alone and now has a sibling
+    size_t first = (n == 0) ? 0 : n - 1;
+    vector<size_t> dirty(n + input.size() - first);
+    for (size_t k=0; k<dirty.size(); k++){
+        dirty[k] = first + k;
+    }
+
+    rehashPaths(tree, std::move(dirty), pool);
+}
+
+/**
+ * @note truncateLeaves() drops leaves from the right edge of the tree. Only the path above the new
+ * last leaf changes. The buffer keeps its capacity for later appends.
+ * @param tree is a tree built with this MerkleTree's mode
+ * @param leafCount is the number of leaves to keep, 0 < leafCount <= tree.leafCount()
+*/
+void MerkleTree::truncateLeaves(FlatTree& tree, size_t leafCount){
+    assert(tree.hashMode() == mode);
+    assert(leafCount > 0 && leafCount <= tree.leafCount());
+    if (leafCount == tree.leafCount()){
+        return;
+    }
+
+    tree.resize(leafCount);
+    rehashPaths(tree, {leafCount - 1});
+}
+
+/**
+ * @note rehashPaths() recomputes every ancestor of the dirty leaves. Each level's dirty parents are
+ * deduplicated and hashed in batches, so shared ancestors are hashed once.
+ * @param tree is a tree built with this MerkleTree's mode
+ * @param dirty are the positions of the changed leaves, in any order
+ * @param pool spreads large levels across threads, nullptr hashes on the calling thread
+*/
+void MerkleTree::rehashPaths(FlatTree& tree, vector<size_t> dirty, ThreadPool* pool){
+    std::sort(dirty.begin(), dirty.end());
+    dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+
+    // below this many parents a level is not worth splitting across threads
+    const size_t grain = 4096;
+
+    for (size_t l=1; l<tree.levelCount() && !dirty.empty(); l++){
+        for (size_t& i : dirty){
+            i = FlatTree::parent(i);
+        }
+        dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+
+        if (pool != nullptr && dirty.size() > grain){
+            pool->parallelFor(dirty.size(), grain, [&](size_t begin, size_t end){
+                rehashParents(tree, l, &dirty[begin], end - begin);
+            });
+        }
+        else {
+            rehashParents(tree, l, dirty.data(), dirty.size());
+        }
+    }
+}
+
+/**
+ * @note rehashParents() hashes a sorted list of nodes on one level from their children, pair by pair
+ * with hardware SHA and in one batch otherwise
+ * @param tree is the tree to update
+ * @param level is the level of the parents, > 0
+ * @param parents are the positions of the parents on that level
+ * @param count is the number of parents
+*/
+void MerkleTree::rehashParents(FlatTree& tree, size_t level, const size_t* parents, size_t count){
+
+    const Digest* children = tree.level(level - 1);
+    size_t numChildren = tree.levelSize(level - 1);
+
+    if (SHA256Pair::preferred()){
+        for (size_t k=0; k<count; k++){
+            size_t left = FlatTree::leftChild(parents[k]);
+            if (left + 1 < numChildren){
+                SHA256Pair::hashPair(children[left], children[left + 1], tree.node(level, parents[k]), mode);
+            }
+            else {
+                SHA256Pair::hashAlone(children[left], tree.node(level, parents[k]), mode);
+            }
         }
+        return;
+    }
+
+    vector<BatchMessage> msgs(count);
 
-        // reset nodesVec for next iter
-        nodesVec.clear();
-        for(int i=0; i<tempNodesVec.size(); i++){
-            nodesVec.push_back(tempNodesVec[i]);
+    // hex text of both children of every parent, only needed in hex mode
+    vector<char> hexText;
+    if (mode == HashMode::Hex){
+        hexText.resize(128 * count);
+    }
+
+    for (size_t k=0; k<count; k++){
+        size_t left = FlatTree::leftChild(parents[k]);
+        size_t pairSize = (left + 1 < numChildren) ? 2 : 1;
+        if (mode == HashMode::Hex){
+            for (size_t c=0; c<pairSize; c++){
+                SHA256::toHex(children[left + c].data(), 32, &hexText[128 * k + 64 * c]);
+            }
+            msgs[k] = {reinterpret_cast<const uint8_t*>(&hexText[128 * k]), 64 * pairSize};
+        }
+        else {
+            msgs[k] = {children[left].data(), 32 * pairSize};
         }
     }
 
-    return nodesVec[0]; // root node
-}
\ No newline at end of file
+    vector<Digest> digests(count);
+    SHA256Batch::hash(msgs.data(), msgs.size(), reinterpret_cast<uint8_t*>(digests.data()));
+    for (size_t k=0; k<count; k++){
+        tree.node(level, parents[k]) = digests[k];
+    }
+}
@@ -0,0 +1,193 @@
+#include "lib.hpp"
+
+// MerkleAccumulator.cpp
+
+// checkpoint header layout
+static constexpr char checkpointMagic[4] = {'M', 'A', 'C', 'C'};
+static constexpr uint8_t checkpointVersion = 1;
+static constexpr size_t checkpointHeader = 16;
+
+/**
+ * @note constructor creates an empty accumulator
+ * @param mode is the parent hashing scheme, must match the trees it is compared against
+*/
+MerkleAccumulator::MerkleAccumulator(HashMode mode) : mode(mode), count(0), frontier() {
+    sha256 = SHA256();
+}
+
+/**
+ * @note nodeHash() hashes a parent from its children, matching MerkleTree::hashLevel()
+ * @param left is the left child
+ * @param right is the right child, nullptr for a node hashed alone
+*/
+Digest MerkleAccumulator::nodeHash(const Digest& left, const Digest* right){
+
+    if (right != nullptr){
+        return SHA256Pair::hashPair(left, *right, mode);
+    }
+    return SHA256Pair::hashAlone(left, mode);
+}
+
+/**
+ * @note appendDigest() adds an already hashed leaf, merging equal height subtrees on the frontier
+ * @param leaf is the leaf digest
+*/
+void MerkleAccumulator::appendDigest(const Digest& leaf){
+    appendSubtree(leaf, 0);
+}
+
+/**
+ * @note appendSubtree() adds the root of a perfect subtree of 2^height leaves that were hashed
+ * elsewhere, e.g. by a worker thread. It lands on the frontier like a carry at that height.
+ * @param root is the root of the subtree
+ * @param height is its height, the leaf count must be a multiple of 2^height
+*/
+void MerkleAccumulator::appendSubtree(const Digest& root, size_t height){
+    assert(height < 64);
+    assert(count % (uint64_t(1) << height) == 0);
+    assert(count <= UINT64_MAX - (uint64_t(1) << height));
+
+    Digest carry = root;
+    size_t h = height;
+    while ((count >> h) & 1){
+        carry = nodeHash(frontier[h], &carry);
+        h++;
+    }
+    frontier[h] = carry;
+    count += uint64_t(1) << height;
+}
+
+/**
+ * @note append() hashes and adds one leaf
+*/
+void MerkleAccumulator::append(const uint8_t* data, size_t len){
+    Digest leaf;
+    sha256.init();
+    sha256.update(data, len);
+    sha256.final(leaf.data());
+    appendDigest(leaf);
+}
+
+void MerkleAccumulator::append(const string& data){
+    append(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+/**
+ * @note append() adds a batch of leaves, hashing them in one multi-buffer batch first
+*/
+void MerkleAccumulator::append(const vector<string>& input){
+    if (input.empty()){
+        return;
+    }
+
+    vector<BatchMessage> msgs(input.size());
+    for (size_t i=0; i<input.size(); i++){
+        msgs[i] = {reinterpret_cast<const uint8_t*>(input[i].data()), input[i].size()};
+    }
+
+    vector<Digest> leaves(input.size());
+    SHA256Batch::hash(msgs.data(), msgs.size(), reinterpret_cast<uint8_t*>(leaves.data()));
+    for (const Digest& leaf : leaves){
+        appendDigest(leaf);
+    }
+}
+
+/**
+ * @note root() folds the frontier into the root of the tree over all leaves so far. Walking up from
+ * height 0, carry is the last node of the current level when it covers the leaves right of the
+ * frontier subtree at that height. A subtree is hashed alone whenever it ends its level without a sibling.
+ * @returns the root, the accumulator must not be empty
+*/
+Digest MerkleAccumulator::root(){
+    assert(count > 0);
+
+    Digest carry;
+    bool hasCarry = false;
+
+    // stop at the level holding a single node
+    for (size_t h=0; ((count - 1) >> h) > 0; h++){
+        bool hasFrontier = (count >> h) & 1;
+        if (hasFrontier && hasCarry){
+            carry = nodeHash(frontier[h], &carry);
+        }
+        else if (hasFrontier){
+            carry = nodeHash(frontier[h], nullptr);
+            hasCarry = true;
+        }
+        else if (hasCarry){
+            carry = nodeHash(carry, nullptr);
+        }
+    }
+
+    // a perfect tree is its own highest frontier subtree
+    return hasCarry ? carry : frontier[std::countr_zero(count)];
+}
+
+/**
+ * @note rootHex() returns the root as a hex string
+*/
+string MerkleAccumulator::rootHex(){
+    Digest digest = root();
+    return SHA256::toHex(digest.data(), 32);
+}
+
+/**
+ * @note checkpoint() serializes the leaf count and frontier, see the class notice for the layout
+ * @returns the blob, 16 + 32 * popcount(leafCount) bytes
+*/
+vector<uint8_t> MerkleAccumulator::checkpoint() const {
+
+    vector<uint8_t> blob(checkpointHeader, 0);
+    std::memcpy(blob.data(), checkpointMagic, 4);
+    blob[4] = checkpointVersion;
+    blob[5] = static_cast<uint8_t>(mode);
+    for (size_t i=0; i<8; i++){
+        blob[8 + i] = static_cast<uint8_t>(count >> (8 * i));
+    }
+
+    for (size_t h=0; h<64; h++){
+        if ((count >> h) & 1){
+            blob.insert(blob.end(), frontier[h].begin(), frontier[h].end());
+        }
+    }
+
+    return blob;
+}
+
+/**
+ * @note restore() rebuilds an accumulator from a checkpoint blob
+ * @param blob is the output of checkpoint()
+ * @returns the accumulator, ready to take more leaves
+*/
+MerkleAccumulator MerkleAccumulator::restore(const vector<uint8_t>& blob){
+
+    if (blob.size() < checkpointHeader || std::memcmp(blob.data(), checkpointMagic, 4) != 0){
+        throw std::runtime_error("MerkleAccumulator: not a checkpoint");
+    }
+    if (blob[4] != checkpointVersion){
+        throw std::runtime_error("MerkleAccumulator: unsupported checkpoint version");
+    }
+    if (blob[5] > static_cast<uint8_t>(HashMode::Binary)){
+        throw std::runtime_error("MerkleAccumulator: unknown hash mode");
+    }
+
+    uint64_t count = 0;
+    for (size_t i=0; i<8; i++){
+        count |= static_cast<uint64_t>(blob[8 + i]) << (8 * i);
+    }
+    if (blob.size() != checkpointHeader + 32 * static_cast<size_t>(std::popcount(count))){
+        throw std::runtime_error("MerkleAccumulator: checkpoint size does not match leaf count");
+    }
+
+    MerkleAccumulator accumulator(static_cast<HashMode>(blob[5]));
+    accumulator.count = count;
+    const uint8_t* digest = blob.data() + checkpointHeader;
+    for (size_t h=0; h<64; h++){
+        if ((count >> h) & 1){
+            std::memcpy(accumulator.frontier[h].data(), digest, 32);
+            digest += 32;
+        }
+    }
+
+    return accumulator;
+}
@@ -0,0 +1,114 @@
+#include "lib.hpp"
+
+// MerkleDiff.cpp
+
+// below this many node pairs a level is not worth splitting across threads
+static constexpr size_t diffGrain = 4096;
+
+// output of comparing one slice of a level
+struct DiffChunk {
+    vector<size_t> next;
+    vector<std::pair<size_t, size_t>> ranges;
+    size_t visited = 0;
+    size_t pruned = 0;
+};
+
+/**
+ * @note appendRange() adds [begin, end) to a sorted range list, merging it with the last range when they touch
+*/
+static void appendRange(vector<std::pair<size_t, size_t>>& ranges, size_t begin, size_t end){
+    if (!ranges.empty() && ranges.back().second == begin){
+        ranges.back().second = end;
+    }
+    else {
+        ranges.push_back({begin, end});
+    }
+}
+
+/**
+ * @note diff() compares two trees and returns the leaf ranges that differ
+ * @param a is the first tree
+ * @param b is the second tree
+ * @param pool spreads levels with many differing nodes across threads, nullptr compares on the calling thread
+ * @returns the differing ranges and descent statistics
+*/
+DiffResult MerkleDiff::diff(const FlatTree& a, const FlatTree& b, ThreadPool* pool){
+
+    DiffResult result = {};
+    size_t common = std::min(a.leafCount(), b.leafCount());
+    size_t longest = std::max(a.leafCount(), b.leafCount());
+
+    // every node visited covers at least one leaf of the common prefix, so it exists in both trees
+    // on every level both trees have
+    vector<size_t> candidates;
+    if (common > 0){
+        candidates.push_back(0);
+    }
+
+    size_t top = std::max(a.levelCount(), b.levelCount());
+    for (size_t l=top; l-- > 0 && !candidates.empty();){
+
+        auto compare = [&](size_t begin, size_t end, DiffChunk& chunk){
+            for (size_t k=begin; k<end; k++){
+                size_t i = candidates[k];
+                chunk.visited++;
+
+                if (l == 0){
+                    if (a.node(0, i) != b.node(0, i)){
+                        appendRange(chunk.ranges, i, i + 1);
+                    }
+                    continue;
+                }
+
+                // equal only if both trees have the node and it covers the same leaves in each
+                size_t coverEnd = (i + 1) << l;
+                bool comparable = l < a.levelCount() && l < b.levelCount() &&
+                                  std::min(coverEnd, a.leafCount()) == std::min(coverEnd, b.leafCount());
+                if (comparable && a.node(l, i) == b.node(l, i)){
+                    chunk.pruned++;
+                    continue;
+                }
+
+                for (size_t child : {FlatTree::leftChild(i), FlatTree::rightChild(i)}){
+                    if ((child << (l - 1)) < common){
+                        chunk.next.push_back(child);
+                    }
+                }
+            }
+        };
+
+        size_t numChunks = (pool != nullptr && candidates.size() > diffGrain) ? (candidates.size() + diffGrain - 1) / diffGrain : 1;
+        vector<DiffChunk> chunks(numChunks);
+        if (numChunks == 1){
+            compare(0, candidates.size(), chunks[0]);
+        }
+        else {
+            pool->parallelFor(numChunks, 1, [&](size_t first, size_t last){
+                for (size_t c=first; c<last; c++){
+                    compare(c * diffGrain, std::min(candidates.size(), (c + 1) * diffGrain), chunks[c]);
+                }
+            });
+        }
+
+        // chunks cover consecutive slices, so concatenating keeps everything sorted
+        vector<size_t> next;
+        for (DiffChunk& chunk : chunks){
+            next.insert(next.end(), chunk.next.begin(), chunk.next.end());
+            for (const auto& [begin, end] : chunk.ranges){
+                appendRange(result.ranges, begin, end);
+            }
+            result.nodesVisited += chunk.visited;
+            result.subtreesPruned += chunk.pruned;
+        }
+        candidates.swap(next);
+    }
+
+    if (longest > common){
+        appendRange(result.ranges, common, longest);
+    }
+    for (const auto& [begin, end] : result.ranges){
+        result.differingLeaves += end - begin;
+    }
+
+    return result;
+}
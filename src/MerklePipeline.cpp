@@ -0,0 +1,299 @@
+#include "lib.hpp"
+
+// MerklePipeline.cpp
+
+/**
+ * @note constructor sets up a pipeline, threads are only started by start()
+ * @param mode is the parent hashing scheme
+ * @param numHashers is the number of leaf hashing threads, 0 for one per hardware thread
+*/
+MerklePipeline::MerklePipeline(HashMode mode, size_t numHashers)
+    : mode(mode), batchBytes(size_t(4) << 20), queueDepth(8), numHashers(numHashers), leaves(0), activeHashers(0), failed(false) {
+    if (this->numHashers == 0){
+        this->numHashers = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+}
+
+MerklePipeline::~MerklePipeline(){
+    wait();
+}
+
+/**
+ * @note start() launches the reader, the hashers and the combiner on a stream. A run still going
+ * is waited for first.
+ * @param in is the record stream, read until its end
+ * @param format is the record framing
+ * @returns the future root
+*/
+std::future<Digest> MerklePipeline::start(std::istream& in, RecordFormat format){
+    assert(batchBytes > 0 && queueDepth > 0);
+    wait();
+
+    batches = std::make_unique<BoundedQueue<std::unique_ptr<Batch>>>(queueDepth);
+    results = std::make_unique<BoundedQueue<std::unique_ptr<Subtrees>>>(queueDepth);
+    activeHashers.store(numHashers);
+    readError = nullptr;
+    hashError = nullptr;
+    failed.store(false);
+    leaves = 0;
+
+    std::promise<Digest> promise;
+    std::future<Digest> root = promise.get_future();
+    threads.emplace_back(&MerklePipeline::readStage, this, std::ref(in), format);
+    for (size_t i=0; i<numHashers; i++){
+        threads.emplace_back(&MerklePipeline::hashStage, this);
+    }
+    threads.emplace_back(&MerklePipeline::combineStage, this, std::move(promise));
+    return root;
+}
+
+/**
+ * @note start() opens a file and starts hashing it, throws std::runtime_error if it cannot be opened
+*/
+std::future<Digest> MerklePipeline::start(const string& path, RecordFormat format){
+    wait();
+    file = std::make_unique<std::ifstream>(path, ios::binary);
+    if (!*file){
+        throw std::runtime_error("MerklePipeline: cannot open " + path);
+    }
+    return start(*file, format);
+}
+
+void MerklePipeline::wait(){
+    for (std::thread& thread : threads){
+        thread.join();
+    }
+    threads.clear();
+}
+
+/**
+ * @note splitRecords() indexes the whole records in a batch's bytes
+ * @param batch is the batch, its records must be empty
+ * @param format is the record framing
+ * @param last tells that no more bytes follow, so an unterminated line is a record
+ * @returns the number of bytes the records take, the rest starts the next batch
+*/
+size_t MerklePipeline::splitRecords(Batch& batch, RecordFormat format, bool last){
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(batch.bytes.data());
+    size_t size = batch.bytes.size();
+    size_t offset = 0;
+
+    if (format == RecordFormat::Lines){
+        while (offset < size){
+            const void* newline = std::memchr(data + offset, '\n', size - offset);
+            if (newline == nullptr){
+                if (!last){
+                    break;
+                }
+                batch.records.push_back({data + offset, size - offset});
+                return size;
+            }
+            size_t end = size_t(static_cast<const uint8_t*>(newline) - data);
+            batch.records.push_back({data + offset, end - offset});
+            offset = end + 1;
+        }
+        return offset;
+    }
+
+    while (size - offset >= 4){
+        size_t len = 0;
+        for (size_t i=0; i<4; i++){
+            len |= size_t(data[offset + i]) << (8 * i);
+        }
+        if (len > size - offset - 4){
+            break;
+        }
+        batch.records.push_back({data + offset + 4, len});
+        offset += 4 + len;
+    }
+    if (last && offset < size){
+        throw std::runtime_error("MerklePipeline: truncated record at the end of the stream");
+    }
+    return offset;
+}
+
+/**
+ * @note readStage() cuts the stream into batches of whole records. The bytes after the last whole
+ * record of a batch start the next one. A record longer than batchBytes grows its batch until it fits.
+*/
+void MerklePipeline::readStage(std::istream& in, RecordFormat format){
+    try {
+        uint64_t nextLeaf = 0;
+        string carry;
+        bool eof = false;
+        while (!eof && !failed.load(std::memory_order_acquire)){
+            auto batch = std::make_unique<Batch>();
+            batch->bytes = std::move(carry);
+            size_t target = batchBytes;
+            size_t used = 0;
+            while (true){
+                while (batch->bytes.size() < target && !eof){
+                    size_t old = batch->bytes.size();
+                    batch->bytes.resize(target);
+                    in.read(batch->bytes.data() + old, std::streamsize(target - old));
+                    batch->bytes.resize(old + size_t(in.gcount()));
+                    if (in.bad()){
+                        throw std::runtime_error("MerklePipeline: read error");
+                    }
+                    eof = !in;
+                }
+                used = splitRecords(*batch, format, eof);
+                if (!batch->records.empty() || eof){
+                    break;
+                }
+                target += batchBytes;
+            }
+
+            // the records view into bytes, so the tail is copied out instead of erased
+            carry.assign(batch->bytes, used);
+            if (batch->records.empty()){
+                break;
+            }
+            batch->firstLeaf = nextLeaf;
+            nextLeaf += batch->records.size();
+            batches->push(std::move(batch));
+        }
+    }
+    catch (...){
+        readError = std::current_exception();
+    }
+    batches->close();
+}
+
+/**
+ * @note reduce() hashes a batch's leaves and folds them into the roots of aligned perfect
+ * subtrees. Starting at the batch's first leaf, it takes the largest subtree that starts at a
+ * multiple of its own width and fits in the batch. Such a subtree is a node of the full tree,
+ * so its root can be appended to the accumulator as is.
+*/
+void MerklePipeline::reduce(const Batch& batch, MerkleTree& tree, Subtrees& out, vector<Digest>& leafDigests, vector<Digest>& scratch){
+    size_t n = batch.records.size();
+    leafDigests.resize(n);
+    SHA256Batch::hash(batch.records.data(), n, reinterpret_cast<uint8_t*>(leafDigests.data()));
+
+    out.firstLeaf = batch.firstLeaf;
+    out.leafCount = n;
+    out.roots.clear();
+
+    uint64_t position = batch.firstLeaf;
+    size_t index = 0;
+    while (index < n){
+        size_t height = std::bit_width(n - index) - 1;
+        if (position != 0){
+            height = std::min<size_t>(height, std::countr_zero(position));
+        }
+        size_t width = size_t(1) << height;
+
+        // levels of the subtree back to back in scratch, halving each time
+        const Digest* level = &leafDigests[index];
+        scratch.resize(std::max(scratch.size(), width));
+        Digest* parents = scratch.data();
+        for (size_t count=width; count>1; count/=2){
+            tree.hashLevel(level, count, parents);
+            level = parents;
+            parents += count / 2;
+        }
+        out.roots.push_back({*level, uint8_t(height)});
+
+        index += width;
+        position += width;
+    }
+}
+
+/**
+ * @note hashStage() hashes batches until the reader is done. The last hasher to finish closes the
+ * queue to the combiner. An exception is kept for the combiner, and from then on every hasher only
+ * drains the batches, so the reader is never left blocked on a full queue.
+*/
+void MerklePipeline::hashStage(){
+    MerkleTree tree(mode);
+    vector<Digest> leafDigests;
+    vector<Digest> scratch;
+
+    std::unique_ptr<Batch> batch;
+    while (batches->pop(batch)){
+        if (failed.load(std::memory_order_acquire)){
+            batch.reset();
+            continue;
+        }
+        try {
+            auto subtrees = std::make_unique<Subtrees>();
+            reduce(*batch, tree, *subtrees, leafDigests, scratch);
+            batch.reset();
+            results->push(std::move(subtrees));
+        }
+        catch (...){
+            batch.reset();
+            std::lock_guard<std::mutex> guard(errorLock);
+            if (!hashError){
+                hashError = std::current_exception();
+            }
+            failed.store(true, std::memory_order_release);
+        }
+    }
+    if (activeHashers.fetch_sub(1) == 1){
+        results->close();
+    }
+}
+
+/**
+ * @note combineStage() appends subtree roots in leaf order. Batches finish out of order, so a
+ * finished batch waits in pending until every batch before it is appended. After an exception the
+ * combiner stops the reader and only drains the results, so no hasher is left blocked.
+*/
+void MerklePipeline::combineStage(std::promise<Digest> promise){
+    MerkleAccumulator accumulator(mode);
+    std::map<uint64_t, std::unique_ptr<Subtrees>> pending;
+    uint64_t nextLeaf = 0;
+    std::exception_ptr combineError;
+
+    std::unique_ptr<Subtrees> subtrees;
+    while (results->pop(subtrees)){
+        if (combineError){
+            subtrees.reset();
+            continue;
+        }
+        try {
+            uint64_t firstLeaf = subtrees->firstLeaf;
+            pending.emplace(firstLeaf, std::move(subtrees));
+            while (!pending.empty() && pending.begin()->first == nextLeaf){
+                const Subtrees& ready = *pending.begin()->second;
+                for (const auto& [root, height] : ready.roots){
+                    accumulator.appendSubtree(root, height);
+                }
+                nextLeaf += ready.leafCount;
+                pending.erase(pending.begin());
+            }
+        }
+        catch (...){
+            subtrees.reset();
+            pending.clear();
+            combineError = std::current_exception();
+            failed.store(true, std::memory_order_release);
+        }
+    }
+    leaves = nextLeaf;
+
+    try {
+        if (readError){
+            std::rethrow_exception(readError);
+        }
+        if (hashError){
+            std::rethrow_exception(hashError);
+        }
+        if (combineError){
+            std::rethrow_exception(combineError);
+        }
+        if (nextLeaf == 0){
+            throw std::runtime_error("MerklePipeline: no records in the input");
+        }
+        Digest root = accumulator.root();
+        if (onComplete){
+            onComplete(root, nextLeaf);
+        }
+        promise.set_value(root);
+    }
+    catch (...){
+        promise.set_exception(std::current_exception());
+    }
+}
@@ -0,0 +1,340 @@
+#include "lib.hpp"
+
+// MerkleProof.cpp
+
+/**
+ * @note constructor sets the hash mode proofs are generated and checked with
+ * @param mode must match the mode of the tree being proven
+*/
+MerkleProof::MerkleProof(HashMode mode){
+    sha256 = SHA256();
+    this->mode = mode;
+}
+
+/**
+ * @note leafHash() hashes leaf data the way MerkleTree hashes its inputs
+*/
+Digest MerkleProof::leafHash(const uint8_t* data, size_t len){
+    Digest digest;
+    sha256.init();
+    sha256.update(data, len);
+    sha256.final(digest.data());
+    return digest;
+}
+
+Digest MerkleProof::leafHash(const string& data){
+    return leafHash(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+/**
+ * @note nodeHash() hashes a parent from its children, matching MerkleTree::hashLevel()
+ * @param left is the left child
+ * @param right is the right child, nullptr for a node hashed alone
+*/
+Digest MerkleProof::nodeHash(const Digest& left, const Digest* right){
+
+    if (right != nullptr){
+        return SHA256Pair::hashPair(left, *right, mode);
+    }
+    return SHA256Pair::hashAlone(left, mode);
+}
+
+/**
+ * @note provePath() collects the audit path of one leaf from any tree with FlatTree's shape and node accessors
+ * @param tree is the tree to prove against
+ * @param leafIndex is the position of the leaf
+ * @returns the audit path, one step per level below the root
+*/
+template <class Tree>
+static AuditPath provePath(const Tree& tree, size_t leafIndex){
+    assert(leafIndex < tree.leafCount());
+
+    AuditPath path;
+    path.leafIndex = leafIndex;
+    path.leafCount = tree.leafCount();
+
+    size_t i = leafIndex;
+    for (size_t l=0; l+1<tree.levelCount(); l++){
+        ProofStep step = {};
+        if (i % 2 == 1){
+            step.sibling = tree.node(l, i - 1);
+            step.siblingOnLeft = true;
+        }
+        else if (i + 1 < tree.levelSize(l)){
+            step.sibling = tree.node(l, i + 1);
+        }
+        else {
+            step.alone = true;
+        }
+        path.steps.push_back(step);
+        i = FlatTree::parent(i);
+    }
+
+    return path;
+}
+
+/**
+ * @note prove() collects the audit path of one leaf, from memory or straight from a mapped tree file
+*/
+AuditPath MerkleProof::prove(const FlatTree& tree, size_t leafIndex){
+    return provePath(tree, leafIndex);
+}
+
+AuditPath MerkleProof::prove(const TreeFile& tree, size_t leafIndex){
+    return provePath(tree, leafIndex);
+}
+
+/**
+ * @note computeRoot() folds an audit path into the root it implies. Every step's flags are checked
+ * against the position the leaf index and leaf count put the node in.
+ * @param leaf is the digest of the leaf
+ * @param path is the audit path of the leaf
+ * @param root receives the computed root
+ * @returns false if the path is malformed for its leaf index and leaf count
+*/
+bool MerkleProof::computeRoot(const Digest& leaf, const AuditPath& path, Digest& root){
+    if (path.leafCount == 0 || path.leafIndex >= path.leafCount){
+        return false;
+    }
+
+    Digest node = leaf;
+    size_t i = path.leafIndex;
+    size_t size = path.leafCount;
+    for (const ProofStep& step : path.steps){
+
+        // too many steps, or flags that do not match the node's position
+        if (size == 1){
+            return false;
+        }
+        bool alone = (i % 2 == 0) && (i + 1 == size);
+        bool siblingOnLeft = (i % 2 == 1);
+        if (step.alone != alone || step.siblingOnLeft != siblingOnLeft){
+            return false;
+        }
+
+        if (alone){
+            node = nodeHash(node, nullptr);
+        }
+        else if (siblingOnLeft){
+            node = nodeHash(step.sibling, &node);
+        }
+        else {
+            node = nodeHash(node, &step.sibling);
+        }
+
+        i = FlatTree::parent(i);
+        size = (size + 1) / 2;
+    }
+
+    // too few steps
+    if (size != 1){
+        return false;
+    }
+
+    root = node;
+    return true;
+}
+
+/**
+ * @note computeRoot() folds a compact audit path into the root it implies. The compact form has
+ * only the siblings, the steps' sides and alone nodes follow from the leaf index and leaf count.
+ * This is the form ProofCodec sends, and siblings can point into a receive buffer.
+ * @returns false if the number of siblings does not match the leaf's position
+*/
+bool MerkleProof::computeRoot(const Digest& leaf, size_t leafIndex, size_t leafCount, std::span<const Digest> siblings, Digest& root){
+    if (leafCount == 0 || leafIndex >= leafCount){
+        return false;
+    }
+
+    Digest node = leaf;
+    size_t used = 0;
+    for (size_t i=leafIndex, size=leafCount; size>1; i=FlatTree::parent(i), size=(size + 1)/2){
+        if (i % 2 == 0 && i + 1 == size){
+            node = nodeHash(node, nullptr);
+            continue;
+        }
+        if (used == siblings.size()){
+            return false;
+        }
+        const Digest& sibling = siblings[used++];
+        node = (i % 2 == 1) ? nodeHash(sibling, &node) : nodeHash(node, &sibling);
+    }
+    if (used != siblings.size()){
+        return false;
+    }
+
+    root = node;
+    return true;
+}
+
+/**
+ * @note verify() checks that a leaf is included in the tree with the given root
+*/
+bool MerkleProof::verify(const Digest& leaf, const AuditPath& path, const Digest& root){
+    Digest computed;
+    return computeRoot(leaf, path, computed) && computed == root;
+}
+
+bool MerkleProof::verify(const string& leafData, const AuditPath& path, const Digest& root){
+    return verify(leafHash(leafData), path, root);
+}
+
+/**
+ * @note proveSet() builds one proof for a set of leaves. Walking up level by level, a proven node
+ * needs its sibling only if the sibling is not itself proven (or derived from proven nodes below).
+ * Nodes hashed alone need no sibling.
+ * @param tree is the tree to prove against
+ * @param leafIndices are the positions of the leaves, in any order
+ * @returns the multiproof
+*/
+template <class Tree>
+static MultiProof proveSet(const Tree& tree, vector<size_t> leafIndices){
+    assert(!leafIndices.empty());
+
+    std::sort(leafIndices.begin(), leafIndices.end());
+    leafIndices.erase(std::unique(leafIndices.begin(), leafIndices.end()), leafIndices.end());
+    assert(leafIndices.back() < tree.leafCount());
+
+    MultiProof proof;
+    proof.leafCount = tree.leafCount();
+    proof.leafIndices = leafIndices;
+
+    vector<size_t> known = leafIndices;
+    for (size_t l=0; l+1<tree.levelCount(); l++){
+        size_t size = tree.levelSize(l);
+        vector<size_t> next;
+        for (size_t k=0; k<known.size(); k++){
+            size_t i = known[k];
+            if (i % 2 == 1){
+                proof.siblings.push_back(tree.node(l, i - 1));
+            }
+            else if (i + 1 < size){
+                if (k + 1 < known.size() && known[k + 1] == i + 1){
+                    k++;
+                }
+                else {
+                    proof.siblings.push_back(tree.node(l, i + 1));
+                }
+            }
+            next.push_back(FlatTree::parent(i));
+        }
+        known.swap(next);
+    }
+
+    return proof;
+}
+
+/**
+ * @note proveMany() builds one multiproof for a set of leaves, from memory or a mapped tree file
+*/
+MultiProof MerkleProof::proveMany(const FlatTree& tree, vector<size_t> leafIndices){
+    return proveSet(tree, std::move(leafIndices));
+}
+
+MultiProof MerkleProof::proveMany(const TreeFile& tree, vector<size_t> leafIndices){
+    return proveSet(tree, std::move(leafIndices));
+}
+
+/**
+ * @note computeRoot() recomputes the root from the proven leaves and the multiproof siblings
+ * @param leaves are the digests of the proven leaves, in the order of proof.leafIndices
+ * @param proof is the multiproof
+ * @param root receives the computed root
+ * @returns false if the proof is malformed or does not use exactly its siblings
+*/
+bool MerkleProof::computeRoot(const vector<Digest>& leaves, const MultiProof& proof, Digest& root){
+    return computeRoot(leaves, proof.leafCount, proof.leafIndices, proof.siblings, root);
+}
+
+/**
+ * @note computeRoot() recomputes the root of a multiproof given as views, e.g. the siblings of a
+ * proof decoded by ProofCodec in place
+ * @param leaves are the digests of the proven leaves, in the order of leafIndices
+ * @param leafCount is the number of leaves in the tree
+ * @param leafIndices are the proven positions, strictly increasing
+ * @param siblings are the multiproof siblings in the order the verifier consumes them
+*/
+bool MerkleProof::computeRoot(std::span<const Digest> leaves, size_t leafCount, std::span<const size_t> leafIndices,
+                              std::span<const Digest> siblings, Digest& root){
+    if (leaves.empty() || leaves.size() != leafIndices.size()){
+        return false;
+    }
+    for (size_t k=0; k<leafIndices.size(); k++){
+        if (leafIndices[k] >= leafCount || (k > 0 && leafIndices[k] <= leafIndices[k - 1])){
+            return false;
+        }
+    }
+
+    vector<std::pair<size_t, Digest>> known(leaves.size());
+    for (size_t k=0; k<leaves.size(); k++){
+        known[k] = {leafIndices[k], leaves[k]};
+    }
+
+    size_t used = 0;
+    size_t size = leafCount;
+    while (size > 1){
+        vector<std::pair<size_t, Digest>> next;
+        for (size_t k=0; k<known.size(); k++){
+            auto& [i, digest] = known[k];
+            Digest parent;
+            if (i % 2 == 0 && i + 1 == size){
+                parent = nodeHash(digest, nullptr);
+            }
+            else if (i % 2 == 0 && k + 1 < known.size() && known[k + 1].first == i + 1){
+                parent = nodeHash(digest, &known[k + 1].second);
+                k++;
+            }
+            else {
+                if (used == siblings.size()){
+                    return false;
+                }
+                const Digest& sibling = siblings[used++];
+                parent = (i % 2 == 1) ? nodeHash(sibling, &digest) : nodeHash(digest, &sibling);
+            }
+            next.push_back({FlatTree::parent(i), parent});
+        }
+        known.swap(next);
+        size = (size + 1) / 2;
+    }
+
+    // every shipped sibling must have been consumed
+    if (used != siblings.size()){
+        return false;
+    }
+
+    root = known[0].second;
+    return true;
+}
+
+/**
+ * @note verifyMany() checks that all proven leaves are included in the tree with the given root
+*/
+bool MerkleProof::verifyMany(const vector<Digest>& leaves, const MultiProof& proof, const Digest& root){
+    Digest computed;
+    return computeRoot(leaves, proof, computed) && computed == root;
+}
+
+/**
+ * @note verifyBatch() checks many single leaf proofs against one root on a thread pool. Each task
+ * verifies a range of proofs with its own MerkleProof, reusing its hashing context.
+ * @param leaves are the leaf digests, one per path
+ * @param paths are the audit paths
+ * @param root is the expected root
+ * @param pool is the thread pool to verify on
+ * @returns one entry per proof, 1 if it verified and 0 otherwise
+*/
+vector<uint8_t> MerkleProof::verifyBatch(const vector<Digest>& leaves, const vector<AuditPath>& paths,
+                                         const Digest& root, ThreadPool& pool){
+    assert(leaves.size() == paths.size());
+
+    vector<uint8_t> results(paths.size(), 0);
+    HashMode proofMode = mode;
+    pool.parallelFor(paths.size(), 256, [&](size_t begin, size_t end){
+        MerkleProof verifier(proofMode);
+        for (size_t i=begin; i<end; i++){
+            results[i] = verifier.verify(leaves[i], paths[i], root) ? 1 : 0;
+        }
+    });
+
+    return results;
+}
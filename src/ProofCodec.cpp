@@ -0,0 +1,373 @@
+#include "lib.hpp"
+
+// ProofCodec.cpp
+
+// version, kind, and a body length of at most 10 bytes
+static constexpr size_t maxHeader = 12;
+
+/**
+ * @note WireReader walks a message body. Every read is bounds checked and throws on malformed input.
+*/
+class WireReader {
+    public:
+        WireReader(const uint8_t* data, size_t len) : data(data), left(len) {}
+
+        uint8_t byte(){
+            need(1);
+            left--;
+            return *data++;
+        }
+
+        uint64_t varint(){
+            uint64_t value;
+            size_t read = ProofCodec::getVarint(data, left, value);
+            if (read == 0){
+                fail("bad varint");
+            }
+            data += read;
+            left -= read;
+            return value;
+        }
+
+        std::span<const Digest> digests(uint64_t count){
+            if (count > left / sizeof(Digest)){
+                fail("digests past the end of the body");
+            }
+            std::span<const Digest> view(reinterpret_cast<const Digest*>(data), size_t(count));
+            data += count * sizeof(Digest);
+            left -= count * sizeof(Digest);
+            return view;
+        }
+
+        void finish() const {
+            if (left != 0){
+                fail("trailing bytes in the body");
+            }
+        }
+
+        [[noreturn]] static void fail(const string& reason){
+            throw std::runtime_error("ProofCodec: " + reason);
+        }
+
+    private:
+        const uint8_t* data;
+        size_t left;
+
+        void need(size_t n) const {
+            if (left < n){
+                fail("truncated body");
+            }
+        }
+};
+
+/**
+ * @note putVarint() writes value as an unsigned LEB128 varint, 7 bits per byte, low bits first
+ * @returns the number of bytes written, at most 10
+*/
+size_t ProofCodec::putVarint(uint64_t value, uint8_t* out){
+    size_t n = 0;
+    while (value >= 0x80){
+        out[n++] = uint8_t(value) | 0x80;
+        value >>= 7;
+    }
+    out[n++] = uint8_t(value);
+    return n;
+}
+
+/**
+ * @note getVarint() reads an unsigned LEB128 varint. Only the shortest encoding of a value is
+ * accepted, so every value has exactly one encoding.
+*/
+size_t ProofCodec::getVarint(const uint8_t* in, size_t len, uint64_t& value){
+    value = 0;
+    for (size_t i=0; i<len && i<10; i++){
+        uint8_t b = in[i];
+        if (i == 9 && b > 1){
+            return 0;
+        }
+        value |= uint64_t(b & 0x7f) << (7 * i);
+        if ((b & 0x80) == 0){
+            return (i > 0 && b == 0) ? 0 : i + 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @note beginMessage() reserves room for a header and returns where the body starts, endMessage()
+ * writes the header in front of the body once its length is known
+*/
+static size_t beginMessage(vector<uint8_t>& out, size_t bodySize){
+    size_t start = out.size();
+    out.resize(start + 2 + ProofCodec::varintSize(bodySize) + bodySize);
+    return start;
+}
+
+static uint8_t* writeHeader(uint8_t* out, WireKind kind, size_t bodySize){
+    out[0] = ProofCodec::version;
+    out[1] = static_cast<uint8_t>(kind);
+    return out + 2 + ProofCodec::putVarint(bodySize, out + 2);
+}
+
+/**
+ * @note openMessage() checks a message header and returns a reader over its body
+ * @param total receives the size of the whole message
+*/
+static WireReader openMessage(std::span<const uint8_t> bytes, WireKind kind, size_t& total){
+    if (bytes.size() < 3){
+        WireReader::fail("truncated header");
+    }
+    if (bytes[0] != ProofCodec::version){
+        WireReader::fail("unsupported version");
+    }
+    if (bytes[1] != static_cast<uint8_t>(kind)){
+        WireReader::fail("unexpected message kind");
+    }
+
+    uint64_t bodySize;
+    size_t read = ProofCodec::getVarint(bytes.data() + 2, std::min(bytes.size(), maxHeader) - 2, bodySize);
+    if (read == 0){
+        WireReader::fail("bad body length");
+    }
+    size_t header = 2 + read;
+    if (bodySize > bytes.size() - header){
+        WireReader::fail("body past the end of the buffer");
+    }
+    total = header + size_t(bodySize);
+    return WireReader(bytes.data() + header, size_t(bodySize));
+}
+
+WireKind ProofCodec::peekKind(std::span<const uint8_t> bytes){
+    if (bytes.size() < 2 || bytes[0] != version || bytes[1] < 1 || bytes[1] > 3){
+        WireReader::fail("unknown message");
+    }
+    return static_cast<WireKind>(bytes[1]);
+}
+
+/**
+ * @note siblingCount() returns how many siblings the audit path of a leaf has, one per level below
+ * the root except where the node is hashed alone. Above the level where the leaf's ancestors join
+ * the path of the last leaf, the node is the last on its level, and it is alone exactly where the
+ * last leaf's index has a 0 bit. So the count is that level plus the 1 bits above it.
+*/
+static uint64_t siblingCount(uint64_t leafIndex, uint64_t leafCount){
+    uint64_t last = leafCount - 1;
+    int join = std::bit_width(leafIndex ^ last);
+    return join + (join < 64 ? std::popcount(last >> join) : 0);
+}
+
+/**
+ * @note encode() appends an audit path. Only the siblings of steps that have one are sent.
+*/
+void ProofCodec::encode(const AuditPath& path, vector<uint8_t>& out){
+    size_t siblings = 0;
+    for (const ProofStep& step : path.steps){
+        siblings += step.alone ? 0 : 1;
+    }
+    size_t bodySize = varintSize(path.leafIndex) + varintSize(path.leafCount) + varintSize(siblings) + 32 * siblings;
+
+    size_t start = beginMessage(out, bodySize);
+    uint8_t* p = writeHeader(&out[start], WireKind::AuditPath, bodySize);
+    p += putVarint(path.leafIndex, p);
+    p += putVarint(path.leafCount, p);
+    p += putVarint(siblings, p);
+    for (const ProofStep& step : path.steps){
+        if (!step.alone){
+            std::memcpy(p, step.sibling.data(), 32);
+            p += 32;
+        }
+    }
+}
+
+/**
+ * @note decode() reads an audit path and checks that it has exactly the siblings its position needs
+*/
+size_t ProofCodec::decode(std::span<const uint8_t> bytes, AuditPathView& path){
+    size_t total;
+    WireReader body = openMessage(bytes, WireKind::AuditPath, total);
+    path.leafIndex = body.varint();
+    path.leafCount = body.varint();
+    if (path.leafCount == 0 || path.leafIndex >= path.leafCount){
+        WireReader::fail("leaf index out of range");
+    }
+    uint64_t count = body.varint();
+    if (count != siblingCount(path.leafIndex, path.leafCount)){
+        WireReader::fail("sibling count does not match the leaf position");
+    }
+    path.siblings = body.digests(count);
+    body.finish();
+    return total;
+}
+
+/**
+ * @note encode() appends a multiproof, with its sorted indices sent as gaps
+*/
+void ProofCodec::encode(const MultiProof& proof, vector<uint8_t>& out){
+    size_t bodySize = varintSize(proof.leafCount) + varintSize(proof.leafIndices.size());
+    for (size_t k=0; k<proof.leafIndices.size(); k++){
+        bodySize += varintSize(proof.leafIndices[k] - (k > 0 ? proof.leafIndices[k - 1] : 0));
+    }
+    bodySize += varintSize(proof.siblings.size()) + 32 * proof.siblings.size();
+
+    size_t start = beginMessage(out, bodySize);
+    uint8_t* p = writeHeader(&out[start], WireKind::MultiProof, bodySize);
+    p += putVarint(proof.leafCount, p);
+    p += putVarint(proof.leafIndices.size(), p);
+    for (size_t k=0; k<proof.leafIndices.size(); k++){
+        p += putVarint(proof.leafIndices[k] - (k > 0 ? proof.leafIndices[k - 1] : 0), p);
+    }
+    p += putVarint(proof.siblings.size(), p);
+
+    // a proof of every leaf has no siblings, and memcpy must not be given their null data()
+    if (!proof.siblings.empty()){
+        std::memcpy(p, proof.siblings.data(), 32 * proof.siblings.size());
+    }
+}
+
+/**
+ * @note decode() reads a multiproof. The indices must be strictly increasing and inside the tree.
+ * Whether the siblings are exactly the ones needed is checked by MerkleProof::computeRoot().
+*/
+size_t ProofCodec::decode(std::span<const uint8_t> bytes, MultiProofView& proof){
+    size_t total;
+    WireReader body = openMessage(bytes, WireKind::MultiProof, total);
+    proof.leafCount = body.varint();
+    uint64_t count = body.varint();
+    if (count == 0 || count > proof.leafCount){
+        WireReader::fail("bad index count");
+    }
+
+    proof.leafIndices.clear();
+    uint64_t index = 0;
+    for (uint64_t k=0; k<count; k++){
+        uint64_t gap = body.varint();
+        if ((k > 0 && gap == 0) || gap >= proof.leafCount - index){
+            WireReader::fail("leaf indices not increasing inside the tree");
+        }
+        index += gap;
+        proof.leafIndices.push_back(size_t(index));
+    }
+    proof.siblings = body.digests(body.varint());
+    body.finish();
+    return total;
+}
+
+/**
+ * @note subtreeRange() returns the nodes of level l under the node (level, index)
+*/
+static std::pair<uint64_t, uint64_t> subtreeRange(uint64_t leafCount, uint64_t level, uint64_t index, uint64_t l){
+    uint64_t levelSize = ((leafCount - 1) >> l) + 1;
+    uint64_t begin = index << (level - l);
+    uint64_t end = std::min(levelSize, (index + 1) << (level - l));
+    return {begin, end};
+}
+
+/**
+ * @note encodeSubtree() appends the subtree under one node: its nodes on every level down to the
+ * leaves, enough for the receiver to check it or to serve proofs inside it
+ * @param tree is the tree
+ * @param level, index are the position of the subtree root
+*/
+void ProofCodec::encodeSubtree(const FlatTree& tree, size_t level, size_t index, vector<uint8_t>& out){
+    assert(level < tree.levelCount() && index < tree.levelSize(level));
+
+    size_t nodes = 0;
+    for (size_t l=0; l<=level; l++){
+        auto [begin, end] = subtreeRange(tree.leafCount(), level, index, l);
+        nodes += end - begin;
+    }
+    size_t bodySize = 1 + varintSize(tree.leafCount()) + varintSize(level) + varintSize(index) + 32 * nodes;
+
+    size_t start = beginMessage(out, bodySize);
+    uint8_t* p = writeHeader(&out[start], WireKind::Subtree, bodySize);
+    *p++ = static_cast<uint8_t>(tree.hashMode());
+    p += putVarint(tree.leafCount(), p);
+    p += putVarint(level, p);
+    p += putVarint(index, p);
+    for (size_t l=0; l<=level; l++){
+        auto [begin, end] = subtreeRange(tree.leafCount(), level, index, l);
+        std::memcpy(p, &tree.node(l, begin), 32 * (end - begin));
+        p += 32 * (end - begin);
+    }
+}
+
+/**
+ * @note decode() reads a subtree and checks that its position exists in a tree of its leaf count
+*/
+size_t ProofCodec::decode(std::span<const uint8_t> bytes, SubtreeView& subtree){
+    size_t total;
+    WireReader body = openMessage(bytes, WireKind::Subtree, total);
+    uint8_t mode = body.byte();
+    if (mode > static_cast<uint8_t>(HashMode::Binary)){
+        WireReader::fail("unknown hash mode");
+    }
+    subtree.mode = static_cast<HashMode>(mode);
+    subtree.leafCount = body.varint();
+    subtree.level = body.varint();
+    subtree.index = body.varint();
+    if (subtree.leafCount == 0 || subtree.level >= subtree.levels.size() ||
+        subtree.level >= uint64_t(std::bit_width(subtree.leafCount - 1) + 1) ||
+        subtree.index > ((subtree.leafCount - 1) >> subtree.level)){
+        WireReader::fail("subtree root outside the tree");
+    }
+
+    subtree.levels = {};
+    for (uint64_t l=0; l<=subtree.level; l++){
+        auto [begin, end] = subtreeRange(subtree.leafCount, subtree.level, subtree.index, l);
+        if (end <= begin){
+            WireReader::fail("subtree root outside the tree");
+        }
+        subtree.levels[l] = body.digests(end - begin);
+    }
+    body.finish();
+    return total;
+}
+
+/**
+ * @note checkSubtree() rehashes every level of a decoded subtree from the one below it. The
+ * subtree's range on each level starts at an even index, so hashLevel() pairs the same nodes as
+ * the full tree, and an odd last node is one the full tree hashes alone too.
+*/
+bool ProofCodec::checkSubtree(const SubtreeView& subtree){
+    MerkleTree tree(subtree.mode);
+    vector<Digest> parents;
+    for (uint64_t l=1; l<=subtree.level; l++){
+        std::span<const Digest> children = subtree.levels[l - 1];
+        parents.resize((children.size() + 1) / 2);
+        tree.hashLevel(children.data(), children.size(), parents.data());
+        if (parents.size() != subtree.levels[l].size() ||
+            !std::equal(parents.begin(), parents.end(), subtree.levels[l].begin())){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @note toAuditPath() rebuilds the step flags of a decoded audit path and copies its siblings
+*/
+AuditPath ProofCodec::toAuditPath(const AuditPathView& view){
+    AuditPath path;
+    path.leafIndex = size_t(view.leafIndex);
+    path.leafCount = size_t(view.leafCount);
+
+    size_t used = 0;
+    for (uint64_t i=view.leafIndex, size=view.leafCount; size>1; i/=2, size=(size + 1)/2){
+        ProofStep step = {};
+        step.alone = (i % 2 == 0) && (i + 1 == size);
+        step.siblingOnLeft = (i % 2 == 1);
+        if (!step.alone){
+            step.sibling = view.siblings[used++];
+        }
+        path.steps.push_back(step);
+    }
+    return path;
+}
+
+MultiProof ProofCodec::toMultiProof(const MultiProofView& view){
+    MultiProof proof;
+    proof.leafCount = size_t(view.leafCount);
+    proof.leafIndices = view.leafIndices;
+    proof.siblings.assign(view.siblings.begin(), view.siblings.end());
+    return proof;
+}
@@ -0,0 +1,137 @@
+#include "lib.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// RecordFile.cpp
+
+/**
+ * @note write() writes records one after another in the given framing
+ * @param records are the records to write
+ * @param path is the file to write, replaced if it exists
+ * @param format is the framing
+*/
+void RecordFile::write(std::span<const std::string_view> records, const string& path, RecordFormat format){
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out){
+        throw std::runtime_error("RecordFile: cannot write " + path);
+    }
+
+    for (std::string_view record : records){
+        if (format == RecordFormat::Lines){
+            if (record.find('\n') != std::string_view::npos){
+                throw std::runtime_error("RecordFile: a line record cannot contain a newline");
+            }
+            out.write(record.data(), record.size());
+            out.put('\n');
+        }
+        else {
+            if (record.size() > UINT32_MAX){
+                throw std::runtime_error("RecordFile: record too long for a 4 byte length");
+            }
+            uint8_t len[4];
+            for (size_t i=0; i<4; i++){
+                len[i] = static_cast<uint8_t>(record.size() >> (8 * i));
+            }
+            out.write(reinterpret_cast<const char*>(len), 4);
+            out.write(record.data(), record.size());
+        }
+    }
+
+    out.close();
+    if (!out){
+        throw std::runtime_error("RecordFile: cannot write " + path);
+    }
+}
+
+/**
+ * @note constructor maps a record file and indexes its records
+ * @param path is the file to open
+ * @param format is the framing the file was written with
+*/
+RecordFile::RecordFile(const string& path, RecordFormat format) : base(nullptr), mappedSize(0), framing(format) {
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0){
+        throw std::runtime_error("RecordFile: cannot open " + path);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)){
+        ::close(fd);
+        throw std::runtime_error("RecordFile: not a regular file " + path);
+    }
+
+    // an empty file has no records and nothing to map
+    mappedSize = size_t(st.st_size);
+    if (mappedSize == 0){
+        ::close(fd);
+        return;
+    }
+
+    void* mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED){
+        mappedSize = 0;
+        throw std::runtime_error("RecordFile: cannot map " + path);
+    }
+
+    // the destructor does not run for a constructor that throws, so until the index is done the
+    // mapping is owned by this guard, and only handed to the RecordFile at the end
+    struct MappingGuard {
+        void* mapping;
+        size_t size;
+        ~MappingGuard(){ if (mapping != nullptr) { munmap(mapping, size); } }
+    } guard{mapping, mappedSize};
+
+    // records are indexed and then hashed front to back
+    madvise(mapping, mappedSize, MADV_SEQUENTIAL);
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(mapping);
+    const char* text = reinterpret_cast<const char*>(bytes);
+    if (format == RecordFormat::Lines){
+        index.reserve(std::count(text, text + mappedSize, '\n') + 1);
+        size_t begin = 0;
+        while (begin < mappedSize){
+            const void* newline = std::memchr(text + begin, '\n', mappedSize - begin);
+            size_t end = (newline == nullptr) ? mappedSize : size_t(static_cast<const char*>(newline) - text);
+            index.emplace_back(text + begin, end - begin);
+            begin = end + 1;
+        }
+    }
+    else {
+        size_t offset = 0;
+        while (offset < mappedSize){
+            if (mappedSize - offset < 4){
+                throw std::runtime_error("RecordFile: truncated length in " + path);
+            }
+            size_t len = 0;
+            for (size_t i=0; i<4; i++){
+                len |= size_t(bytes[offset + i]) << (8 * i);
+            }
+            offset += 4;
+            if (len > mappedSize - offset){
+                throw std::runtime_error("RecordFile: truncated record in " + path);
+            }
+            index.emplace_back(text + offset, len);
+            offset += len;
+        }
+    }
+
+    base = bytes;
+    guard.mapping = nullptr;
+}
+
+RecordFile::RecordFile(RecordFile&& other) noexcept
+    : base(other.base), mappedSize(other.mappedSize), framing(other.framing), index(std::move(other.index)) {
+    other.base = nullptr;
+    other.mappedSize = 0;
+}
+
+RecordFile::~RecordFile(){
+    if (base != nullptr){
+        munmap(const_cast<uint8_t*>(base), mappedSize);
+    }
+}
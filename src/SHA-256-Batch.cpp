@@ -0,0 +1,318 @@
+#include "lib.hpp"
+
+#include <atomic>
+#include <cstdlib>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SHA256_HAVE_X86_LANES 1
+#endif
+
+// SHA-256-Batch.cpp
+
+// the lane helpers below are always inlined into the target("avx2") / target("avx512f") entry points,
+// so the ABI note GCC emits for returning vector types from them does not apply
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+// vector types holding one 32-bit word per lane
+typedef uint32_t Lanes8 __attribute__((vector_size(32)));
+typedef uint32_t Lanes16 __attribute__((vector_size(64)));
+
+// lane-wise round functions
+template <typename V> static inline __attribute__((always_inline)) V rotrLanes(const V& x, int n) { return (x >> n) | (x << (32 - n)); }
+template <typename V> static inline __attribute__((always_inline)) V choiceLanes(const V& x, const V& y, const V& z) { return z ^ (x & (y ^ z)); }
+template <typename V> static inline __attribute__((always_inline)) V majorityLanes(const V& x, const V& y, const V& z) { return (x & y) | (z & (x | y)); }
+template <typename V> static inline __attribute__((always_inline)) V bigSigma0Lanes(const V& x) { return rotrLanes(x, 2) ^ rotrLanes(x, 13) ^ rotrLanes(x, 22); }
+template <typename V> static inline __attribute__((always_inline)) V bigSigma1Lanes(const V& x) { return rotrLanes(x, 6) ^ rotrLanes(x, 11) ^ rotrLanes(x, 25); }
+template <typename V> static inline __attribute__((always_inline)) V smallSigma0Lanes(const V& x) { return rotrLanes(x, 7) ^ rotrLanes(x, 18) ^ (x >> 3); }
+template <typename V> static inline __attribute__((always_inline)) V smallSigma1Lanes(const V& x) { return rotrLanes(x, 17) ^ rotrLanes(x, 19) ^ (x >> 10); }
+
+// one round on every lane, callers rotate the argument order instead of shuffling variables
+#define SHA256_LANE_ROUND(a, b, c, d, e, f, g, h, i)                                                   \
+    do {                                                                                               \
+        V t1 = h + bigSigma1Lanes(e) + choiceLanes(e, f, g) + SHA256::k[i] + w[i];                     \
+        V t2 = bigSigma0Lanes(a) + majorityLanes(a, b, c);                                             \
+        d += t1;                                                                                       \
+        h = t1 + t2;                                                                                   \
+    } while (0)
+
+/**
+ * @note compressLanes() runs one compression on every lane. state and words are
+ * stored lane-major: state[i][lane] is hash value i of that lane, words[t][lane] is word t of the
+ * lane's current block.
+*/
+template <typename V, size_t LANES>
+static inline __attribute__((always_inline)) void compressLanes(uint32_t (*state)[LANES], const uint32_t (*words)[LANES]) {
+
+    // message schedule
+    V w[64];
+    for (int t = 0; t < 16; t++) {
+        std::memcpy(&w[t], words[t], sizeof(V));
+    }
+    for (int t = 16; t < 64; t++) {
+        w[t] = w[t-16] + smallSigma0Lanes(w[t-15]) + w[t-7] + smallSigma1Lanes(w[t-2]);
+    }
+
+    V s[8];
+    for (int i = 0; i < 8; i++) {
+        std::memcpy(&s[i], state[i], sizeof(V));
+    }
+    V a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+
+    for (int i = 0; i < 64; i += 8) {
+        SHA256_LANE_ROUND(a, b, c, d, e, f, g, h, i + 0);
+        SHA256_LANE_ROUND(h, a, b, c, d, e, f, g, i + 1);
+        SHA256_LANE_ROUND(g, h, a, b, c, d, e, f, i + 2);
+        SHA256_LANE_ROUND(f, g, h, a, b, c, d, e, i + 3);
+        SHA256_LANE_ROUND(e, f, g, h, a, b, c, d, i + 4);
+        SHA256_LANE_ROUND(d, e, f, g, h, a, b, c, i + 5);
+        SHA256_LANE_ROUND(c, d, e, f, g, h, a, b, i + 6);
+        SHA256_LANE_ROUND(b, c, d, e, f, g, h, a, i + 7);
+    }
+
+    s[0] += a; s[1] += b; s[2] += c; s[3] += d;
+    s[4] += e; s[5] += f; s[6] += g; s[7] += h;
+    for (int i = 0; i < 8; i++) {
+        std::memcpy(state[i], &s[i], sizeof(V));
+    }
+}
+
+#undef SHA256_LANE_ROUND
+
+/**
+ * @note hashLanes() is the multi-buffer scheduler shared by the vector backends. Every lane owns
+ * one message at a time. Full blocks are read from the message in place, and the padded tail (one
+ * or two blocks) is prepared when the lane is loaded. After each compression, lanes that consumed
+ * their last block emit a digest and are refilled with the next message. Once the batch runs dry,
+ * idle lanes hash a zero block that is never read back.
+*/
+template <typename V, size_t LANES>
+static inline __attribute__((always_inline)) void hashLanes(const BatchMessage* msgs, size_t count, uint8_t* digests) {
+
+    static const uint8_t zeroBlock[64] = {0};
+    static const uint32_t iv[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    const size_t idle = SIZE_MAX;
+
+    alignas(64) uint32_t state[8][LANES];
+    alignas(64) uint32_t words[16][LANES];
+    alignas(64) uint8_t tails[LANES][128];
+    size_t msgIndex[LANES], block[LANES], fullBlocks[LANES], totalBlocks[LANES];
+
+    // counted up front, once per batch: every message takes (len + 8) / 64 + 1 blocks including padding
+    MERKLE_STATS_ONLY(
+        for (size_t i = 0; i < count; i++) {
+            MERKLE_COUNT(bytesHashed, msgs[i].len);
+            MERKLE_COUNT(compressions, (msgs[i].len + 8) / 64 + 1);
+        }
+    )
+
+    size_t next = 0;
+    size_t busy = 0;
+
+    // load the next message of the batch into a lane
+    auto refill = [&](size_t lane) {
+        if (next == count) {
+            msgIndex[lane] = idle;
+            return;
+        }
+        size_t i = next++;
+        size_t len = msgs[i].len;
+        size_t remaining = len % 64;
+
+        msgIndex[lane] = i;
+        block[lane] = 0;
+        fullBlocks[lane] = len / 64;
+
+        // padded tail: leftover bytes, the '1' bit, zeros and the big endian bit length
+        size_t tailLen = (remaining + 1 + 8 <= 64) ? 64 : 128;
+        std::memset(tails[lane], 0, tailLen);
+        if (remaining > 0) {
+            std::memcpy(tails[lane], msgs[i].data + (len - remaining), remaining);
+        }
+        tails[lane][remaining] = 0x80;
+        uint64_t bitLen = uint64_t(len) * 8;
+        for (int j = 0; j < 8; j++) {
+            tails[lane][tailLen - 1 - j] = uint8_t(bitLen >> (8 * j));
+        }
+        totalBlocks[lane] = fullBlocks[lane] + tailLen / 64;
+
+        for (int j = 0; j < 8; j++) {
+            state[j][lane] = iv[j];
+        }
+        busy++;
+    };
+
+    for (size_t lane = 0; lane < LANES; lane++) {
+        refill(lane);
+    }
+
+    while (busy > 0) {
+
+        // transpose the current block of every lane into words[t][lane]
+        for (size_t lane = 0; lane < LANES; lane++) {
+            const uint8_t* src;
+            if (msgIndex[lane] == idle) {
+                src = zeroBlock;
+            } else if (block[lane] < fullBlocks[lane]) {
+                src = msgs[msgIndex[lane]].data + 64 * block[lane];
+            } else {
+                src = tails[lane] + 64 * (block[lane] - fullBlocks[lane]);
+            }
+            for (int t = 0; t < 16; t++) {
+                words[t][lane] = (uint32_t(src[4*t]) << 24) | (uint32_t(src[4*t + 1]) << 16) |
+                                 (uint32_t(src[4*t + 2]) << 8) | uint32_t(src[4*t + 3]);
+            }
+        }
+
+        compressLanes<V, LANES>(state, words);
+
+        // retire finished lanes and refill them
+        for (size_t lane = 0; lane < LANES; lane++) {
+            if (msgIndex[lane] == idle || ++block[lane] < totalBlocks[lane]) {
+                continue;
+            }
+            uint8_t* digest = digests + 32 * msgIndex[lane];
+            for (int j = 0; j < 8; j++) {
+                digest[4*j]     = uint8_t(state[j][lane] >> 24);
+                digest[4*j + 1] = uint8_t(state[j][lane] >> 16);
+                digest[4*j + 2] = uint8_t(state[j][lane] >> 8);
+                digest[4*j + 3] = uint8_t(state[j][lane]);
+            }
+            busy--;
+            refill(lane);
+        }
+    }
+}
+
+/**
+ * @note hashSerial() hashes the messages one after another with the active compression backend
+*/
+void SHA256Batch::hashSerial(const BatchMessage* msgs, size_t count, uint8_t* digests) {
+    SHA256 sha256;
+    for (size_t i = 0; i < count; i++) {
+        sha256.init();
+        sha256.update(msgs[i].data, msgs[i].len);
+        sha256.final(digests + 32 * i);
+    }
+}
+
+#if defined(SHA256_HAVE_X86_LANES)
+
+/**
+ * @note hashAVX2() hashes 8 messages side by side in 256-bit registers
+*/
+__attribute__((target("avx2")))
+void SHA256Batch::hashAVX2(const BatchMessage* msgs, size_t count, uint8_t* digests) {
+    hashLanes<Lanes8, 8>(msgs, count, digests);
+}
+
+/**
+ * @note hashAVX512() hashes 16 messages side by side in 512-bit registers
+*/
+__attribute__((target("avx512f")))
+void SHA256Batch::hashAVX512(const BatchMessage* msgs, size_t count, uint8_t* digests) {
+    hashLanes<Lanes16, 16>(msgs, count, digests);
+}
+
+bool SHA256Batch::hasAVX2() { return __builtin_cpu_supports("avx2"); }
+bool SHA256Batch::hasAVX512() { return __builtin_cpu_supports("avx512f"); }
+
+#else
+
+void SHA256Batch::hashAVX2(const BatchMessage* msgs, size_t count, uint8_t* digests) {
+    hashSerial(msgs, count, digests);
+}
+
+void SHA256Batch::hashAVX512(const BatchMessage* msgs, size_t count, uint8_t* digests) {
+    hashSerial(msgs, count, digests);
+}
+
+bool SHA256Batch::hasAVX2() { return false; }
+bool SHA256Batch::hasAVX512() { return false; }
+
+#endif
+
+// table of all backends
+static const BatchBackend avx512Backend = {"avx512", 16, SHA256Batch::hashAVX512};
+static const BatchBackend avx2Backend   = {"avx2", 8, SHA256Batch::hashAVX2};
+static const BatchBackend serialBackend = {"serial", 1, SHA256Batch::hashSerial};
+
+// selected backend, set once on first use unless overridden with select()
+static std::atomic<const BatchBackend*> selectedBatchBackend{nullptr};
+
+/**
+ * @note available() lists the batch backends this CPU can run
+*/
+vector<BatchBackend> SHA256Batch::available() {
+    vector<BatchBackend> backends = {serialBackend};
+    if (hasAVX2()) { backends.push_back(avx2Backend); }
+    if (hasAVX512()) { backends.push_back(avx512Backend); }
+    return backends;
+}
+
+/**
+ * @note select() switches to the named batch backend
+ * @param name is the name of the backend, one of "serial", "avx2" or "avx512"
+ * @returns false (leaving the selection unchanged) if the backend is not available
+*/
+bool SHA256Batch::select(const string& name) {
+    const BatchBackend* candidates[] = {&avx512Backend, &avx2Backend, &serialBackend};
+    vector<BatchBackend> usable = available();
+    for (const BatchBackend* backend : candidates) {
+        if (name != backend->name) { continue; }
+        for (const BatchBackend& u : usable) {
+            if (u.hash == backend->hash) {
+                selectedBatchBackend.store(backend, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @note detect() picks the widest vector backend, honouring the SHA256_BATCH_BACKEND override.
+ * When SHA256Compress runs on SHA-NI or ARMv8 SHA2 the serial backend is preferred.
+*/
+const BatchBackend* SHA256Batch::detect() {
+
+    // environment override
+    const char* forced = std::getenv("SHA256_BATCH_BACKEND");
+    if (forced != nullptr && *forced != '\0') {
+        if (select(forced)) {
+            return selectedBatchBackend.load(std::memory_order_acquire);
+        }
+        cerr << "SHA256_BATCH_BACKEND=" << forced << " is not available, falling back to detection" << endl;
+    }
+
+    // hardware SHA instructions hash a single message faster than the multi-buffer backends
+    // can hash it in one lane
+    if (string(SHA256Compress::active().name) != "scalar") { return &serialBackend; }
+
+    if (hasAVX512()) { return &avx512Backend; }
+    if (hasAVX2()) { return &avx2Backend; }
+    return &serialBackend;
+}
+
+/**
+ * @note active() returns the selected batch backend, detecting it on the first call
+*/
+const BatchBackend& SHA256Batch::active() {
+    const BatchBackend* backend = selectedBatchBackend.load(std::memory_order_acquire);
+    if (backend == nullptr) {
+        static const BatchBackend* detected = detect();
+        const BatchBackend* expected = nullptr;
+        selectedBatchBackend.compare_exchange_strong(expected, detected, std::memory_order_acq_rel);
+        backend = selectedBatchBackend.load(std::memory_order_acquire);
+    }
+    return *backend;
+}
+
+/**
+ * @note hash() hashes a batch of independent messages with the selected backend
+ * @param msgs is the array of messages
+ * @param count is the number of messages
+ * @param digests is the output buffer of count * 32 bytes
+*/
+void SHA256Batch::hash(const BatchMessage* msgs, size_t count, uint8_t* digests) {
+    active().hash(msgs, count, digests);
+}
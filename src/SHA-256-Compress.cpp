@@ -0,0 +1,187 @@
+#include "lib.hpp"
+
+#include "SHA-256-Kernel.hpp"
+
+#include <atomic>
+#include <cstdlib>
+
+// SHA-256-Compress.cpp
+
+/**
+ * @note compressScalar() is the portable backend. It expands the message schedule up front and
+ * runs the rounds eight at a time with the round functions inlined.
+ * @param state is the 8 word hash state to update
+ * @param blocks is a ptr to numBlocks consecutive 64 byte blocks
+*/
+void SHA256Compress::compressScalar(uint32_t* state, const uint8_t* blocks, size_t numBlocks) {
+
+    uint32_t w[64];
+    for (; numBlocks > 0; numBlocks--, blocks += 64) {
+        SHA256::loadWords(blocks, w);
+        blockScalar(state, w);
+    }
+}
+
+#if defined(SHA256_HAVE_SHANI)
+
+/**
+ * @note compressSHANI() uses the x86 SHA extensions. The state stays in the ABEF/CDGH registers
+ * across all blocks, see blockSHANI().
+*/
+__attribute__((target("sha,sse4.1,ssse3")))
+void SHA256Compress::compressSHANI(uint32_t* state, const uint8_t* blocks, size_t numBlocks) {
+
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    __m128i state0, state1;
+    loadSHANI(state, state0, state1);
+
+    for (; numBlocks > 0; numBlocks--, blocks += 64) {
+        __m128i msgs[4];
+        for (int i = 0; i < 4; i++) {
+            msgs[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 16*i)), byteSwap);
+        }
+        blockSHANI(state0, state1, msgs);
+    }
+
+    unloadSHANI(state0, state1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+}
+
+/**
+ * @note hasSHANI() checks CPUID for the SHA extensions and the SSSE3/SSE4.1 shuffles they rely on
+*/
+bool SHA256Compress::hasSHANI() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) { return false; }
+    bool sse = (ecx & bit_SSSE3) && (ecx & bit_SSE4_1);
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) { return false; }
+    return sse && (ebx & bit_SHA);
+}
+
+#else
+
+void SHA256Compress::compressSHANI(uint32_t* state, const uint8_t* blocks, size_t numBlocks) {
+    compressScalar(state, blocks, numBlocks);
+}
+
+bool SHA256Compress::hasSHANI() { return false; }
+
+#endif
+
+#if defined(SHA256_HAVE_ARMV8)
+
+/**
+ * @note compressARMv8() uses the ARMv8 SHA2 instructions, see blockARMv8()
+*/
+SHA256_ARMV8_TARGET
+void SHA256Compress::compressARMv8(uint32_t* state, const uint8_t* blocks, size_t numBlocks) {
+
+    uint32x4_t state0 = vld1q_u32(&state[0]);
+    uint32x4_t state1 = vld1q_u32(&state[4]);
+
+    for (; numBlocks > 0; numBlocks--, blocks += 64) {
+        uint32x4_t msgs[4];
+        for (int i = 0; i < 4; i++) {
+            msgs[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 16*i)));
+        }
+        blockARMv8(state0, state1, msgs);
+    }
+
+    vst1q_u32(&state[0], state0);
+    vst1q_u32(&state[4], state1);
+}
+
+/**
+ * @note hasARMv8SHA2() reads the SHA2 hwcap on Linux. Other platforms that compile this backend
+ * (e.g. Apple silicon) always implement the extension.
+*/
+bool SHA256Compress::hasARMv8SHA2() {
+#if defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+#else
+    return true;
+#endif
+}
+
+#else
+
+void SHA256Compress::compressARMv8(uint32_t* state, const uint8_t* blocks, size_t numBlocks) {
+    compressScalar(state, blocks, numBlocks);
+}
+
+bool SHA256Compress::hasARMv8SHA2() { return false; }
+
+#endif
+
+// table of all backends, in order of preference when detecting
+static const CompressBackend shaniBackend  = {"shani", SHA256Compress::compressSHANI};
+static const CompressBackend armv8Backend  = {"armv8", SHA256Compress::compressARMv8};
+static const CompressBackend scalarBackend = {"scalar", SHA256Compress::compressScalar};
+
+// selected backend, set once on first use unless overridden with select()
+static std::atomic<const CompressBackend*> selectedBackend{nullptr};
+
+/**
+ * @note available() lists the backends this CPU can run
+*/
+vector<CompressBackend> SHA256Compress::available() {
+    vector<CompressBackend> backends = {scalarBackend};
+    if (hasSHANI()) { backends.push_back(shaniBackend); }
+    if (hasARMv8SHA2()) { backends.push_back(armv8Backend); }
+    return backends;
+}
+
+/**
+ * @note select() switches to the named backend
+ * @param name is the name of the backend, one of "scalar", "shani" or "armv8"
+ * @returns false (leaving the selection unchanged) if the backend is not available
+*/
+bool SHA256Compress::select(const string& name) {
+    const CompressBackend* candidates[] = {&shaniBackend, &armv8Backend, &scalarBackend};
+    vector<CompressBackend> usable = available();
+    for (const CompressBackend* backend : candidates) {
+        if (name != backend->name) { continue; }
+        for (const CompressBackend& u : usable) {
+            if (u.compress == backend->compress) {
+                selectedBackend.store(backend, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @note detect() picks the fastest supported backend, honouring the SHA256_BACKEND override
+*/
+const CompressBackend* SHA256Compress::detect() {
+
+    // environment override
+    const char* forced = std::getenv("SHA256_BACKEND");
+    if (forced != nullptr && *forced != '\0') {
+        if (select(forced)) {
+            return selectedBackend.load(std::memory_order_acquire);
+        }
+        cerr << "SHA256_BACKEND=" << forced << " is not available, falling back to detection" << endl;
+    }
+
+    if (hasSHANI()) { return &shaniBackend; }
+    if (hasARMv8SHA2()) { return &armv8Backend; }
+    return &scalarBackend;
+}
+
+/**
+ * @note active() returns the selected backend, detecting it on the first call
+*/
+const CompressBackend& SHA256Compress::active() {
+    const CompressBackend* backend = selectedBackend.load(std::memory_order_acquire);
+    if (backend == nullptr) {
+        static const CompressBackend* detected = detect();
+        const CompressBackend* expected = nullptr;
+        selectedBackend.compare_exchange_strong(expected, detected, std::memory_order_acq_rel);
+        backend = selectedBackend.load(std::memory_order_acquire);
+    }
+    return *backend;
+}
@@ -0,0 +1,304 @@
+#include "lib.hpp"
+
+#include "SHA-256-Kernel.hpp"
+
+// SHA-256-Pair.cpp
+
+// padding blocks of the two pair lengths, with k[i] + w[i] precomputed
+static constexpr array<uint32_t, 64> binaryPadding = SHA256Pair::paddingSchedule(64);
+static constexpr array<uint32_t, 64> hexPadding = SHA256Pair::paddingSchedule(128);
+
+// hex text of every byte value as a big endian pair of chars, e.g. 0xa5 -> ('a' << 8) | '5'
+static constexpr array<uint16_t, 256> hexPairs = []{
+    array<uint16_t, 256> pairs = {};
+    for (int b = 0; b < 256; b++) {
+        pairs[b] = uint16_t(("0123456789abcdef"[b >> 4] << 8) | "0123456789abcdef"[b & 0xf]);
+    }
+    return pairs;
+}();
+
+static_assert(binaryPadding[0] == SHA256::k[0] + 0x80000000);
+static_assert(hexPadding[15] == SHA256::k[15] + 1024);
+
+static inline uint32_t loadBigEndian(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+/**
+ * @note pairScalar() is the portable kernel. In binary mode the children fill the one message
+ * block, in hex mode each child's text fills a block of its own. Then the padding rounds run
+ * from the precomputed schedule.
+*/
+template <HashMode mode>
+void SHA256Pair::pairScalar(const uint8_t* left, const uint8_t* right, uint8_t* parent) {
+
+    uint32_t state[8];
+    std::copy(SHA256Const::iv.begin(), SHA256Const::iv.end(), state);
+    uint32_t w[64];
+
+    if constexpr (mode == HashMode::Binary) {
+        for (int j = 0; j < 8; j++) {
+            w[j] = loadBigEndian(left + 4*j);
+            w[8 + j] = loadBigEndian(right + 4*j);
+        }
+        blockScalar(state, w);
+        roundsScalar(state, binaryPadding.data());
+    }
+    else {
+        for (const uint8_t* child : {left, right}) {
+            for (int j = 0; j < 16; j++) {
+                w[j] = (uint32_t(hexPairs[child[2*j]]) << 16) | hexPairs[child[2*j + 1]];
+            }
+            blockScalar(state, w);
+        }
+        roundsScalar(state, hexPadding.data());
+    }
+
+    for (int j = 0; j < 8; j++) {
+        parent[4*j]     = uint8_t(state[j] >> 24);
+        parent[4*j + 1] = uint8_t(state[j] >> 16);
+        parent[4*j + 2] = uint8_t(state[j] >> 8);
+        parent[4*j + 3] = uint8_t(state[j]);
+    }
+}
+
+#if defined(SHA256_HAVE_SHANI)
+
+/**
+ * @note paddingSHANI() runs the padding block straight from its precomputed k[i] + w[i] schedule
+*/
+SHANI_INLINE void paddingSHANI(__m128i& state0, __m128i& state1, const uint32_t* kw) {
+
+    __m128i abefSave = state0;
+    __m128i cdghSave = state1;
+
+    #pragma GCC unroll 16
+    for (int i = 0; i < 16; i++) {
+        __m128i msg = _mm_loadu_si128(reinterpret_cast<const __m128i*>(kw + 4*i));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    }
+
+    state0 = _mm_add_epi32(state0, abefSave);
+    state1 = _mm_add_epi32(state1, cdghSave);
+}
+
+/**
+ * @note hexSHANI() encodes 16 bytes as 32 lowercase hex chars and returns them as 8 big endian words
+*/
+SHANI_INLINE void hexSHANI(const uint8_t* bytes, __m128i& first, __m128i& second) {
+    const __m128i digits = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    const __m128i lowNibble = _mm_set1_epi8(0x0f);
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+    __m128i lo = _mm_and_si128(x, lowNibble);
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), lowNibble);
+    first = _mm_shuffle_epi8(_mm_shuffle_epi8(digits, _mm_unpacklo_epi8(hi, lo)), byteSwap);
+    second = _mm_shuffle_epi8(_mm_shuffle_epi8(digits, _mm_unpackhi_epi8(hi, lo)), byteSwap);
+}
+
+/**
+ * @note pairSHANI() is the x86 SHA extensions kernel. The state stays in the ABEF/CDGH registers
+ * across all blocks of the pair.
+*/
+template <HashMode mode>
+__attribute__((target("sha,sse4.1,ssse3")))
+void SHA256Pair::pairSHANI(const uint8_t* left, const uint8_t* right, uint8_t* parent) {
+
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    __m128i state0, state1;
+    loadSHANI(SHA256Const::iv.data(), state0, state1);
+
+    __m128i msgs[4];
+    if constexpr (mode == HashMode::Binary) {
+        msgs[0] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(left)), byteSwap);
+        msgs[1] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(left + 16)), byteSwap);
+        msgs[2] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(right)), byteSwap);
+        msgs[3] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(right + 16)), byteSwap);
+        blockSHANI(state0, state1, msgs);
+        paddingSHANI(state0, state1, binaryPadding.data());
+    }
+    else {
+        for (const uint8_t* child : {left, right}) {
+            hexSHANI(child, msgs[0], msgs[1]);
+            hexSHANI(child + 16, msgs[2], msgs[3]);
+            blockSHANI(state0, state1, msgs);
+        }
+        paddingSHANI(state0, state1, hexPadding.data());
+    }
+
+    // rearrange back to ABCD / EFGH and store big endian
+    unloadSHANI(state0, state1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(parent), _mm_shuffle_epi8(state0, byteSwap));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(parent + 16), _mm_shuffle_epi8(state1, byteSwap));
+}
+
+#else
+
+template <HashMode mode>
+void SHA256Pair::pairSHANI(const uint8_t* left, const uint8_t* right, uint8_t* parent) {
+    pairScalar<mode>(left, right, parent);
+}
+
+#endif
+
+#if defined(SHA256_HAVE_ARMV8)
+
+/**
+ * @note paddingARMv8() runs the padding block straight from its precomputed k[i] + w[i] schedule
+*/
+ARMV8_INLINE void paddingARMv8(uint32x4_t& state0, uint32x4_t& state1, const uint32_t* kw) {
+
+    uint32x4_t abcdSave = state0;
+    uint32x4_t efghSave = state1;
+
+    for (int i = 0; i < 16; i++) {
+        uint32x4_t wk = vld1q_u32(kw + 4*i);
+        uint32x4_t abcd = state0;
+        state0 = vsha256hq_u32(state0, state1, wk);
+        state1 = vsha256h2q_u32(state1, abcd, wk);
+    }
+
+    state0 = vaddq_u32(state0, abcdSave);
+    state1 = vaddq_u32(state1, efghSave);
+}
+
+/**
+ * @note hexARMv8() encodes 16 bytes as 32 lowercase hex chars and returns them as 8 big endian words
+*/
+ARMV8_INLINE void hexARMv8(const uint8_t* bytes, uint32x4_t& first, uint32x4_t& second) {
+    static const uint8_t digitChars[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
+    const uint8x16_t digits = vld1q_u8(digitChars);
+
+    uint8x16_t x = vld1q_u8(bytes);
+    uint8x16_t lo = vandq_u8(x, vdupq_n_u8(0x0f));
+    uint8x16_t hi = vshrq_n_u8(x, 4);
+    first = vreinterpretq_u32_u8(vrev32q_u8(vqtbl1q_u8(digits, vzip1q_u8(hi, lo))));
+    second = vreinterpretq_u32_u8(vrev32q_u8(vqtbl1q_u8(digits, vzip2q_u8(hi, lo))));
+}
+
+/**
+ * @note pairARMv8() is the ARMv8 SHA2 kernel
+*/
+template <HashMode mode>
+SHA256_ARMV8_TARGET
+void SHA256Pair::pairARMv8(const uint8_t* left, const uint8_t* right, uint8_t* parent) {
+
+    uint32x4_t state0 = vld1q_u32(&SHA256Const::iv[0]);
+    uint32x4_t state1 = vld1q_u32(&SHA256Const::iv[4]);
+
+    uint32x4_t msgs[4];
+    if constexpr (mode == HashMode::Binary) {
+        msgs[0] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(left)));
+        msgs[1] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(left + 16)));
+        msgs[2] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(right)));
+        msgs[3] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(right + 16)));
+        blockARMv8(state0, state1, msgs);
+        paddingARMv8(state0, state1, binaryPadding.data());
+    }
+    else {
+        for (const uint8_t* child : {left, right}) {
+            hexARMv8(child, msgs[0], msgs[1]);
+            hexARMv8(child + 16, msgs[2], msgs[3]);
+            blockARMv8(state0, state1, msgs);
+        }
+        paddingARMv8(state0, state1, hexPadding.data());
+    }
+
+    vst1q_u8(parent, vrev32q_u8(vreinterpretq_u8_u32(state0)));
+    vst1q_u8(parent + 16, vrev32q_u8(vreinterpretq_u8_u32(state1)));
+}
+
+#else
+
+template <HashMode mode>
+void SHA256Pair::pairARMv8(const uint8_t* left, const uint8_t* right, uint8_t* parent) {
+    pairScalar<mode>(left, right, parent);
+}
+
+#endif
+
+template void SHA256Pair::pairScalar<HashMode::Hex>(const uint8_t*, const uint8_t*, uint8_t*);
+template void SHA256Pair::pairScalar<HashMode::Binary>(const uint8_t*, const uint8_t*, uint8_t*);
+template void SHA256Pair::pairSHANI<HashMode::Hex>(const uint8_t*, const uint8_t*, uint8_t*);
+template void SHA256Pair::pairSHANI<HashMode::Binary>(const uint8_t*, const uint8_t*, uint8_t*);
+template void SHA256Pair::pairARMv8<HashMode::Hex>(const uint8_t*, const uint8_t*, uint8_t*);
+template void SHA256Pair::pairARMv8<HashMode::Binary>(const uint8_t*, const uint8_t*, uint8_t*);
+
+/**
+ * @note active() picks the kernel matching the active SHA256Compress backend, so forcing a
+ * compression backend (SHA256_BACKEND) forces the pair kernel too
+*/
+PairFunc SHA256Pair::active(HashMode mode) {
+    CompressFunc compress = SHA256Compress::active().compress;
+    bool hex = (mode == HashMode::Hex);
+    if (compress == SHA256Compress::compressSHANI) {
+        return hex ? pairSHANI<HashMode::Hex> : pairSHANI<HashMode::Binary>;
+    }
+    if (compress == SHA256Compress::compressARMv8) {
+        return hex ? pairARMv8<HashMode::Hex> : pairARMv8<HashMode::Binary>;
+    }
+    return hex ? pairScalar<HashMode::Hex> : pairScalar<HashMode::Binary>;
+}
+
+/**
+ * @note preferred() tells level builders whether to hash pairs here or as one SHA256Batch batch.
+ * With hardware SHA the pair kernel wins. With only scalar compression, the AVX2 / AVX-512 lanes
+ * hash a level faster than one pair at a time.
+*/
+bool SHA256Pair::preferred() {
+    return SHA256Compress::active().compress != SHA256Compress::compressScalar || SHA256Batch::active().lanes == 1;
+}
+
+/**
+ * @note hashPair() hashes one parent from its two children
+*/
+void SHA256Pair::hashPair(const Digest& left, const Digest& right, Digest& parent, HashMode mode) {
+    MERKLE_COUNT(compressions, (mode == HashMode::Hex) ? 3 : 2);
+    MERKLE_COUNT(bytesHashed, (mode == HashMode::Hex) ? 128 : 64);
+    active(mode)(left.data(), right.data(), parent.data());
+}
+
+Digest SHA256Pair::hashPair(const Digest& left, const Digest& right, HashMode mode) {
+    Digest parent;
+    hashPair(left, right, parent, mode);
+    return parent;
+}
+
+/**
+ * @note hashAlone() hashes the parent of a node that ends its level without a sibling. It keeps no
+ * state, so parallel builds can call it from any thread.
+*/
+void SHA256Pair::hashAlone(const Digest& node, Digest& parent, HashMode mode) {
+    char text[64];
+    BatchMessage msg = {node.data(), 32};
+    if (mode == HashMode::Hex) {
+        SHA256::toHex(node.data(), 32, text);
+        msg = {reinterpret_cast<const uint8_t*>(text), 64};
+    }
+    SHA256Batch::hash(&msg, 1, parent.data());
+}
+
+Digest SHA256Pair::hashAlone(const Digest& node, HashMode mode) {
+    Digest parent;
+    hashAlone(node, parent, mode);
+    return parent;
+}
+
+/**
+ * @note hashPairs() hashes adjacent pairs of one level, looking the kernel up once
+ * @param nodes is a ptr to 2 * numPairs digests
+ * @param parents is the output array of numPairs digests
+*/
+void SHA256Pair::hashPairs(const Digest* nodes, size_t numPairs, Digest* parents, HashMode mode) {
+    MERKLE_COUNT(compressions, numPairs * ((mode == HashMode::Hex) ? 3 : 2));
+    MERKLE_COUNT(bytesHashed, numPairs * ((mode == HashMode::Hex) ? 128 : 64));
+
+    PairFunc pair = active(mode);
+    for (size_t i = 0; i < numPairs; i++) {
+        pair(nodes[2*i].data(), nodes[2*i + 1].data(), parents[i].data());
+    }
+}
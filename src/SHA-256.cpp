@@ -1,5 +1,8 @@
 #include "lib.hpp"
 
+#include <fcntl.h>
+#include <unistd.h>
+
 // SHA-256.cpp
 
 /**
@@ -7,10 +10,19 @@
  * @param bitVec is a boolean vector representing the message to hash in binary
 */
 string SHA256::computeHash(vector<bool> bitVec) {
+    MERKLE_COUNT(bitsConverted, bitVec.size());
+
+    // whole-byte messages are packed and routed through the byte-oriented path
+    if (bitVec.size() % 8 == 0) {
+        vector<uint8_t> bytes(bitVec.size() / 8, 0);
+        for (size_t i = 0; i < bitVec.size(); i++) {
+            bytes[i / 8] |= uint8_t(bitVec[i]) << (7 - (i % 8));
+        }
+        return computeHash(bytes.data(), bytes.size());
+    }
 
     // reset initial hash values
-    uint32_t h0 = 0x6a09e667, h1 = 0xbb67ae85, h2 = 0x3c6ef372, h3 = 0xa54ff53a,
-             h4 = 0x510e527f, h5 = 0x9b05688c, h6 = 0x1f83d9ab, h7 = 0x5be0cd19;
+    init();
 
     // Pad the message as per SHA-256 requirements
     pad(bitVec); 
@@ -30,6 +42,190 @@ string SHA256::computeHash(vector<bool> bitVec) {
     return hashHex;
 }
 
+/**
+ * @note computeHash() hashes a message that is already laid out as bytes by running a single
+ * init(), update(), final() pass over it.
+ * @param data is a ptr to the first byte of the message
+ * @param len is the length of the message in bytes
+*/
+string SHA256::computeHash(const uint8_t* data, size_t len) {
+    uint8_t digest[32];
+    init();
+    update(data, len);
+    final(digest);
+    return toHex(digest, 32);
+}
+
+/**
+ * @note computeHash() span overload of the byte-oriented hash
+ * @param data is a view over the bytes of the message
+*/
+string SHA256::computeHash(std::span<const std::byte> data) {
+    return computeHash(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+/**
+ * @note init() resets the hash values and the partial block so a new message can be streamed in
+*/
+void SHA256::init() {
+    h[0] = 0x6a09e667; h[1] = 0xbb67ae85; h[2] = 0x3c6ef372; h[3] = 0xa54ff53a;
+    h[4] = 0x510e527f; h[5] = 0x9b05688c; h[6] = 0x1f83d9ab; h[7] = 0x5be0cd19;
+    blockLen = 0;
+    messageLen = 0;
+}
+
+/**
+ * @note update() absorbs the next piece of the message. It may be called any number of times
+ * between init() and final(). Full 64 byte blocks are loaded straight from the input and only a
+ * trailing partial block is buffered.
+ * @param data is a ptr to the next bytes of the message
+ * @param len is the number of bytes to absorb
+*/
+void SHA256::update(const uint8_t* data, size_t len) {
+
+    CompressFunc compress = SHA256Compress::active().compress;
+    messageLen += len;
+    MERKLE_COUNT(bytesHashed, len);
+
+    // top up a partially filled block first
+    if (blockLen > 0) {
+        size_t take = std::min(len, 64 - blockLen);
+        std::memcpy(block + blockLen, data, take);
+        blockLen += take;
+        data += take;
+        len -= take;
+
+        if (blockLen < 64) {
+            return;
+        }
+        compress(h, block, 1);
+        MERKLE_COUNT(compressions, 1);
+        blockLen = 0;
+    }
+
+    // process every full 512-bit chunk directly from the input
+    if (len >= 64) {
+        compress(h, data, len / 64);
+        MERKLE_COUNT(compressions, len / 64);
+        data += len - (len % 64);
+        len %= 64;
+    }
+
+    // buffer the remainder for the next call
+    if (len > 0) {
+        std::memcpy(block, data, len);
+        blockLen = len;
+    }
+}
+
+/**
+ * @note final() pads the buffered tail, processes it and writes the 32 byte big endian digest.
+ * The context must be re-initialised with init() before it is reused.
+ * @param digest is the output buffer of 32 bytes
+*/
+void SHA256::final(uint8_t* digest) {
+
+    CompressFunc compress = SHA256Compress::active().compress;
+    uint64_t bitLen = messageLen * 8;
+
+    // append the '1' bit
+    block[blockLen++] = 0x80;
+
+    // the 64-bit length needs an extra block when fewer than 8 bytes are left after the '1' bit
+    if (blockLen > 56) {
+        std::memset(block + blockLen, 0, 64 - blockLen);
+        compress(h, block, 1);
+        MERKLE_COUNT(compressions, 1);
+        blockLen = 0;
+    }
+    std::memset(block + blockLen, 0, 56 - blockLen);
+
+    // append the big endian length of the original message (in bits)
+    for (int i = 0; i < 8; i++) {
+        block[63 - i] = uint8_t(bitLen >> (8 * i));
+    }
+    compress(h, block, 1);
+    MERKLE_COUNT(compressions, 1);
+    blockLen = 0;
+
+    // write out the hash values big endian
+    for (int i = 0; i < 8; i++) {
+        digest[4*i]     = uint8_t(h[i] >> 24);
+        digest[4*i + 1] = uint8_t(h[i] >> 16);
+        digest[4*i + 2] = uint8_t(h[i] >> 8);
+        digest[4*i + 3] = uint8_t(h[i]);
+    }
+}
+
+/**
+ * @note hashFile() hashes the contents of a file in constant memory. The file is read sequentially
+ * in large chunks and streamed through update(). It is read rather than mapped, so a file truncated
+ * while it is hashed ends the read early instead of faulting on the mapping.
+ * @param path is the path of the file to hash
+ * @returns the hash of the file as a hexadecimal string
+*/
+string SHA256::hashFile(const string& path) {
+
+    // size of each read, a whole number of blocks
+    const size_t chunkSize = size_t(1) << 20;
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("hashFile: cannot open " + path);
+    }
+
+    init();
+
+    vector<uint8_t> buffer(chunkSize);
+    ssize_t n;
+    while ((n = ::read(fd, buffer.data(), buffer.size())) > 0) {
+        update(buffer.data(), size_t(n));
+    }
+    ::close(fd);
+    if (n < 0) {
+        throw std::runtime_error("hashFile: cannot read " + path);
+    }
+
+    uint8_t digest[32];
+    final(digest);
+    return toHex(digest, 32);
+}
+
+/**
+ * @note loadWords() reads a 64 byte block as sixteen big endian 32-bit words
+ * @param block is a ptr to the 64 bytes to load
+ * @param words is the output array of 16 words
+*/
+void SHA256::loadWords(const uint8_t* block, uint32_t* words) {
+    for (int i = 0; i < 16; i++) {
+        words[i] = (uint32_t(block[4*i]) << 24) | (uint32_t(block[4*i + 1]) << 16) |
+                   (uint32_t(block[4*i + 2]) << 8) | uint32_t(block[4*i + 3]);
+    }
+}
+
+/**
+ * @note toHex() renders bytes as a lowercase hexadecimal string, e.g. a 32 byte digest as the
+ * same 64 characters collectDigest() produces
+ * @param bytes is a ptr to the bytes to render
+ * @param len is the number of bytes
+*/
+string SHA256::toHex(const uint8_t* bytes, size_t len) {
+    string hex(2 * len, '0');
+    toHex(bytes, len, hex.data());
+    return hex;
+}
+
+/**
+ * @note toHex() writes the 2 * len hex chars of bytes to out, without a terminator
+*/
+void SHA256::toHex(const uint8_t* bytes, size_t len, char* out) {
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < len; i++) {
+        out[2*i]     = digits[bytes[i] >> 4];
+        out[2*i + 1] = digits[bytes[i] & 0xf];
+    }
+}
+
 /**
  * @note pad() pads a vector of bits (represented as bools) to a len that is a multiple of 512 bits by 
  * first appending a single '1' bit, then the amount of zeroes such that the big endian representation 
@@ -113,51 +309,22 @@ vector<uint32_t> SHA256::convertToWords(const vector<bool>& bitVec) {
 
 /**
  * @note processChunk processes each 512 bit chunk of the initial input bit vector, updating
- * the class variables h0-h7
+ * the hash values h[0..7]. The words are written back out big endian and handed to the
+ * compression backend selected by SHA256Compress.
+ * @param chunk is a ptr to 16 32-bit words
 */
 void SHA256::processChunk(const uint32_t* chunk) {
 
-    // @note w is the msg schedule array. rest are working variables
-    uint32_t w[64], a, b, c, d, e, f, g, h, temp1, temp2, S0, S1;
-
-    // Initialize the first 16 words in the array W[0..15]
+    uint8_t bytes[64];
     for (int i = 0; i < 16; ++i) {
-        w[i] = chunk[i];
-    }
-
-    // Extend the first 16 words into the remaining 48 words of the message schedule array
-    for (int i = 16; i < 64; ++i) {
-        uint32_t s0 = sigma0(w[i-15]);
-        uint32_t s1 = sigma1(w[i-2]);
-        w[i] = w[i-16] + s0 + w[i-7] + s1;
-    }
-
-    // Initialize working variables to current hash value
-    a = h0; b = h1; c = h2; d = h3;
-    e = h4; f = h5; g = h6; h = h7;
-
-    // Compression function main loop
-    for (int i = 0; i < 64; ++i) {
-        S1 = Sigma1(e);
-        uint32_t ch = Choice(e, f, g);
-        temp1 = h + S1 + ch + k[i] + w[i];
-        S0 = Sigma0(a);
-        uint32_t maj = Majority(a, b, c);
-        temp2 = S0 + maj;
-
-        h = g;
-        g = f;
-        f = e;
-        e = d + temp1;
-        d = c;
-        c = b;
-        b = a;
-        a = temp1 + temp2;
+        bytes[4*i]     = uint8_t(chunk[i] >> 24);
+        bytes[4*i + 1] = uint8_t(chunk[i] >> 16);
+        bytes[4*i + 2] = uint8_t(chunk[i] >> 8);
+        bytes[4*i + 3] = uint8_t(chunk[i]);
     }
 
-    // Add the compressed chunk to the current hash value
-    h0 += a; h1 += b; h2 += c; h3 += d;
-    h4 += e; h5 += f; h6 += g; h7 += h;
+    SHA256Compress::active().compress(h, bytes, 1);
+    MERKLE_COUNT(compressions, 1);
 }
 
 
@@ -168,12 +335,11 @@ string SHA256::collectDigest() const {
 
     std::ostringstream result;
     
-    // collect current hashg vals into array for iteration
-    uint32_t hashVals[8] = {h0, h1, h2, h3, h4, h5, h6, h7};
+    // iterate over the current hash vals
     for(int i = 0; i < 8; i++) {
 
         // append hash values into hexadecimal string
-        result << std::hex << std::setfill('0') << std::setw(8) << hashVals[i];
+        result << std::hex << std::setfill('0') << std::setw(8) << h[i];
     }
 
     return result.str();
@@ -245,6 +411,7 @@ uint32_t SHA256::sigma1(uint32_t x) {
 
 // ! TODO write a test for this
 vector<bool> SHA256::stringToBinary(const std::string& input) {
+    MERKLE_COUNT(bitsConverted, 8 * input.size());
     std::vector<bool> binaryRepresentation;
 
     for (char character : input) {
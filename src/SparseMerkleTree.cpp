@@ -0,0 +1,289 @@
+#include "lib.hpp"
+
+// SparseMerkleTree.cpp
+
+/**
+ * @note constructor creates an empty map, whose root is the root of an empty tree of height 256
+ * @param mode is the parent hashing scheme
+*/
+SparseMerkleTree::SparseMerkleTree(HashMode mode) : mode(mode), keyCount(0) {}
+
+/**
+ * @note NodeKeyHash mixes every word of the prefix with the height. Stored prefixes have their low
+ * bits cleared, so no single word can be relied on.
+*/
+size_t SparseMerkleTree::NodeKeyHash::operator()(const NodeKey& node) const {
+    uint64_t words[4];
+    std::memcpy(words, node.prefix.data(), 32);
+    uint64_t h = uint64_t(node.height) * 0x9e3779b97f4a7c15ULL;
+    h ^= words[0] * 0xbf58476d1ce4e5b9ULL;
+    h ^= words[1] * 0x94d049bb133111ebULL;
+    h ^= words[2] * 0xd6e8feb86659fd93ULL;
+    h ^= words[3] * 0xff51afd7ed558ccdULL;
+    return size_t(h ^ (h >> 29));
+}
+
+/**
+ * @note prefixOf() clears the low height bits of a key, leaving the bits that lead to its ancestor
+ * at that height. Bit 0 is the least significant bit of the last byte.
+*/
+Digest SparseMerkleTree::prefixOf(const Digest& key, size_t height){
+    Digest prefix = key;
+    size_t fullBytes = std::min<size_t>(32, height / 8);
+    std::fill(prefix.end() - fullBytes, prefix.end(), 0);
+    if (fullBytes < 32){
+        prefix[31 - fullBytes] &= uint8_t(0xff << (height % 8));
+    }
+    return prefix;
+}
+
+/**
+ * @note bitAt() tells which child of its ancestor at height + 1 a key goes through, 1 for the right
+*/
+bool SparseMerkleTree::bitAt(const Digest& key, size_t height){
+    return (key[31 - height / 8] >> (height % 8)) & 1;
+}
+
+/**
+ * @note flipBit() flips bit height, turning a node's prefix into its sibling's
+*/
+Digest SparseMerkleTree::flipBit(const Digest& key, size_t height){
+    Digest flipped = key;
+    flipped[31 - height / 8] ^= uint8_t(1 << (height % 8));
+    return flipped;
+}
+
+/**
+ * @note nodeAt() returns a stored node, or the empty subtree root of its height
+*/
+Digest SparseMerkleTree::nodeAt(size_t height, const Digest& prefix) const {
+    auto found = nodes.find({prefix, uint16_t(height)});
+    return (found == nodes.end()) ? ZeroHashes::at(mode, height) : found->second;
+}
+
+/**
+ * @note store() keeps a node, or drops it once it equals the empty subtree again
+*/
+void SparseMerkleTree::store(size_t height, const Digest& prefix, const Digest& digest){
+    NodeKey node = {prefix, uint16_t(height)};
+    if (digest == ZeroHashes::at(mode, height)){
+        if (nodes.erase(node) > 0 && height == 0){
+            keyCount--;
+        }
+        return;
+    }
+    auto [it, inserted] = nodes.insert_or_assign(node, digest);
+    if (inserted && height == 0){
+        keyCount++;
+    }
+}
+
+/**
+ * @note parentHash() hashes two children, or takes the empty subtree root when both are empty
+ * @param childHeight is the height of the children
+*/
+Digest SparseMerkleTree::parentHash(const Digest& left, const Digest& right, size_t childHeight) const {
+    const Digest& empty = ZeroHashes::at(mode, childHeight);
+    if (left == empty && right == empty){
+        return ZeroHashes::at(mode, childHeight + 1);
+    }
+    return SHA256Pair::hashPair(left, right, mode);
+}
+
+/**
+ * @note applyLeaves() sets leaves and recomputes their ancestors. The keys are sorted, so the
+ * dirty parents of each level come out sorted and shared parents next to each other, and every
+ * parent is hashed once. The hashing of a level only reads the map and can be split across a pool.
+ * The results are stored after the level is done.
+ * @param leaves are (key, leaf digest) pairs, the last one wins for a repeated key
+ * @param pool is an optional thread pool for levels with many dirty parents
+*/
+void SparseMerkleTree::applyLeaves(vector<std::pair<Digest, Digest>> leaves, ThreadPool* pool){
+    if (leaves.empty()){
+        return;
+    }
+
+    std::stable_sort(leaves.begin(), leaves.end(), [](const auto& a, const auto& b){ return a.first < b.first; });
+    vector<Digest> dirty;
+    for (size_t i=0; i<leaves.size(); i++){
+        if (i + 1 < leaves.size() && leaves[i + 1].first == leaves[i].first){
+            continue;
+        }
+        store(0, leaves[i].first, leaves[i].second);
+        dirty.push_back(leaves[i].first);
+    }
+
+    const size_t grain = 256;
+    for (size_t h=0; h<depth; h++){
+
+        // the parents of the dirty nodes, prefix order is kept
+        vector<Digest> parents;
+        for (const Digest& prefix : dirty){
+            Digest parent = prefixOf(prefix, h + 1);
+            if (parents.empty() || parents.back() != parent){
+                parents.push_back(parent);
+            }
+        }
+
+        vector<Digest> digests(parents.size());
+        auto hashRange = [&](size_t begin, size_t end){
+            for (size_t i=begin; i<end; i++){
+                digests[i] = parentHash(nodeAt(h, parents[i]), nodeAt(h, flipBit(parents[i], h)), h);
+            }
+        };
+        if (pool != nullptr && parents.size() >= 2 * grain){
+            pool->parallelFor(parents.size(), grain, hashRange);
+        }
+        else {
+            hashRange(0, parents.size());
+        }
+
+        for (size_t i=0; i<parents.size(); i++){
+            store(h + 1, parents[i], digests[i]);
+        }
+        dirty.swap(parents);
+    }
+}
+
+/**
+ * @note leafHash() hashes a value into its leaf digest
+*/
+Digest SparseMerkleTree::leafHash(const string& value){
+    Digest digest;
+    BatchMessage msg = {reinterpret_cast<const uint8_t*>(value.data()), value.size()};
+    SHA256Batch::hash(&msg, 1, digest.data());
+    return digest;
+}
+
+/**
+ * @note insert() sets the value of a key, inserting or replacing it
+*/
+void SparseMerkleTree::insert(const Digest& key, const string& value){
+    insertLeaf(key, leafHash(value));
+}
+
+void SparseMerkleTree::insertLeaf(const Digest& key, const Digest& leaf){
+    applyLeaves({{key, leaf}}, nullptr);
+}
+
+/**
+ * @note erase() removes a key, resetting its leaf to the empty leaf
+*/
+void SparseMerkleTree::erase(const Digest& key){
+    insertLeaf(key, ZeroHashes::at(mode, 0));
+}
+
+/**
+ * @note insertMany() sets many keys at once, hashing the values in one batch
+*/
+void SparseMerkleTree::insertMany(const vector<std::pair<Digest, string>>& entries, ThreadPool* pool){
+    if (entries.empty()){
+        return;
+    }
+
+    vector<BatchMessage> msgs(entries.size());
+    for (size_t i=0; i<entries.size(); i++){
+        msgs[i] = {reinterpret_cast<const uint8_t*>(entries[i].second.data()), entries[i].second.size()};
+    }
+    vector<Digest> digests(entries.size());
+    SHA256Batch::hash(msgs.data(), msgs.size(), reinterpret_cast<uint8_t*>(digests.data()));
+
+    vector<std::pair<Digest, Digest>> leaves(entries.size());
+    for (size_t i=0; i<entries.size(); i++){
+        leaves[i] = {entries[i].first, digests[i]};
+    }
+    applyLeaves(std::move(leaves), pool);
+}
+
+void SparseMerkleTree::eraseMany(const vector<Digest>& keys, ThreadPool* pool){
+    vector<std::pair<Digest, Digest>> leaves;
+    leaves.reserve(keys.size());
+    for (const Digest& key : keys){
+        leaves.push_back({key, ZeroHashes::at(mode, 0)});
+    }
+    applyLeaves(std::move(leaves), pool);
+}
+
+Digest SparseMerkleTree::root() const {
+    return nodeAt(depth, Digest{});
+}
+
+bool SparseMerkleTree::contains(const Digest& key) const {
+    return nodes.count({key, 0}) > 0;
+}
+
+/**
+ * @note leaf() returns the leaf digest of a key, the empty leaf when it is absent
+*/
+Digest SparseMerkleTree::leaf(const Digest& key) const {
+    return nodeAt(0, key);
+}
+
+/**
+ * @note prove() collects the siblings along a key's path. Empty siblings are only flagged in the
+ * bitmap, so a proof in a map of n keys carries about log2(n) digests.
+*/
+SparseProof SparseMerkleTree::prove(const Digest& key) const {
+    SparseProof proof = {};
+    proof.key = key;
+    proof.leaf = nodeAt(0, key);
+    for (size_t h=0; h<depth; h++){
+        Digest sibling = nodeAt(h, flipBit(prefixOf(key, h), h));
+        if (sibling != ZeroHashes::at(mode, h)){
+            proof.nonEmpty[h / 8] |= uint8_t(1 << (h % 8));
+            proof.siblings.push_back(sibling);
+        }
+    }
+    return proof;
+}
+
+/**
+ * @note computeRoot() folds a proof into the root it implies
+ * @returns false if the proof does not carry exactly the siblings its bitmap flags
+*/
+bool SparseMerkleTree::computeRoot(const SparseProof& proof, HashMode mode, Digest& root){
+    Digest node = proof.leaf;
+    size_t used = 0;
+    for (size_t h=0; h<depth; h++){
+        const Digest& empty = ZeroHashes::at(mode, h);
+        Digest sibling = empty;
+        if ((proof.nonEmpty[h / 8] >> (h % 8)) & 1){
+            if (used == proof.siblings.size()){
+                return false;
+            }
+            sibling = proof.siblings[used++];
+        }
+
+        if (node == empty && sibling == empty){
+            node = ZeroHashes::at(mode, h + 1);
+        }
+        else if (bitAt(proof.key, h)){
+            node = SHA256Pair::hashPair(sibling, node, mode);
+        }
+        else {
+            node = SHA256Pair::hashPair(node, sibling, mode);
+        }
+    }
+    if (used != proof.siblings.size()){
+        return false;
+    }
+
+    root = node;
+    return true;
+}
+
+/**
+ * @note verifyMember() checks that the proof's key maps to value under root
+*/
+bool SparseMerkleTree::verifyMember(const SparseProof& proof, const string& value, const Digest& root, HashMode mode){
+    Digest computed;
+    return proof.leaf == leafHash(value) && computeRoot(proof, mode, computed) && computed == root;
+}
+
+/**
+ * @note verifyNonMember() checks that the proof's key is absent under root
+*/
+bool SparseMerkleTree::verifyNonMember(const SparseProof& proof, const Digest& root, HashMode mode){
+    Digest computed;
+    return proof.leaf == ZeroHashes::at(mode, 0) && computeRoot(proof, mode, computed) && computed == root;
+}
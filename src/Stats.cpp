@@ -0,0 +1,128 @@
+#include "lib.hpp"
+
+// Stats.cpp
+
+Stats::AtomicCounters Stats::counters;
+std::atomic<bool> Stats::traceEnabled{false};
+
+// one complete trace event
+struct TraceEvent {
+    const char* name;
+    int64_t arg;
+    size_t thread;
+    uint64_t startNs;
+    uint64_t durationNs;
+};
+
+static std::mutex traceLock;
+static vector<TraceEvent> traceEvents;
+
+// small, stable thread ids for the trace
+static std::atomic<size_t> nextThreadId{1};
+static thread_local size_t traceThreadId = 0;
+
+/**
+ * @note snapshot() reads every counter
+*/
+HashCounters Stats::snapshot(){
+    HashCounters now;
+    now.compressions = counters.compressions.load(std::memory_order_relaxed);
+    now.bytesHashed = counters.bytesHashed.load(std::memory_order_relaxed);
+    now.bitsConverted = counters.bitsConverted.load(std::memory_order_relaxed);
+    now.nodesAllocated = counters.nodesAllocated.load(std::memory_order_relaxed);
+    now.bytesAllocated = counters.bytesAllocated.load(std::memory_order_relaxed);
+    return now;
+}
+
+/**
+ * @note delta() returns how much every counter grew since an earlier snapshot
+*/
+HashCounters Stats::delta(const HashCounters& before){
+    HashCounters now = snapshot();
+    now.compressions -= before.compressions;
+    now.bytesHashed -= before.bytesHashed;
+    now.bitsConverted -= before.bitsConverted;
+    now.nodesAllocated -= before.nodesAllocated;
+    now.bytesAllocated -= before.bytesAllocated;
+    return now;
+}
+
+void Stats::reset(){
+    counters.compressions = 0;
+    counters.bytesHashed = 0;
+    counters.bitsConverted = 0;
+    counters.nodesAllocated = 0;
+    counters.bytesAllocated = 0;
+}
+
+/**
+ * @note now() returns a monotonic timestamp in nanoseconds
+*/
+uint64_t Stats::now(){
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @note startTrace() drops earlier events and starts recording
+*/
+void Stats::startTrace(){
+    std::lock_guard<std::mutex> guard(traceLock);
+    traceEvents.clear();
+    traceEnabled = true;
+}
+
+void Stats::stopTrace(){
+    traceEnabled = false;
+}
+
+void Stats::record(const char* name, int64_t arg, uint64_t startNs, uint64_t durationNs){
+    if (traceThreadId == 0){
+        traceThreadId = nextThreadId.fetch_add(1);
+    }
+    std::lock_guard<std::mutex> guard(traceLock);
+    traceEvents.push_back({name, arg, traceThreadId, startNs, durationNs});
+}
+
+/**
+ * @note writeTrace() saves the recorded events as Chrome trace JSON, timestamps in microseconds
+ * @param path is the output file
+*/
+void Stats::writeTrace(const string& path){
+    std::ofstream out(path);
+    if (!out){
+        throw std::runtime_error("Stats: cannot write " + path);
+    }
+
+    std::lock_guard<std::mutex> guard(traceLock);
+    uint64_t origin = traceEvents.empty() ? 0 : traceEvents[0].startNs;
+    for (const TraceEvent& event : traceEvents){
+        origin = std::min(origin, event.startNs);
+    }
+
+    out << "{\"traceEvents\": [\n";
+    for (size_t i=0; i<traceEvents.size(); i++){
+        const TraceEvent& event = traceEvents[i];
+        out << std::fixed << std::setprecision(3)
+            << "  {\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.thread
+            << ", \"ts\": " << double(event.startNs - origin) / 1000.0
+            << ", \"dur\": " << double(event.durationNs) / 1000.0;
+        if (event.arg >= 0){
+            out << ", \"args\": {\"n\": " << event.arg << "}";
+        }
+        out << "}" << (i + 1 < traceEvents.size() ? "," : "") << "\n";
+    }
+    out << "], \"displayTimeUnit\": \"ns\"}\n";
+}
+
+TraceScope::TraceScope(const char* name, uint64_t* elapsed, int64_t arg) : name(name), elapsed(elapsed), arg(arg), start(Stats::now()) {}
+
+TraceScope::~TraceScope(){
+    uint64_t duration = Stats::now() - start;
+    if (elapsed != nullptr){
+        *elapsed += duration;
+    }
+    if (Stats::tracing()){
+        Stats::record(name, arg, start, duration);
+    }
+}
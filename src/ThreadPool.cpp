@@ -0,0 +1,211 @@
+#include "lib.hpp"
+
+// ThreadPool.cpp
+
+// the pool and worker index of the current thread, used to route nested submissions
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local size_t currentWorker = 0;
+
+/**
+ * @note constructor starts the worker threads
+ * @param numThreads is the number of workers, 0 uses one per hardware thread
+*/
+ThreadPool::ThreadPool(size_t numThreads){
+    if (numThreads == 0){
+        numThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    for (size_t i=0; i<numThreads; i++){
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (size_t i=0; i<numThreads; i++){
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+/**
+ * @note destructor lets the workers drain their queues, then joins them
+*/
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers){
+        worker.join();
+    }
+}
+
+/**
+ * @note submit() schedules a task in the default group. From inside a worker the task goes to that
+ * worker's own deque, otherwise the deques are filled round robin.
+ * @param task is the work to run
+*/
+void ThreadPool::submit(std::function<void()> task){
+    submit(defaultGroup, std::move(task));
+}
+
+/**
+ * @note submit() schedules a task that counts towards group
+ * @param group is the group wait(group) waits for, it must outlive the task
+ * @param task is the work to run
+*/
+void ThreadPool::submit(TaskGroup& group, std::function<void()> task){
+    group.pending.fetch_add(1, std::memory_order_relaxed);
+
+    size_t index = (currentPool == this) ? currentWorker : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    {
+        std::lock_guard<std::mutex> guard(queues[index]->lock);
+        queues[index]->tasks.push_back({std::move(task), &group});
+
+        // counted before the lock is released, so a thief's decrement cannot come first
+        queued.fetch_add(1, std::memory_order_release);
+    }
+
+    // take the sleep lock so a worker checking for work cannot miss the notification
+    { std::lock_guard<std::mutex> guard(sleepLock); }
+    wake.notify_one();
+    idle.notify_all();
+}
+
+/**
+ * @note popTask() takes the newest task from the home deque, or steals the oldest task from another one
+ * @param home is the deque to try first
+ * @param task receives the task
+ * @returns false if every deque is empty
+*/
+bool ThreadPool::popTask(size_t home, Task& task){
+
+    // own work, last in first out
+    {
+        WorkQueue& queue = *queues[home];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (!queue.tasks.empty()){
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    // steal, first in first out, so thieves take the largest remaining pieces
+    for (size_t i=1; i<queues.size(); i++){
+        WorkQueue& queue = *queues[(home + i) % queues.size()];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (!queue.tasks.empty()){
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @note runOne() runs a single task if one can be found. An exception from the task is kept in its
+ * group, the first one wins.
+ * @returns false if there was nothing to run
+*/
+bool ThreadPool::runOne(size_t home){
+    Task task;
+    if (!popTask(home, task)){
+        return false;
+    }
+    try {
+        task.run();
+    } catch (...){
+        std::lock_guard<std::mutex> guard(task.group->errorLock);
+        if (!task.group->error){
+            task.group->error = std::current_exception();
+        }
+    }
+    finishTask(*task.group);
+    return true;
+}
+
+/**
+ * @note finishTask() counts a task of group as done and wakes waiters once the group is empty. The
+ * group may be gone as soon as its count reaches zero, so it is not touched after that.
+*/
+void ThreadPool::finishTask(TaskGroup& group){
+    if (group.pending.fetch_sub(1, std::memory_order_acq_rel) == 1){
+        { std::lock_guard<std::mutex> guard(sleepLock); }
+        idle.notify_all();
+    }
+}
+
+/**
+ * @note workerLoop() runs tasks until the pool is destroyed, sleeping while there is nothing to do
+*/
+void ThreadPool::workerLoop(size_t index){
+    currentPool = this;
+    currentWorker = index;
+
+    while (true){
+        if (runOne(index)){
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(sleepLock);
+        wake.wait(guard, [&]{ return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping && queued.load(std::memory_order_acquire) == 0){
+            return;
+        }
+    }
+}
+
+/**
+ * @note wait() blocks until all tasks of the default group are done. It must be called from outside
+ * the default group's tasks.
+*/
+void ThreadPool::wait(){
+    wait(defaultGroup);
+}
+
+/**
+ * @note wait() blocks until all tasks of group are done, running tasks on the calling thread while
+ * it waits, then rethrows the first exception a task of the group threw
+*/
+void ThreadPool::wait(TaskGroup& group){
+    size_t home = (currentPool == this) ? currentWorker : 0;
+    while (group.pending.load(std::memory_order_acquire) > 0){
+        if (runOne(home)){
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(sleepLock);
+        idle.wait(guard, [&]{
+            return group.pending.load(std::memory_order_acquire) == 0 || queued.load(std::memory_order_acquire) > 0;
+        });
+    }
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> guard(group.errorLock);
+        std::swap(error, group.error);
+    }
+    if (error){
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * @note parallelFor() splits [0, count) into ranges of grain items, runs body(begin, end) on each
+ * range across the pool and waits for all of them. The ranges form their own group, so it can be
+ * called from inside a task.
+ * @param count is the number of items
+ * @param grain is the number of items per task, at least 1
+ * @param body is called once per range
+*/
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body){
+    grain = std::max<size_t>(1, grain);
+    TaskGroup group;
+    for (size_t begin=0; begin<count; begin+=grain){
+        size_t end = std::min(count, begin + grain);
+        submit(group, [&body, begin, end]{ body(begin, end); });
+    }
+    wait(group);
+}
@@ -0,0 +1,295 @@
+#include "lib.hpp"
+
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// TreeFile.cpp
+
+// fixed part of the header, before the level offsets
+static constexpr size_t fixedHeader = 64;
+static constexpr char treeFileMagic[4] = {'M', 'K', 'L', 'T'};
+
+/**
+ * @note putLE() / getLE() store and load little endian integers of n bytes
+*/
+static void putLE(uint8_t* out, uint64_t value, size_t n){
+    for (size_t i=0; i<n; i++){
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+static uint64_t getLE(const uint8_t* in, size_t n){
+    uint64_t value = 0;
+    for (size_t i=0; i<n; i++){
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @note writeAll() writes len bytes to fd, retrying short writes
+ * @returns false on an I/O error
+*/
+static bool writeAll(int fd, const void* data, size_t len){
+    const char* bytes = static_cast<const char*>(data);
+    while (len > 0){
+        ssize_t n = ::write(fd, bytes, len);
+        if (n <= 0){
+            return false;
+        }
+        bytes += n;
+        len -= size_t(n);
+    }
+    return true;
+}
+
+/**
+ * @note write() serializes a tree to path. The file is written to a uniquely named temp file next to
+ * path, synced, and renamed over it, so readers see either the old tree or the complete new one, even
+ * after a crash.
+ * @param tree is the tree to store, must not be empty
+ * @param path is the destination file
+*/
+void TreeFile::write(const FlatTree& tree, const string& path){
+    assert(tree.leafCount() > 0);
+
+    vector<size_t> read(tree.levelCount(), 0);
+    write(path, tree.hashMode(), tree.leafCount(), [&](size_t level, Digest* buffer, size_t capacity){
+        size_t count = std::min(capacity, tree.levelSize(level) - read[level]);
+        std::memcpy(buffer, tree.level(level) + read[level], count * sizeof(Digest));
+        read[level] += count;
+        return count;
+    });
+}
+
+/**
+ * @note write() serializes a tree whose levels are streamed in, e.g. from scratch files, so the tree
+ * never has to be in memory. A placeholder header is written first, and the real one, with the body
+ * checksum taken while streaming, is written over it at the end.
+ * @param path is the destination file
+ * @param mode is the tree's hash mode
+ * @param leafCount is the number of leaves, > 0
+ * @param readLevel fills buffer with the next digests of a level, up to capacity, and returns how
+ * many. Levels are read in order, each from its start to its end.
+*/
+void TreeFile::write(const string& path, HashMode mode, size_t leafCount, const LevelReader& readLevel){
+    assert(leafCount > 0);
+
+    vector<size_t> sizes;
+    FlatTree::shape(leafCount, sizes);
+    size_t levelCount = sizes.size();
+    size_t headerSize = fixedHeader + 8 * levelCount + 32;
+
+    // level offsets, each rounded up to 64 bytes
+    vector<size_t> offsets(levelCount);
+    size_t offset = (headerSize + 63) & ~size_t(63);
+    for (size_t l=0; l<levelCount; l++){
+        offsets[l] = offset;
+        offset = (offset + 32 * sizes[l] + 63) & ~size_t(63);
+    }
+
+    vector<uint8_t> header(offsets[0], 0);
+    std::memcpy(header.data(), treeFileMagic, 4);
+    putLE(&header[4], version, 4);
+    putLE(&header[8], static_cast<uint32_t>(mode), 4);
+    putLE(&header[12], levelCount, 4);
+    putLE(&header[16], leafCount, 8);
+    for (size_t l=0; l<levelCount; l++){
+        putLE(&header[fixedHeader + 8 * l], offsets[l], 8);
+    }
+
+    // a unique temp file in the target's directory, so concurrent writers never share one
+    string tmpPath = path + ".XXXXXX";
+    int fd = ::mkstemp(tmpPath.data());
+    if (fd < 0){
+        throw std::runtime_error("TreeFile: cannot create a temp file for " + path);
+    }
+
+    // any failure until the rename drops the temp file
+    try {
+
+        // mkstemp() creates the file owner only, a tree file is shared like any other output
+        if (::fchmod(fd, 0644) != 0 || !writeAll(fd, header.data(), header.size())){
+            throw std::runtime_error("TreeFile: cannot write " + path);
+        }
+
+        // stream the levels through a fixed buffer, checksumming them on the way
+        SHA256 sha256;
+        sha256.init();
+        const char padding[64] = {};
+        vector<Digest> buffer(std::min<size_t>(sizes[0], writeBufferDigests));
+        for (size_t l=0; l<levelCount; l++){
+            for (size_t done=0; done<sizes[l]; ){
+                size_t count = readLevel(l, buffer.data(), std::min(buffer.size(), sizes[l] - done));
+                if (count == 0){
+                    throw std::runtime_error("TreeFile: level " + std::to_string(l) + " ended early");
+                }
+                sha256.update(buffer.data()->data(), 32 * count);
+                if (!writeAll(fd, buffer.data(), 32 * count)){
+                    throw std::runtime_error("TreeFile: cannot write " + path);
+                }
+                done += count;
+            }
+            size_t len = 32 * sizes[l];
+            if (!writeAll(fd, padding, ((len + 63) & ~size_t(63)) - len)){
+                throw std::runtime_error("TreeFile: cannot write " + path);
+            }
+        }
+        sha256.final(&header[32]);
+
+        sha256.init();
+        sha256.update(header.data(), headerSize - 32);
+        sha256.final(&header[headerSize - 32]);
+
+        // the contents reach the disk before the rename makes them visible under path
+        if (::pwrite(fd, header.data(), headerSize, 0) != ssize_t(headerSize) || ::fsync(fd) != 0){
+            throw std::runtime_error("TreeFile: cannot write " + path);
+        }
+        int closed = ::close(fd);
+        fd = -1;
+        if (closed != 0 || std::rename(tmpPath.c_str(), path.c_str()) != 0){
+            throw std::runtime_error("TreeFile: cannot write " + path);
+        }
+    }
+    catch (...){
+        if (fd >= 0){
+            ::close(fd);
+        }
+        std::remove(tmpPath.c_str());
+        throw;
+    }
+
+    // and the rename itself survives a crash once the directory is synced
+    string dir = std::filesystem::path(path).parent_path().string();
+    int dirFd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dirFd >= 0){
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+}
+
+/**
+ * @note constructor maps a tree file and checks its header. The level data is not read.
+ * @param path is the file to open
+*/
+TreeFile::TreeFile(const string& path) : base(nullptr), mappedSize(0), leaves(0), mode(HashMode::Hex), bodyChecksum() {
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0){
+        throw std::runtime_error("TreeFile: cannot open " + path);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || size_t(st.st_size) < fixedHeader){
+        ::close(fd);
+        throw std::runtime_error("TreeFile: not a tree file " + path);
+    }
+
+    mappedSize = size_t(st.st_size);
+    void* mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED){
+        throw std::runtime_error("TreeFile: cannot map " + path);
+    }
+    base = static_cast<const uint8_t*>(mapping);
+
+    // queries jump between levels, so read ahead would only waste I/O
+    madvise(mapping, mappedSize, MADV_RANDOM);
+
+    auto fail = [&](const string& reason){
+        munmap(mapping, mappedSize);
+        base = nullptr;
+        throw std::runtime_error("TreeFile: " + reason + " in " + path);
+    };
+
+    if (std::memcmp(base, treeFileMagic, 4) != 0){
+        fail("bad magic");
+    }
+    if (getLE(base + 4, 4) != version){
+        fail("unsupported version");
+    }
+    uint64_t modeValue = getLE(base + 8, 4);
+    if (modeValue > static_cast<uint64_t>(HashMode::Binary)){
+        fail("unknown hash mode");
+    }
+    mode = static_cast<HashMode>(modeValue);
+
+    leaves = getLE(base + 16, 8);
+    size_t levelCount = getLE(base + 12, 4);
+    if (leaves == 0 || levelCount > 65){
+        fail("bad shape");
+    }
+    FlatTree::shape(leaves, sizes);
+    size_t headerSize = fixedHeader + 8 * levelCount + 32;
+    if (sizes.size() != levelCount || headerSize > mappedSize){
+        fail("bad shape");
+    }
+
+    Digest headerChecksum;
+    SHA256 sha256;
+    sha256.init();
+    sha256.update(base, headerSize - 32);
+    sha256.final(headerChecksum.data());
+    if (std::memcmp(headerChecksum.data(), base + headerSize - 32, 32) != 0){
+        fail("header checksum mismatch");
+    }
+    std::memcpy(bodyChecksum.data(), base + 32, 32);
+
+    offsets.resize(levelCount);
+    for (size_t l=0; l<levelCount; l++){
+        offsets[l] = getLE(base + fixedHeader + 8 * l, 8);
+        if (offsets[l] < headerSize || offsets[l] % 64 != 0 || offsets[l] > mappedSize ||
+            (mappedSize - offsets[l]) / 32 < sizes[l]){
+            fail("level out of bounds");
+        }
+    }
+}
+
+TreeFile::TreeFile(TreeFile&& other) noexcept
+    : base(other.base), mappedSize(other.mappedSize), leaves(other.leaves), mode(other.mode),
+      bodyChecksum(other.bodyChecksum), offsets(std::move(other.offsets)), sizes(std::move(other.sizes)) {
+    other.base = nullptr;
+    other.mappedSize = 0;
+}
+
+TreeFile::~TreeFile(){
+    if (base != nullptr){
+        munmap(const_cast<uint8_t*>(base), mappedSize);
+    }
+}
+
+/**
+ * @note rootHex() returns the root digest as a hex string
+*/
+string TreeFile::rootHex() const {
+    return SHA256::toHex(root().data(), 32);
+}
+
+/**
+ * @note verify() reads every level and checks it against the body checksum
+ * @returns false if the level data was corrupted
+*/
+bool TreeFile::verify() const {
+    SHA256 sha256;
+    Digest checksum;
+    sha256.init();
+    for (size_t l=0; l<levelCount(); l++){
+        sha256.update(level(l)->data(), 32 * sizes[l]);
+    }
+    sha256.final(checksum.data());
+    return checksum == bodyChecksum;
+}
+
+/**
+ * @note toFlatTree() copies the mapped levels into a FlatTree
+*/
+FlatTree TreeFile::toFlatTree() const {
+    FlatTree tree(leaves, mode);
+    for (size_t l=0; l<levelCount(); l++){
+        std::memcpy(tree.level(l), level(l), 32 * sizes[l]);
+    }
+    return tree;
+}
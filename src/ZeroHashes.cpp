@@ -0,0 +1,26 @@
+#include "lib.hpp"
+
+// ZeroHashes.cpp
+
+// evaluated by the compiler, the tables are emitted as read-only data
+static constexpr array<Digest, ZeroHashes::maxHeight + 1> hexRoots = ZeroHashes::table(HashMode::Hex);
+static constexpr array<Digest, ZeroHashes::maxHeight + 1> binaryRoots = ZeroHashes::table(HashMode::Binary);
+
+// spot checks, the empty string digest and the root of two empty leaves
+static_assert(hexRoots[0] == SHA256Const::fromHex("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"));
+static_assert(binaryRoots[0] == hexRoots[0]);
+static_assert(binaryRoots[1] == SHA256Const::hash(array<uint8_t, 64>{
+    0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+    0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55,
+    0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+    0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55}.data(), 64));
+
+/**
+ * @note at() returns the root of an empty subtree
+ * @param mode is the parent hashing scheme
+ * @param height is the subtree height, at most maxHeight
+*/
+const Digest& ZeroHashes::at(HashMode mode, size_t height){
+    assert(height <= maxHeight);
+    return (mode == HashMode::Hex) ? hexRoots[height] : binaryRoots[height];
+}
@@ -1,13 +1,172 @@
 #include "lib.hpp"
 
 
+/**
+ * @note parseSize() reads a byte count with an optional K, M or G suffix (powers of 1024)
+ * @returns 0 if the text is not a size or does not fit in a size_t
+*/
+static size_t parseSize(const std::string& text) {
+
+    // stoull would take a sign or leading spaces, so the text has to start with a digit
+    if (text.empty() || text[0] < '0' || text[0] > '9') {
+        return 0;
+    }
+
+    size_t pos = 0;
+    unsigned long long value = 0;
+    try {
+        value = std::stoull(text, &pos);
+    }
+    catch (const std::exception&) {
+        return 0;
+    }
+
+    std::string suffix = text.substr(pos);
+    int shift = 0;
+    if (suffix == "" || suffix == "B") { shift = 0; }
+    else if (suffix == "K" || suffix == "KiB") { shift = 10; }
+    else if (suffix == "M" || suffix == "MiB") { shift = 20; }
+    else if (suffix == "G" || suffix == "GiB") { shift = 30; }
+    else { return 0; }
+
+    if (value > (SIZE_MAX >> shift)) {
+        return 0;
+    }
+    return size_t(value) << shift;
+}
+
+/**
+ * @note parseCount() reads a plain decimal count, without suffixes
+ * @returns false if the text is not a count
+*/
+static bool parseCount(const std::string& text, size_t& count) {
+    if (text.empty() || !std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return false;
+    }
+    try {
+        count = std::stoull(text);
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [string1] [string2] ..." << std::endl;
+    std::cout << "       " << program << " --files [options] path1 [path2] ..." << std::endl;
+    std::cout << std::endl;
+    std::cout << "File mode hashes files and directories in fixed size chunks, one leaf per chunk." << std::endl;
+    std::cout << "  --chunk-size SIZE  bytes per chunk, with optional K/M/G suffix (default 1M)" << std::endl;
+    std::cout << "  --threads N        hashing threads, 0 for one per hardware thread (default)" << std::endl;
+    std::cout << "  --per-file         also print the root of every file's chunks" << std::endl;
+    std::cout << "  --binary           hash parents over raw digests instead of hex text" << std::endl;
+    std::cout << "  --save PATH        write the tree to a tree file" << std::endl;
+}
+
+/**
+ * @note runFiles() is the chunked file mode: scan, hash chunks on a pool, build and report
+*/
+static int runFiles(int argc, char* argv[]) {
+
+    size_t chunkSize = size_t(1) << 20;
+    size_t threads = 0;
+    bool perFile = false;
+    HashMode mode = HashMode::Hex;
+    std::string savePath;
+    std::vector<std::string> paths;
+
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--chunk-size" && hasValue) {
+            chunkSize = parseSize(argv[++i]);
+            if (chunkSize == 0) {
+                std::cout << "Invalid chunk size: " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--threads" && hasValue) {
+            if (!parseCount(argv[++i], threads)) {
+                std::cout << "Invalid thread count: " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--per-file") {
+            perFile = true;
+        }
+        else if (arg == "--binary") {
+            mode = HashMode::Binary;
+        }
+        else if (arg == "--save" && hasValue) {
+            savePath = argv[++i];
+        }
+        else {
+            paths.push_back(arg);
+        }
+    }
+
+    if (paths.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+
+        FileHasher hasher(chunkSize, mode);
+        ThreadPool pool(threads);
+        std::vector<FileEntry> files = hasher.scan(paths);
+        if (files.empty()) {
+            std::cout << "No files found." << std::endl;
+            return 1;
+        }
+        std::vector<Digest> leaves = hasher.hashChunks(files, pool);
+        FlatTree tree = hasher.buildTree(leaves);
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        uint64_t totalBytes = 0;
+        for (const FileEntry& file : files) {
+            totalBytes += file.size;
+            if (perFile) {
+                Digest root = hasher.fileRoot(file, leaves);
+                std::cout << SHA256::toHex(root.data(), 32) << "  " << file.path << std::endl;
+            }
+        }
+
+        if (!savePath.empty()) {
+            TreeFile::write(tree, savePath);
+        }
+
+        double mib = double(totalBytes) / double(1 << 20);
+        std::cout << "Root hash: " << tree.rootHex() << std::endl;
+        std::cout << files.size() << " files, " << totalBytes << " bytes, " << leaves.size() << " chunks of "
+                  << chunkSize << " bytes, " << pool.size() << " threads" << std::endl;
+        std::cout << std::fixed << std::setprecision(3) << "Hashed " << mib << " MiB in " << elapsed.count()
+                  << " s (" << (elapsed.count() > 0 ? mib / elapsed.count() : 0.0) << " MiB/s)" << std::endl;
+    }
+    catch (const std::runtime_error& error) {
+        std::cout << error.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+
 int main(int argc, char* argv[]) {
     // Check if there are any string arguments
     if (argc < 2) {
-        std::cout << "Usage: " << argv[0] << " [string1] [string2] ..." << std::endl;
+        printUsage(argv[0]);
         return 1;
     }
 
+    // chunked file and directory mode
+    if (std::string(argv[1]) == "--files") {
+        return runFiles(argc, argv);
+    }
+
     // Read arguments into a vector of strings
     std::vector<std::string> inputs;
     for (int i = 1; i < argc; ++i) {
@@ -27,7 +186,7 @@ int main(int argc, char* argv[]) {
     }
 
     // print
-    std::cout << "Root hash: " << root->hash << std::endl;
+    std::cout << "Root hash: " << SHA256::toHex(root->digest.data(), 32) << std::endl;
 
     // cleanup
     merkelTree.freeTree(&root);
@@ -0,0 +1,17 @@
+#pragma once
+
+// testUtil.hpp
+//
+// Fixtures shared by the test programs. Include after lib.hpp.
+
+
+/**
+ * @note makeInputs() returns n distinct leaf strings
+*/
+inline vector<string> makeInputs(size_t n){
+    vector<string> inputs(n);
+    for (size_t i=0; i<n; i++){
+        inputs[i] = "record " + std::to_string(i);
+    }
+    return inputs;
+}
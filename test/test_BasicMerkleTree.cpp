@@ -0,0 +1,140 @@
+#include "lib.hpp"
+
+
+/**
+ * @note bytesOf() views a digest as a string, to hash it with a prefix
+*/
+string bytesOf(const uint8_t* digest, size_t len){
+    return string(reinterpret_cast<const char*>(digest), len);
+}
+
+/**
+ * @note referenceRoot() folds leaf digests into a root level by level with the given parent and
+ * alone functions, a straight reimplementation to check the policies against
+*/
+template <size_t N, class Node, class Alone>
+array<uint8_t, N> referenceRoot(vector<array<uint8_t, N>> level, Node node, Alone alone){
+    while (level.size() > 1){
+        vector<array<uint8_t, N>> parents;
+        for (size_t i=0; i<level.size(); i+=2){
+            parents.push_back((i + 1 < level.size()) ? node(level[i], level[i + 1]) : alone(level[i]));
+        }
+        level.swap(parents);
+    }
+    return level[0];
+}
+
+/**
+ * @test test_defaultPolicies() checks that the SHA-256 policies give the roots of MerkleTree, for
+ * sizes with and without nodes hashed alone
+*/
+void test_defaultPolicies(){
+
+    static_assert(std::is_same_v<BasicMerkleTree<>, BasicMerkleTree<SHA256HexPolicy>>);
+    for (size_t n : {1, 2, 3, 7, 8, 100, 1025}){
+        vector<string> input;
+        for (size_t i=0; i<n; i++){
+            input.push_back("leaf " + std::to_string(i));
+        }
+
+        BasicMerkleTree<> hexTree;
+        hexTree.build(input);
+        assert(hexTree.root() == MerkleTree(HashMode::Hex).buildTree(input).root());
+        assert(hexTree.rootHex() == MerkleTree(HashMode::Hex).computeRootHash(input));
+        assert(hexTree.leafCount() == n);
+
+        BasicMerkleTree<SHA256BinaryPolicy> binaryTree;
+        binaryTree.build(input);
+        FlatTree expected = MerkleTree(HashMode::Binary).buildTree(input);
+        assert(binaryTree.root() == expected.root());
+        assert(binaryTree.levelCount() == expected.levelCount());
+        for (size_t l=0; l<expected.levelCount(); l++){
+            for (size_t i=0; i<expected.levelSize(l); i++){
+                assert(binaryTree.node(l, i) == expected.node(l, i));
+            }
+        }
+    }
+
+    cout << "test_defaultPolicies()...Pass!" << endl;
+}
+
+/**
+ * @test test_otherPolicies() checks the domain separated, double and truncated policies against
+ * a reference fold, and that truncated nodes take only their digest size
+*/
+void test_otherPolicies(){
+
+    vector<string> input;
+    for (size_t i=0; i<13; i++){
+        input.push_back("record " + std::to_string(i));
+    }
+
+    // RFC 6962 style domain separation
+    {
+        vector<Digest> leaves;
+        for (const string& s : input){
+            leaves.push_back(SHA256Const::hash(string(1, '\0') + s));
+        }
+        Digest expected = referenceRoot<32>(leaves,
+            [](const Digest& l, const Digest& r){ return SHA256Const::hash("\x01" + bytesOf(l.data(), 32) + bytesOf(r.data(), 32)); },
+            [](const Digest& c){ return SHA256Const::hash("\x01" + bytesOf(c.data(), 32)); });
+
+        BasicMerkleTree<SHA256DomainPolicy> tree;
+        tree.build(input);
+        assert(tree.root() == expected);
+    }
+
+    // double SHA-256
+    {
+        auto hash2 = [](const string& s){
+            Digest inner = SHA256Const::hash(s);
+            return SHA256Const::hash(bytesOf(inner.data(), 32));
+        };
+        vector<Digest> leaves;
+        for (const string& s : input){
+            leaves.push_back(hash2(s));
+        }
+        Digest expected = referenceRoot<32>(leaves,
+            [&](const Digest& l, const Digest& r){ return hash2(bytesOf(l.data(), 32) + bytesOf(r.data(), 32)); },
+            [&](const Digest& c){ return hash2(bytesOf(c.data(), 32)); });
+
+        BasicMerkleTree<SHA256dPolicy> tree;
+        tree.build(input);
+        assert(tree.root() == expected);
+    }
+
+    // SHA-256 truncated to 16 bytes
+    {
+        typedef BasicMerkleTree<SHA256TruncatedPolicy<16>> Tree16;
+        static_assert(Tree16::digestSize == 16 && sizeof(Tree16::NodeDigest) == 16);
+
+        auto hash16 = [](const string& s){
+            Digest full = SHA256Const::hash(s);
+            array<uint8_t, 16> out;
+            std::copy(full.begin(), full.begin() + 16, out.begin());
+            return out;
+        };
+        vector<array<uint8_t, 16>> leaves;
+        for (const string& s : input){
+            leaves.push_back(hash16(s));
+        }
+        array<uint8_t, 16> expected = referenceRoot<16>(leaves,
+            [&](const array<uint8_t, 16>& l, const array<uint8_t, 16>& r){ return hash16(bytesOf(l.data(), 16) + bytesOf(r.data(), 16)); },
+            [&](const array<uint8_t, 16>& c){ return hash16(bytesOf(c.data(), 16)); });
+
+        Tree16 tree;
+        tree.build(input);
+        assert(tree.root() == expected);
+        assert(tree.rootHex().size() == 32);
+        assert(&tree.node(0, 1) - &tree.node(0, 0) == 1);
+    }
+
+    cout << "test_otherPolicies()...Pass!" << endl;
+}
+
+
+int main(void){
+    test_defaultPolicies();
+    test_otherPolicies();
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "lib.hpp"
+
+
+/**
+ * @note randomBytes() returns n pseudo random bytes
+*/
+vector<uint8_t> randomBytes(size_t n, uint32_t seed){
+    vector<uint8_t> data(n);
+    for (size_t i=0; i<n; i++){
+        seed = seed * 1103515245 + 12345;
+        data[i] = uint8_t(seed >> 16);
+    }
+    return data;
+}
+
+/**
+ * @note chunkHashes() returns the set of chunk digests of data
+*/
+vector<Digest> chunkHashes(const Chunker& chunker, const vector<uint8_t>& data){
+    vector<BatchMessage> chunks = chunker.split(data.data(), data.size());
+    vector<Digest> digests(chunks.size());
+    SHA256Batch::hash(chunks.data(), chunks.size(), digests.data()->data());
+    std::sort(digests.begin(), digests.end());
+    return digests;
+}
+
+/**
+ * @test test_bounds() checks that the chunks tile the input, respect the size bounds, and average
+ * near the target size
+*/
+void test_bounds(){
+
+    vector<uint8_t> data = randomBytes(size_t(4) << 20, 7);
+    for (size_t avg : {size_t(1) << 10, size_t(8) << 10, size_t(64) << 10}){
+        Chunker chunker(avg / 4, avg, avg * 8);
+        vector<BatchMessage> chunks = chunker.split(data.data(), data.size());
+
+        size_t offset = 0;
+        for (size_t k=0; k<chunks.size(); k++){
+            assert(chunks[k].data == data.data() + offset);
+            assert(chunks[k].len <= chunker.maxSize);
+            assert(chunks[k].len >= chunker.minSize || k + 1 == chunks.size());
+            offset += chunks[k].len;
+        }
+        assert(offset == data.size());
+
+        size_t mean = data.size() / chunks.size();
+        assert(mean > avg / 2 && mean < avg * 2);
+    }
+
+    Chunker chunker;
+    assert(chunker.split(data.data(), 0).empty());
+    assert(chunker.split(data.data(), 100).size() == 1);
+
+    cout << "test_bounds()...Pass!" << endl;
+}
+
+/**
+ * @test test_shiftResistance() inserts and deletes bytes near the start of the input and checks that
+ * almost every chunk after the edit keeps its hash
+*/
+void test_shiftResistance(){
+
+    Chunker chunker;
+    vector<uint8_t> data = randomBytes(size_t(1) << 20, 11);
+    vector<Digest> before = chunkHashes(chunker, data);
+
+    vector<uint8_t> inserted = data;
+    inserted.insert(inserted.begin() + 100, 0x42);
+    vector<uint8_t> deleted = data;
+    deleted.erase(deleted.begin() + 5000, deleted.begin() + 5010);
+
+    for (const vector<uint8_t>& edited : {inserted, deleted}){
+        vector<Digest> after = chunkHashes(chunker, edited);
+        vector<Digest> shared;
+        std::set_intersection(before.begin(), before.end(), after.begin(), after.end(), std::back_inserter(shared));
+        assert(shared.size() + 3 >= before.size());
+    }
+
+    cout << "test_shiftResistance()...Pass!" << endl;
+}
+
+/**
+ * @test test_buildTree() checks that a tree built straight from the chunks matches one built from the
+ * chunks copied into strings
+*/
+void test_buildTree(){
+
+    Chunker chunker(256, 1024, 4096);
+    vector<uint8_t> data = randomBytes(100000, 3);
+    vector<BatchMessage> chunks = chunker.split(data.data(), data.size());
+
+    vector<string> strings;
+    for (const BatchMessage& chunk : chunks){
+        strings.push_back(string(reinterpret_cast<const char*>(chunk.data), chunk.len));
+    }
+
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        MerkleTree merkelTree = MerkleTree(mode);
+        assert(merkelTree.buildTree(chunks).rootHex() == merkelTree.buildTree(strings).rootHex());
+    }
+
+    cout << "test_buildTree()...Pass!" << endl;
+}
+
+
+int main(void){
+    test_bounds();
+    test_shiftResistance();
+    test_buildTree();
+    return 0;
+}
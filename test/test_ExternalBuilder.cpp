@@ -0,0 +1,104 @@
+#include "lib.hpp"
+#include "testUtil.hpp"
+
+#include <filesystem>
+
+
+/**
+ * @note readFile() returns the bytes of a file
+*/
+string readFile(const string& path){
+    std::ifstream in(path, ios::binary);
+    std::stringstream bytes;
+    bytes << in.rdbuf();
+    return bytes.str();
+}
+
+/**
+ * @test test_externalRoots() checks the root against buildTree() for leaf counts around the block
+ * size and its powers, where the last block is partial and the passes end on odd nodes
+*/
+void test_externalRoots(){
+
+    string scratch = "bin/test_ExternalBuilder_scratch";
+    std::filesystem::remove_all(scratch);
+    std::filesystem::create_directories(scratch);
+
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        MerkleTree merkelTree(mode);
+        for (size_t n : {1, 2, 3, 31, 32, 33, 63, 64, 65, 1023, 1024, 1025, 5000}){
+            vector<string> inputs = makeInputs(n);
+            vector<std::string_view> views(inputs.begin(), inputs.end());
+            FlatTree expected = merkelTree.buildTree(inputs);
+
+            // the smallest budget, 32 leaves per block
+            ExternalBuilder builder(mode, 4096, "", scratch);
+            assert(builder.blockLeaves() == 32);
+            builder.append(std::span<const std::string_view>(views).first(n / 2));
+            for (size_t i=n/2; i<n; i++){
+                builder.append(views[i]);
+            }
+            assert(builder.leafCount() == n);
+            assert(builder.finish() == expected.root());
+            assert(std::filesystem::is_empty(scratch));
+
+            ExternalBuilder fromDigests(mode, 8192, "", scratch);
+            for (size_t i=0; i<n; i++){
+                fromDigests.appendDigest(expected.node(0, i));
+            }
+            assert(fromDigests.finish() == expected.root());
+        }
+    }
+
+    // scratch files of an unfinished build are removed too
+    {
+        ExternalBuilder abandoned(HashMode::Binary, 4096, "", scratch);
+        for (size_t i=0; i<100; i++){
+            abandoned.append("leaf");
+        }
+        assert(!std::filesystem::is_empty(scratch));
+    }
+    assert(std::filesystem::is_empty(scratch));
+
+    std::filesystem::remove_all(scratch);
+    cout << "test_externalRoots()...Pass!" << endl;
+}
+
+/**
+ * @test test_externalTreeFile() checks that the tree file written from the level files is byte for
+ * byte the file TreeFile::write() makes from the tree in memory
+*/
+void test_externalTreeFile(){
+
+    string path = "bin/test_ExternalBuilder.mklt";
+    string expectedPath = "bin/test_ExternalBuilder_expected.mklt";
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        for (size_t n : {1, 7, 32, 100, 3000}){
+            vector<string> inputs = makeInputs(n);
+            FlatTree expected = MerkleTree(mode).buildTree(inputs);
+            TreeFile::write(expected, expectedPath);
+
+            ExternalBuilder builder(mode, 4096, path);
+            for (const string& input : inputs){
+                builder.append(input);
+            }
+            assert(builder.finish() == expected.root());
+            assert(readFile(path) == readFile(expectedPath));
+
+            TreeFile file(path);
+            assert(file.verify());
+            assert(file.root() == expected.root() && file.leafCount() == n);
+        }
+    }
+
+    std::remove(path.c_str());
+    std::remove(expectedPath.c_str());
+    cout << "test_externalTreeFile()...Pass!" << endl;
+}
+
+
+int main(void){
+    test_externalRoots();
+    test_externalTreeFile();
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include "lib.hpp"
+
+#include <filesystem>
+
+
+/**
+ * @note writeFile() creates a file of n pseudo random bytes and returns its contents
+*/
+string writeFile(const string& path, size_t n, uint32_t seed){
+    string data(n, '\0');
+    for (size_t i=0; i<n; i++){
+        seed = seed * 1103515245 + 12345;
+        data[i] = char(seed >> 16);
+    }
+    std::ofstream out(path, std::ios::binary);
+    out.write(data.data(), data.size());
+    return data;
+}
+
+/**
+ * @note chunk() splits data into chunkSize pieces, an empty string is a single empty chunk
+*/
+vector<string> chunk(const string& data, size_t chunkSize){
+    vector<string> chunks;
+    for (size_t i=0; i<data.size(); i+=chunkSize){
+        chunks.push_back(data.substr(i, chunkSize));
+    }
+    if (chunks.empty()){
+        chunks.push_back("");
+    }
+    return chunks;
+}
+
+/**
+ * @test test_chunkedTree() hashes a directory of files with chunk and task sizes that do not line up
+ * with pages, and checks the root and per-file roots against trees built from the chunk strings
+*/
+void test_chunkedTree(){
+
+    string dir = "bin/test_FileHasher_dir";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir + "/sub");
+
+    // walked in sorted order: a.bin, b.bin, empty.bin, sub/c.bin
+    vector<string> contents;
+    contents.push_back(writeFile(dir + "/b.bin", 50000, 1));
+    contents.insert(contents.begin(), writeFile(dir + "/a.bin", 12345, 2));
+    contents.push_back(writeFile(dir + "/empty.bin", 0, 3));
+    contents.push_back(writeFile(dir + "/sub/c.bin", 5000, 4));
+
+    ThreadPool pool(4);
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        for (size_t chunkSize : {1000, 4096, 5000, 1 << 20}){
+            FileHasher hasher(chunkSize, mode);
+            hasher.taskBytes = 7 * chunkSize;
+
+            vector<FileEntry> files = hasher.scan({dir});
+            assert(files.size() == 4);
+            assert(files[0].path == dir + "/a.bin" && files[3].path == dir + "/sub/c.bin");
+
+            vector<Digest> leaves = hasher.hashChunks(files, pool);
+            FlatTree tree = hasher.buildTree(leaves);
+
+            MerkleTree merkelTree = MerkleTree(mode);
+            vector<string> allChunks;
+            for (size_t f=0; f<files.size(); f++){
+                vector<string> chunks = chunk(contents[f], chunkSize);
+                assert(files[f].leafCount == chunks.size());
+                assert(hasher.fileRoot(files[f], leaves) == merkelTree.buildTree(chunks).root());
+                allChunks.insert(allChunks.end(), chunks.begin(), chunks.end());
+            }
+            assert(tree.rootHex() == merkelTree.buildTree(allChunks).rootHex());
+        }
+    }
+
+    std::filesystem::remove_all(dir);
+
+    cout << "test_chunkedTree()...Pass!" << endl;
+}
+
+/**
+ * @test test_badPaths() checks that missing paths are rejected
+*/
+void test_badPaths(){
+
+    FileHasher hasher;
+    bool threw = false;
+    try {
+        hasher.scan({"bin/no_such_file"});
+    }
+    catch (const std::runtime_error&){
+        threw = true;
+    }
+    assert(threw);
+
+    cout << "test_badPaths()...Pass!" << endl;
+}
+
+/**
+ * @test test_changedFiles() rewrites a file between scan() and hashChunks() and checks the hash
+ * fails instead of reading past the new end, and that nothing is cached under the old key
+*/
+void test_changedFiles(){
+
+    string dir = "bin/test_FileHasher_changed";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    writeFile(dir + "/a.bin", 100000, 1);
+
+    ThreadPool pool(2);
+    HashCache cache;
+    FileHasher hasher(4096);
+    hasher.cache = &cache;
+    vector<FileEntry> files = hasher.scan({dir});
+
+    // shrunk by more than a page
+    writeFile(dir + "/a.bin", 10000, 1);
+    bool threw = false;
+    try {
+        hasher.hashChunks(files, pool);
+    }
+    catch (const std::runtime_error& error){
+        threw = string(error.what()).find("changed") != string::npos;
+    }
+    assert(threw);
+    assert(cache.stats().entries == 0);
+
+    // a rescan picks up the new contents
+    files = hasher.scan({dir});
+    FileHasher uncached(4096);
+    assert(hasher.hashChunks(files, pool) == uncached.hashChunks(files, pool));
+    assert(cache.stats().entries == files[0].leafCount);
+
+    std::filesystem::remove_all(dir);
+    cout << "test_changedFiles()...Pass!" << endl;
+}
+
+
+int main(void){
+    test_chunkedTree();
+    test_badPaths();
+    test_changedFiles();
+    return 0;
+}
@@ -0,0 +1,277 @@
+#include "lib.hpp"
+
+
+/**
+ * @test test_layout() checks the level sizes and the buffer alignment of a flat tree
+*/
+void test_layout(){
+
+    FlatTree tree(9, HashMode::Hex);
+
+    // 9 -> 5 -> 3 -> 2 -> 1
+    size_t expected[] = {9, 5, 3, 2, 1};
+    assert(tree.levelCount() == 5);
+    for (size_t l=0; l<tree.levelCount(); l++){
+        assert(tree.levelSize(l) == expected[l]);
+    }
+
+    // levels sit back to back in one aligned buffer
+    assert(reinterpret_cast<uintptr_t>(tree.level(0)) % FlatTree::alignment == 0);
+    for (size_t l=0; l+1<tree.levelCount(); l++){
+        assert(tree.level(l) + tree.levelSize(l) == tree.level(l + 1));
+    }
+
+    // single leaf tree is its own root
+    FlatTree single(1, HashMode::Binary);
+    assert(single.levelCount() == 1);
+    assert(&single.root() == single.level(0));
+
+    // no leaves is rejected, and a resize to none leaves the tree as it was
+    bool threw = false;
+    try {
+        FlatTree empty(0, HashMode::Hex);
+    }
+    catch (const std::invalid_argument&){
+        threw = true;
+    }
+    assert(threw);
+    threw = false;
+    try {
+        tree.resize(0);
+    }
+    catch (const std::invalid_argument&){
+        threw = true;
+    }
+    assert(threw && tree.leafCount() == 9 && tree.levelCount() == 5);
+
+    // index arithmetic
+    assert(FlatTree::parent(7) == 3 && FlatTree::leftChild(3) == 6 && FlatTree::rightChild(3) == 7);
+    assert(FlatTree::sibling(6) == 7 && FlatTree::sibling(7) == 6);
+
+    cout << "test_layout()...Pass!" << endl;
+}
+
+/**
+ * @test test_buildTree() checks that the flat tree matches the node tree built by assembleTree() in
+ * both hash modes, node for node
+*/
+void test_buildTree(){
+
+    vector<string> inputs;
+    for (int i=1; i<=37; i++){
+        inputs.push_back(std::to_string(i));
+    }
+
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        MerkleTree merkelTree = MerkleTree(mode);
+        FlatTree tree = merkelTree.buildTree(inputs);
+        TreeNode* root = merkelTree.assembleTree(inputs);
+        assert(root->digest == tree.root());
+
+        // walk the left spine and compare against level starts
+        TreeNode* node = root;
+        for (size_t l=tree.levelCount(); l-- > 0;){
+            assert(node->digest == tree.node(l, 0));
+            node = node->ancestors[0];
+        }
+        assert(node == nullptr);
+
+        // each parent hashes its children
+        for (size_t l=1; l<tree.levelCount(); l++){
+            for (size_t i=0; i<tree.levelSize(l); i++){
+                Digest parent;
+                merkelTree.hashLevel(&tree.node(l - 1, FlatTree::leftChild(i)),
+                                     std::min<size_t>(2, tree.levelSize(l - 1) - FlatTree::leftChild(i)), &parent);
+                assert(parent == tree.node(l, i));
+            }
+        }
+
+        merkelTree.freeTree(&root);
+    }
+
+    // hex root matches the known value
+    MerkleTree merkelTree = MerkleTree();
+    assert(merkelTree.buildTree({"1", "2", "3", "4", "5", "6", "7", "8", "9"}).rootHex() ==
+           "4a1894dff02e07c0b2306901e5447009f279378f935dd77c68e2b2baa653b603");
+
+    cout << "test_buildTree()...Pass!" << endl;
+}
+
+/**
+ * @test test_copyAndMove() checks that copies are deep and moves leave the source empty
+*/
+void test_copyAndMove(){
+
+    MerkleTree merkelTree = MerkleTree(HashMode::Binary);
+    FlatTree tree = merkelTree.buildTree({"a", "b", "c"});
+
+    FlatTree copy = tree;
+    assert(copy.root() == tree.root());
+    copy.node(0, 0)[0] ^= 1;
+    assert(copy.node(0, 0) != tree.node(0, 0));
+
+    FlatTree moved = std::move(tree);
+    assert(moved.leafCount() == 3);
+    assert(tree.leafCount() == 0 && tree.levelCount() == 0);
+
+    cout << "test_copyAndMove()...Pass!" << endl;
+}
+
+/**
+ * @test test_freeDeepTree() frees a degenerate chain of nodes far deeper than a recursive freeTree()
+ * could handle
+*/
+void test_freeDeepTree(){
+
+    MerkleTree merkelTree = MerkleTree();
+    TreeNode* root = nullptr;
+    for (int i=0; i<1000000; i++){
+        TreeNode* node = new TreeNode;
+        node->ancestors[0] = root;
+        node->ancestors[1] = nullptr;
+        root = node;
+    }
+
+    merkelTree.freeTree(&root);
+    assert(root == nullptr);
+
+    cout << "test_freeDeepTree()...Pass!" << endl;
+}
+
+/**
+ * @test test_parallelBuild() checks that building on a thread pool gives a tree identical to the
+ * sequential build, for leaf counts around the subtree size and with odd nodes on every level
+*/
+void test_parallelBuild(){
+
+    ThreadPool pool(4);
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        MerkleTree merkelTree = MerkleTree(mode);
+        for (size_t n : {1, 2, 7, 8, 9, 31, 33, 100, 257}){
+            vector<string> inputs;
+            for (size_t i=0; i<n; i++){
+                inputs.push_back("leaf " + std::to_string(i));
+            }
+
+            FlatTree sequential = merkelTree.buildTree(inputs);
+            for (size_t subtreeLeaves : {1, 2, 8, 32, 0}){
+                FlatTree parallel = merkelTree.buildTree(inputs, pool, subtreeLeaves);
+                assert(parallel.levelCount() == sequential.levelCount());
+                for (size_t l=0; l<sequential.levelCount(); l++){
+                    assert(std::equal(sequential.level(l), sequential.level(l) + sequential.levelSize(l), parallel.level(l)));
+                }
+            }
+        }
+    }
+
+    cout << "test_parallelBuild()...Pass!" << endl;
+}
+
+
+/**
+ * @test test_updateLeaves() checks that single and batched leaf updates leave the tree identical to a
+ * full rebuild of the changed inputs, including a batch large enough to be split across the pool
+*/
+void test_updateLeaves(){
+
+    ThreadPool pool(4);
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        MerkleTree merkelTree = MerkleTree(mode);
+        for (size_t n : {1, 2, 7, 9, 100, 20000}){
+            vector<string> inputs;
+            for (size_t i=0; i<n; i++){
+                inputs.push_back("leaf " + std::to_string(i));
+            }
+            FlatTree tree = merkelTree.buildTree(inputs);
+
+            // single updates, first, last and middle
+            for (size_t i : {size_t(0), n - 1, n / 2}){
+                inputs[i] = "updated " + std::to_string(i);
+                merkelTree.updateLeaf(tree, i, inputs[i]);
+            }
+            assert(tree.rootHex() == merkelTree.buildTree(inputs).rootHex());
+
+            // a batch with shared ancestors and a repeated index, the later update wins
+            vector<std::pair<size_t, string>> updates;
+            for (size_t i=0; i<n; i+=3){
+                updates.push_back({i, "batch " + std::to_string(i)});
+            }
+            updates.push_back({0, "batch last"});
+            for (const auto& [i, data] : updates){
+                inputs[i] = data;
+            }
+            merkelTree.updateLeaves(tree, updates, &pool);
+
+            FlatTree rebuilt = merkelTree.buildTree(inputs);
+            for (size_t l=0; l<rebuilt.levelCount(); l++){
+                assert(std::equal(rebuilt.level(l), rebuilt.level(l) + rebuilt.levelSize(l), tree.level(l)));
+            }
+        }
+    }
+
+    cout << "test_updateLeaves()...Pass!" << endl;
+}
+
+/**
+ * @test test_appendAndTruncate() grows a tree one append at a time from empty, truncates it back
+ * down, and checks every intermediate root against a full rebuild
+*/
+void test_appendAndTruncate(){
+
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        MerkleTree merkelTree = MerkleTree(mode);
+        FlatTree tree(1, mode);
+        vector<string> inputs = {"leaf 0"};
+        merkelTree.updateLeaf(tree, 0, inputs[0]);
+
+        for (size_t batch : {1, 1, 2, 5, 1, 17, 64, 3}){
+            vector<string> more;
+            for (size_t k=0; k<batch; k++){
+                more.push_back("leaf " + std::to_string(inputs.size() + k));
+            }
+            inputs.insert(inputs.end(), more.begin(), more.end());
+            merkelTree.appendLeaves(tree, more);
+
+            assert(tree.leafCount() == inputs.size());
+            assert(tree.leafCapacity() >= inputs.size());
+            assert(tree.rootHex() == merkelTree.buildTree(inputs).rootHex());
+        }
+
+        size_t capacity = tree.leafCapacity();
+        for (size_t m : {90, 64, 33, 8, 7, 2, 1}){
+            inputs.resize(m);
+            merkelTree.truncateLeaves(tree, m);
+            assert(tree.leafCount() == m);
+            assert(tree.levelCount() == merkelTree.buildTree(inputs).levelCount());
+            assert(tree.rootHex() == merkelTree.buildTree(inputs).rootHex());
+        }
+        assert(tree.leafCapacity() == capacity);
+
+        // growing again after a truncate reuses the spare slots
+        inputs.push_back("again");
+        merkelTree.appendLeaves(tree, {"again"});
+        assert(tree.rootHex() == merkelTree.buildTree(inputs).rootHex());
+    }
+
+    // appending to an empty tree of either mode builds it from scratch
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        MerkleTree merkelTree = MerkleTree(mode);
+        FlatTree empty(mode);
+        assert(empty.leafCount() == 0 && empty.hashMode() == mode);
+        merkelTree.appendLeaves(empty, {"a", "b", "c"});
+        assert(empty.root() == merkelTree.buildTree(vector<string>{"a", "b", "c"}).root());
+    }
+
+    cout << "test_appendAndTruncate()...Pass!" << endl;
+}
+
+int main(void){
+    test_layout();
+    test_buildTree();
+    test_copyAndMove();
+    test_freeDeepTree();
+    test_parallelBuild();
+    test_updateLeaves();
+    test_appendAndTruncate();
+    return 0;
+}
@@ -0,0 +1,184 @@
+#include "lib.hpp"
+
+#include <filesystem>
+
+
+/**
+ * @note makeRepeatedInputs() returns n leaf strings drawn from the given number of distinct values, so most are repeats
+*/
+vector<string> makeRepeatedInputs(size_t n, size_t distinct){
+    vector<string> inputs;
+    for (size_t i=0; i<n; i++){
+        inputs.push_back("record " + std::to_string((i * 7919) % distinct));
+    }
+    return inputs;
+}
+
+/**
+ * @test test_lookupAndEvict() checks hits, misses, that kinds do not collide, and that CLOCK evicts
+ * an entry that was not used since it was inserted before the ones that were
+*/
+void test_lookupAndEvict(){
+
+    // one shard that holds exactly three short entries
+    HashCache cache(3 * (HashCache::entryOverhead + 2), 1);
+    Digest a = SHA256Const::hash("a"), b = SHA256Const::hash("b"), c = SHA256Const::hash("c");
+    Digest out;
+
+    assert(!cache.lookup(CacheKind::Leaf, "k1", out));
+    cache.insert(CacheKind::Leaf, "k1", a);
+    cache.insert(CacheKind::Leaf, "k2", b);
+    cache.insert(CacheKind::File, "k1", c);
+    assert(cache.lookup(CacheKind::Leaf, "k1", out) && out == a);
+    assert(cache.lookup(CacheKind::File, "k1", out) && out == c);
+
+    // k2 is the only entry without its referenced bit and makes room for k3
+    cache.insert(CacheKind::Leaf, "k3", c);
+    assert(!cache.lookup(CacheKind::Leaf, "k2", out));
+    assert(cache.lookup(CacheKind::Leaf, "k1", out) && out == a);
+    assert(cache.lookup(CacheKind::Leaf, "k3", out) && out == c);
+
+    CacheStats stats = cache.stats();
+    assert(stats.hits == 4 && stats.misses == 2);
+    assert(stats.insertions == 4 && stats.evictions == 1);
+    assert(stats.entries == 3 && stats.bytes <= cache.capacity());
+
+    // pairs are keyed by mode as well as by the children
+    cache.insertPair(a, b, HashMode::Hex, c);
+    assert(cache.lookupPair(a, b, HashMode::Hex, out) && out == c);
+    assert(!cache.lookupPair(a, b, HashMode::Binary, out));
+    assert(!cache.lookupPair(b, a, HashMode::Hex, out));
+
+    cache.clear();
+    assert(cache.stats().entries == 0 && cache.stats().hits == 0);
+
+    cout << "test_lookupAndEvict()...Pass!" << endl;
+}
+
+/**
+ * @test test_cachedBuild() checks that cached builds give the same roots, that a repeated leaf is
+ * hashed once, and that a rebuild of the same data is served entirely from the cache
+*/
+void test_cachedBuild(){
+
+    ThreadPool pool(4);
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        vector<string> inputs = makeRepeatedInputs(5000, 300);
+        MerkleTree plain = MerkleTree(mode);
+        FlatTree expected = plain.buildTree(inputs);
+
+        HashCache cache;
+        MerkleTree cached = MerkleTree(mode);
+        cached.cache = &cache;
+        assert(cached.buildTree(inputs).root() == expected.root());
+
+        // 300 distinct leaves, each cached once
+        CacheStats first = cache.stats();
+        size_t leafEntries = 300;
+        assert(first.entries > leafEntries);
+
+        // the rebuild misses nothing
+        assert(cached.buildTree(inputs).root() == expected.root());
+        assert(cached.buildTree(inputs, pool, 512).root() == expected.root());
+        CacheStats second = cache.stats();
+        assert(second.misses == first.misses);
+        assert(second.entries == first.entries);
+
+        // one changed leaf only misses on its own path
+        inputs[1234] = "changed";
+        assert(cached.buildTree(inputs).root() == plain.buildTree(inputs).root());
+        CacheStats third = cache.stats();
+        assert(third.misses - second.misses == 1 + expected.levelCount() - 1);
+    }
+
+    cout << "test_cachedBuild()...Pass!" << endl;
+}
+
+/**
+ * @test test_cachedChunks() checks that a build over content defined chunks goes through the cache,
+ * so a second build of the same data hashes no chunk again
+*/
+void test_cachedChunks(){
+
+    vector<uint8_t> data(size_t(1) << 20);
+    uint32_t seed = 7;
+    for (uint8_t& byte : data){
+        seed = seed * 1103515245 + 12345;
+        byte = uint8_t(seed >> 16);
+    }
+    vector<BatchMessage> chunks = Chunker().split(data.data(), data.size());
+
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        HashCache cache;
+        MerkleTree cached = MerkleTree(mode);
+        cached.cache = &cache;
+        Digest expected = MerkleTree(mode).buildTree(chunks).root();
+        assert(cached.buildTree(chunks).root() == expected);
+
+        CacheStats first = cache.stats();
+        assert(first.entries >= chunks.size());
+        assert(cached.buildTree(chunks).root() == expected);
+        CacheStats second = cache.stats();
+        assert(second.misses == first.misses);
+        assert(second.hits - first.hits >= chunks.size());
+    }
+
+    cout << "test_cachedChunks()...Pass!" << endl;
+}
+
+/**
+ * @test test_cachedFiles() checks that unchanged files are served from the cache and that a
+ * rewritten file is hashed again
+*/
+void test_cachedFiles(){
+
+    string dir = "bin/test_HashCache_dir";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    for (int f=0; f<3; f++){
+        std::ofstream out(dir + "/" + std::to_string(f) + ".bin", std::ios::binary);
+        out << string(10000 + 1000 * f, char('a' + f));
+    }
+
+    ThreadPool pool(2);
+    HashCache cache;
+    FileHasher hasher(4096, HashMode::Binary);
+    hasher.cache = &cache;
+
+    vector<FileEntry> files = hasher.scan({dir});
+    vector<Digest> leaves = hasher.hashChunks(files, pool);
+    CacheStats first = cache.stats();
+    assert(first.entries > 0 && first.hits == 0);
+
+    FileHasher uncached(4096, HashMode::Binary);
+    assert(hasher.buildTree(leaves).root() == uncached.buildTree(uncached.hashChunks(files, pool)).root());
+
+    // same files, every chunk is a hit
+    CacheStats before = cache.stats();
+    assert(hasher.hashChunks(hasher.scan({dir}), pool) == leaves);
+    CacheStats after = cache.stats();
+    assert(after.misses == before.misses);
+    assert(after.hits - before.hits == 3 + 3 + 3);
+
+    // a rewritten file has a new size, so its chunks are hashed again
+    {
+        std::ofstream out(dir + "/1.bin", std::ios::binary);
+        out << string(9000, 'z');
+    }
+    files = hasher.scan({dir});
+    vector<Digest> changed = hasher.hashChunks(files, pool);
+    assert(changed == uncached.hashChunks(files, pool));
+    assert(changed[files[1].firstLeaf] != leaves[files[1].firstLeaf]);
+
+    std::filesystem::remove_all(dir);
+    cout << "test_cachedFiles()...Pass!" << endl;
+}
+
+
+int main(void){
+    test_lookupAndEvict();
+    test_cachedBuild();
+    test_cachedChunks();
+    test_cachedFiles();
+    return 0;
+}
@@ -39,6 +39,7 @@ void test_assembleTree(){
 
     // Assemble the tree
     TreeNode* root = merkelTree.assembleTree(inputs);
+    assert(root->hash == "4a1894dff02e07c0b2306901e5447009f279378f935dd77c68e2b2baa653b603");
 
     // cleanup
     merkelTree.freeTree(&root);
@@ -48,9 +49,98 @@ void test_assembleTree(){
     cout << "test_assembleTree()...PASS!" << endl;
 }
 
+/**
+ * @test test_assembleTreeBatchBackends() builds a tree large enough to fill every SIMD lane with
+ * each batch backend and checks the root against an independently computed value
+ */
+void test_assembleTreeBatchBackends(){
+
+    vector<string> inputs;
+    for (int i=1; i<=100; i++){
+        inputs.push_back(std::to_string(i));
+    }
+
+    string initial = SHA256Batch::active().name;
+    for (const BatchBackend& backend : SHA256Batch::available()){
+        bool selected = SHA256Batch::select(backend.name);
+        assert(selected);
+
+        MerkleTree merkelTree = MerkleTree();
+        TreeNode* root = merkelTree.assembleTree(inputs);
+        assert(root->hash == "35cb6bc8540089bd5a73a544b2c23713bb2cb13ff1eb74dbc748dcb559319e42");
+        merkelTree.freeTree(&root);
+    }
+    bool restored = SHA256Batch::select(initial);
+    assert(restored);
+
+    cout << "test_assembleTreeBatchBackends()...PASS!" << endl;
+}
+
+/**
+ * @test test_binaryHashMode() checks that in HashMode::Binary parents hash the raw digests of their
+ * children, that computeRootHash() agrees with assembleTree() in both modes, and that newTreeNode()
+ * reproduces the parents built by assembleTree()
+ */
+void test_binaryHashMode(){
+
+    vector<string> inputs = {"1", "2", "3", "4", "5", "6", "7", "8", "9"};
+
+    // binary mode root, independently computed
+    MerkleTree binaryTree = MerkleTree(HashMode::Binary);
+    TreeNode* root = binaryTree.assembleTree(inputs);
+    assert(root->hash.empty());
+    assert(SHA256::toHex(root->digest.data(), 32) == "082891aadb82323d4637aec935fe831d667cfd672f3f099484aad2b8a8f8af7e");
+    assert(binaryTree.computeRootHash(inputs) == "082891aadb82323d4637aec935fe831d667cfd672f3f099484aad2b8a8f8af7e");
+
+    // rehash the root from its children, root has a left and a right child
+    TreeNode* rehashed = binaryTree.newTreeNode(root->ancestors[0], root->ancestors[1]);
+    assert(rehashed->digest == root->digest);
+    delete rehashed;
+    binaryTree.freeTree(&root);
+
+    // hex mode keeps the original roots
+    MerkleTree hexTree = MerkleTree();
+    assert(hexTree.computeRootHash(inputs) == "4a1894dff02e07c0b2306901e5447009f279378f935dd77c68e2b2baa653b603");
+    root = hexTree.assembleTree(inputs);
+    assert(SHA256::toHex(root->digest.data(), 32) == root->hash);
+    rehashed = hexTree.newTreeNode(root->ancestors[0], root->ancestors[1]);
+    assert(rehashed->hash == root->hash);
+    delete rehashed;
+
+    // the lone 9th leaf is promoted by hashing it alone
+    TreeNode* lone = root->ancestors[1];
+    assert(lone->ancestors[1] == nullptr);
+    rehashed = hexTree.newTreeNode(lone->ancestors[0], nullptr);
+    assert(rehashed->hash == lone->hash);
+    delete rehashed;
+    hexTree.freeTree(&root);
+
+    cout << "test_binaryHashMode()...PASS!" << endl;
+}
+
+/**
+ * @test test_zeroHashes() checks the compile time empty subtree roots against trees built over 2^h
+ * empty leaves in both hash modes
+*/
+void test_zeroHashes(){
+
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        MerkleTree merkelTree = MerkleTree(mode);
+        for (size_t h=0; h<=10; h++){
+            vector<string> empty(size_t(1) << h, "");
+            assert(merkelTree.buildTree(empty).root() == ZeroHashes::at(mode, h));
+        }
+    }
+
+    cout << "test_zeroHashes()...PASS!" << endl;
+}
+
 
 int main(void){
     test_hashInputStrings();
     test_assembleTree();
+    test_assembleTreeBatchBackends();
+    test_binaryHashMode();
+    test_zeroHashes();
     return 0;
 }
\ No newline at end of file
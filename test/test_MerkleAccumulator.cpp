@@ -0,0 +1,136 @@
+#include "lib.hpp"
+
+
+/**
+ * @test test_matchesTree() appends leaves one at a time and checks the root after every append
+ * against a full build of the same prefix, in both hash modes
+*/
+void test_matchesTree(){
+
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        MerkleTree merkelTree = MerkleTree(mode);
+        MerkleAccumulator accumulator(mode);
+        vector<string> inputs;
+        for (size_t i=0; i<300; i++){
+            inputs.push_back("record " + std::to_string(i));
+            accumulator.append(inputs.back());
+            assert(accumulator.leafCount() == inputs.size());
+            assert(accumulator.rootHex() == merkelTree.buildTree(inputs).rootHex());
+        }
+    }
+
+    // the known root of leaves "1".."9"
+    MerkleAccumulator accumulator;
+    for (int i=1; i<=9; i++){
+        accumulator.append(std::to_string(i));
+    }
+    assert(accumulator.rootHex() == "4a1894dff02e07c0b2306901e5447009f279378f935dd77c68e2b2baa653b603");
+
+    cout << "test_matchesTree()...Pass!" << endl;
+}
+
+/**
+ * @test test_batchAppend() checks that appending in batches of uneven sizes gives the same root as
+ * appending one leaf at a time
+*/
+void test_batchAppend(){
+
+    MerkleAccumulator single(HashMode::Binary);
+    MerkleAccumulator batched(HashMode::Binary);
+    size_t next = 0;
+    for (size_t batch : {1, 3, 0, 16, 7, 100, 2}){
+        vector<string> inputs;
+        for (size_t k=0; k<batch; k++){
+            inputs.push_back("record " + std::to_string(next++));
+            single.append(inputs.back());
+        }
+        batched.append(inputs);
+    }
+
+    assert(batched.leafCount() == single.leafCount());
+    assert(batched.root() == single.root());
+
+    cout << "test_batchAppend()...Pass!" << endl;
+}
+
+/**
+ * @test test_appendSubtree() checks that appending the roots of aligned perfect subtrees gives the
+ * same root as appending their leaves
+*/
+void test_appendSubtree(){
+
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        vector<string> inputs;
+        for (size_t i=0; i<45; i++){
+            inputs.push_back("record " + std::to_string(i));
+        }
+        FlatTree tree = MerkleTree(mode).buildTree(inputs);
+
+        // 45 = 32 + 8 + 4 + 1, taken as subtrees of heights 5, 3, 2 and 0
+        MerkleAccumulator accumulator(mode);
+        accumulator.appendSubtree(tree.node(5, 0), 5);
+        accumulator.appendSubtree(tree.node(3, 4), 3);
+        accumulator.appendSubtree(tree.node(2, 10), 2);
+        accumulator.appendSubtree(tree.node(0, 44), 0);
+        assert(accumulator.leafCount() == 45);
+        assert(accumulator.root() == tree.root());
+    }
+
+    cout << "test_appendSubtree()...Pass!" << endl;
+}
+
+/**
+ * @test test_checkpoint() checkpoints mid stream, resumes from the blob and checks the resumed
+ * accumulator ends on the same root. Malformed blobs must be rejected.
+*/
+void test_checkpoint(){
+
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        MerkleAccumulator accumulator(mode);
+        for (size_t i=0; i<77; i++){
+            accumulator.append("record " + std::to_string(i));
+        }
+
+        vector<uint8_t> blob = accumulator.checkpoint();
+        assert(blob.size() == 16 + 32 * std::popcount(uint64_t(77)));
+
+        MerkleAccumulator resumed = MerkleAccumulator::restore(blob);
+        assert(resumed.hashMode() == mode);
+        assert(resumed.leafCount() == 77);
+        assert(resumed.root() == accumulator.root());
+
+        for (size_t i=77; i<130; i++){
+            accumulator.append("record " + std::to_string(i));
+            resumed.append("record " + std::to_string(i));
+        }
+        assert(resumed.root() == accumulator.root());
+
+        // truncated, wrong magic, and a leaf count that does not match the digests
+        for (size_t corrupt=0; corrupt<3; corrupt++){
+            vector<uint8_t> bad = blob;
+            if (corrupt == 0) { bad.pop_back(); }
+            if (corrupt == 1) { bad[0] ^= 1; }
+            if (corrupt == 2) { bad[8] ^= 2; }
+
+            bool threw = false;
+            try {
+                MerkleAccumulator::restore(bad);
+            }
+            catch (const std::runtime_error&){
+                threw = true;
+            }
+            assert(threw);
+        }
+    }
+
+    cout << "test_checkpoint()...Pass!" << endl;
+}
+
+
+int main(void){
+    test_matchesTree();
+    test_batchAppend();
+    test_appendSubtree();
+    test_checkpoint();
+    return 0;
+}
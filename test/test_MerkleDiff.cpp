@@ -0,0 +1,112 @@
+#include "lib.hpp"
+#include "testUtil.hpp"
+
+
+/**
+ * @note bruteForce() compares two trees leaf by leaf and returns the differing ranges, merged
+*/
+vector<std::pair<size_t, size_t>> bruteForce(const FlatTree& a, const FlatTree& b){
+    vector<std::pair<size_t, size_t>> ranges;
+    size_t longest = std::max(a.leafCount(), b.leafCount());
+    for (size_t i=0; i<longest; i++){
+        bool differs = i >= a.leafCount() || i >= b.leafCount() || a.node(0, i) != b.node(0, i);
+        if (!differs) { continue; }
+        if (!ranges.empty() && ranges.back().second == i){
+            ranges.back().second++;
+        }
+        else {
+            ranges.push_back({i, i + 1});
+        }
+    }
+    return ranges;
+}
+
+/**
+ * @test test_identicalAndSingle() checks that identical trees stop at the root, and that a single
+ * changed leaf is found by walking one path
+*/
+void test_identicalAndSingle(){
+
+    MerkleTree merkelTree = MerkleTree(HashMode::Binary);
+    vector<string> inputs = makeInputs(1024);
+    FlatTree a = merkelTree.buildTree(inputs);
+    FlatTree b = merkelTree.buildTree(inputs);
+
+    DiffResult same = MerkleDiff::diff(a, b);
+    assert(same.ranges.empty() && same.differingLeaves == 0);
+    assert(same.nodesVisited == 1 && same.subtreesPruned == 1);
+
+    merkelTree.updateLeaf(b, 700, "tampered");
+    DiffResult one = MerkleDiff::diff(a, b);
+    assert(one.ranges.size() == 1 && one.ranges[0] == std::make_pair(size_t(700), size_t(701)));
+    assert(one.differingLeaves == 1);
+    assert(one.nodesVisited == 1 + 2 * 10);
+
+    cout << "test_identicalAndSingle()...Pass!" << endl;
+}
+
+/**
+ * @test test_matchesBruteForce() checks the pruned descent against a leaf by leaf comparison for
+ * scattered changes, runs of changes, and trees of different leaf counts, in both hash modes
+*/
+void test_matchesBruteForce(){
+
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        MerkleTree merkelTree = MerkleTree(mode);
+        for (size_t n : {1, 2, 5, 33, 100}){
+            for (size_t m : {n, n + 1, n + 7, 2 * n + 3}){
+                vector<string> inputsA = makeInputs(n);
+                vector<string> inputsB = makeInputs(m);
+                for (size_t i=0; i<std::min(n, m); i+=7){
+                    inputsB[i] = "changed";
+                }
+                for (size_t i=n/3; i<n/2; i++){
+                    inputsB[i] = "run " + std::to_string(i);
+                }
+
+                FlatTree a = merkelTree.buildTree(inputsA);
+                FlatTree b = merkelTree.buildTree(inputsB);
+                DiffResult ab = MerkleDiff::diff(a, b);
+                DiffResult ba = MerkleDiff::diff(b, a);
+                assert(ab.ranges == bruteForce(a, b));
+                assert(ba.ranges == ab.ranges);
+            }
+        }
+    }
+
+    cout << "test_matchesBruteForce()...Pass!" << endl;
+}
+
+/**
+ * @test test_parallelDiff() diverges enough leaves for levels to be split across the pool and checks
+ * the result matches the sequential descent
+*/
+void test_parallelDiff(){
+
+    ThreadPool pool(4);
+    MerkleTree merkelTree = MerkleTree(HashMode::Binary);
+    vector<string> inputs = makeInputs(30000);
+    FlatTree a = merkelTree.buildTree(inputs);
+    for (size_t i=0; i<inputs.size(); i+=3){
+        inputs[i] = "diverged " + std::to_string(i);
+    }
+    inputs.resize(29000);
+    FlatTree b = merkelTree.buildTree(inputs);
+
+    DiffResult sequential = MerkleDiff::diff(a, b);
+    DiffResult parallel = MerkleDiff::diff(a, b, &pool);
+    assert(parallel.ranges == sequential.ranges);
+    assert(parallel.ranges == bruteForce(a, b));
+    assert(parallel.nodesVisited == sequential.nodesVisited);
+    assert(parallel.differingLeaves == 29000 / 3 + 1 + 1000);
+
+    cout << "test_parallelDiff()...Pass!" << endl;
+}
+
+
+int main(void){
+    test_identicalAndSingle();
+    test_matchesBruteForce();
+    test_parallelDiff();
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include "lib.hpp"
+
+#include <sstream>
+
+
+/**
+ * @note makeVaryingInputs() returns n leaf strings of varying length
+*/
+vector<string> makeVaryingInputs(size_t n){
+    vector<string> inputs;
+    for (size_t i=0; i<n; i++){
+        inputs.push_back("record " + std::to_string(i) + string(i % 37, 'x'));
+    }
+    return inputs;
+}
+
+/**
+ * @note frame() writes records into one string in the given framing
+*/
+string frame(const vector<string>& records, RecordFormat format){
+    string out;
+    for (const string& record : records){
+        if (format == RecordFormat::Lines){
+            out += record + "\n";
+        }
+        else {
+            for (size_t i=0; i<4; i++){
+                out += char(uint8_t(record.size() >> (8 * i)));
+            }
+            out += record;
+        }
+    }
+    return out;
+}
+
+/**
+ * @test test_boundedQueue() passes numbers through a small queue from several producers to several
+ * consumers and checks that every one arrives exactly once
+*/
+void test_boundedQueue(){
+
+    BoundedQueue<uint64_t> queue(4);
+    assert(queue.capacity() == 4);
+
+    // full and empty without blocking
+    uint64_t item = 1;
+    for (size_t i=0; i<4; i++){
+        assert(queue.tryPush(item));
+    }
+    assert(!queue.tryPush(item));
+    for (size_t i=0; i<4; i++){
+        assert(queue.tryPop(item));
+    }
+    assert(!queue.tryPop(item));
+
+    const uint64_t perProducer = 20000;
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> received{0};
+    vector<std::thread> consumers;
+    for (size_t c=0; c<3; c++){
+        consumers.emplace_back([&]{
+            uint64_t value;
+            while (queue.pop(value)){
+                sum += value;
+                received++;
+            }
+        });
+    }
+    vector<std::thread> producers;
+    for (uint64_t p=0; p<3; p++){
+        producers.emplace_back([&, p]{
+            for (uint64_t i=1; i<=perProducer; i++){
+                queue.push(p * perProducer + i);
+            }
+        });
+    }
+    for (std::thread& producer : producers){
+        producer.join();
+    }
+    queue.close();
+    for (std::thread& consumer : consumers){
+        consumer.join();
+    }
+
+    uint64_t total = 3 * perProducer;
+    assert(received == total);
+    assert(sum == total * (total + 1) / 2);
+
+    cout << "test_boundedQueue()...Pass!" << endl;
+}
+
+/**
+ * @test test_pipelineRoots() checks that the pipeline gives the roots of buildTree() for both
+ * framings and modes, with batches small enough that there are many of them, that they finish out
+ * of order, and that some records span several batch sizes
+*/
+void test_pipelineRoots(){
+
+    vector<string> inputs = makeVaryingInputs(3001);
+    inputs[1500] = string(3000, 'y');
+    inputs[7] = "";
+
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        Digest expected = MerkleTree(mode).buildTree(inputs).root();
+        for (RecordFormat format : {RecordFormat::Lines, RecordFormat::LengthPrefixed}){
+            for (size_t batchBytes : {size_t(1), size_t(512), size_t(4096), size_t(1) << 20}){
+                MerklePipeline pipeline(mode, 3);
+                pipeline.batchBytes = batchBytes;
+                pipeline.queueDepth = 2;
+
+                Digest completed = {};
+                uint64_t completedLeaves = 0;
+                pipeline.onComplete = [&](const Digest& root, uint64_t leafCount){
+                    completed = root;
+                    completedLeaves = leafCount;
+                };
+
+                std::istringstream in(frame(inputs, format));
+                std::future<Digest> root = pipeline.start(in, format);
+                assert(root.get() == expected);
+                pipeline.wait();
+                assert(pipeline.leafCount() == inputs.size());
+                assert(completed == expected && completedLeaves == inputs.size());
+            }
+        }
+
+        // every prefix length up to a few batches, so batches start at unaligned leaves
+        MerkleTree merkelTree(mode);
+        MerklePipeline pipeline(mode, 2);
+        pipeline.batchBytes = 100;
+        for (size_t n=1; n<=70; n++){
+            vector<string> prefix(inputs.begin(), inputs.begin() + n);
+            std::istringstream in(frame(prefix, RecordFormat::Lines));
+            assert(pipeline.start(in, RecordFormat::Lines).get() == merkelTree.buildTree(prefix).root());
+        }
+    }
+
+    cout << "test_pipelineRoots()...Pass!" << endl;
+}
+
+/**
+ * @test test_pipelineFiles() checks a run over a file against RecordFile, and that malformed and
+ * empty streams fail through the future
+*/
+void test_pipelineFiles(){
+
+    string path = "bin/test_MerklePipeline.rec";
+    vector<string> inputs = makeVaryingInputs(10000);
+    vector<std::string_view> views(inputs.begin(), inputs.end());
+    RecordFile::write(views, path, RecordFormat::LengthPrefixed);
+
+    MerklePipeline pipeline(HashMode::Binary);
+    pipeline.batchBytes = 16 << 10;
+    Digest root = pipeline.start(path, RecordFormat::LengthPrefixed).get();
+    RecordFile file(path, RecordFormat::LengthPrefixed);
+    assert(root == MerkleTree(HashMode::Binary).buildTree(file.records()).root());
+
+    auto fails = [&](const string& bytes, RecordFormat format){
+        std::istringstream in(bytes);
+        try {
+            pipeline.start(in, format).get();
+        }
+        catch (const std::runtime_error&){
+            return true;
+        }
+        return false;
+    };
+    assert(fails("", RecordFormat::Lines));
+    assert(fails("", RecordFormat::LengthPrefixed));
+    assert(fails(string("\x05\x00\x00\x00" "abc", 7), RecordFormat::LengthPrefixed));
+    assert(!fails("a", RecordFormat::Lines));
+
+    bool threw = false;
+    try {
+        pipeline.start("bin/does_not_exist.rec", RecordFormat::Lines);
+    }
+    catch (const std::runtime_error&){
+        threw = true;
+    }
+    assert(threw);
+
+    std::remove(path.c_str());
+    cout << "test_pipelineFiles()...Pass!" << endl;
+}
+
+
+int main(void){
+    test_boundedQueue();
+    test_pipelineRoots();
+    test_pipelineFiles();
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include "lib.hpp"
+#include "testUtil.hpp"
+
+
+/**
+ * @test test_auditPaths() proves every leaf of trees of 1 to 40 leaves in both hash modes and checks
+ * the paths verify, including the steps where a node is hashed alone
+*/
+void test_auditPaths(){
+
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        MerkleTree merkelTree = MerkleTree(mode);
+        MerkleProof prover = MerkleProof(mode);
+
+        for (size_t n=1; n<=40; n++){
+            vector<string> inputs = makeInputs(n);
+            FlatTree tree = merkelTree.buildTree(inputs);
+
+            for (size_t i=0; i<n; i++){
+                AuditPath path = prover.prove(tree, i);
+                assert(path.steps.size() == tree.levelCount() - 1);
+                assert(prover.verify(inputs[i], path, tree.root()));
+            }
+        }
+    }
+
+    // 9 leaves: leaf 8 is alone on the first three levels
+    MerkleTree merkelTree = MerkleTree();
+    MerkleProof prover = MerkleProof();
+    FlatTree tree = merkelTree.buildTree(makeInputs(9));
+    AuditPath path = prover.prove(tree, 8);
+    assert(path.steps[0].alone && path.steps[1].alone && path.steps[2].alone);
+    assert(!path.steps[3].alone && path.steps[3].siblingOnLeft);
+
+    cout << "test_auditPaths()...Pass!" << endl;
+}
+
+/**
+ * @test test_rejectBadPaths() checks that tampered leaves, siblings, positions and flags fail
+*/
+void test_rejectBadPaths(){
+
+    MerkleTree merkelTree = MerkleTree(HashMode::Binary);
+    MerkleProof prover = MerkleProof(HashMode::Binary);
+    vector<string> inputs = makeInputs(13);
+    FlatTree tree = merkelTree.buildTree(inputs);
+
+    AuditPath path = prover.prove(tree, 5);
+    assert(prover.verify(inputs[5], path, tree.root()));
+
+    // wrong leaf data
+    assert(!prover.verify(inputs[6], path, tree.root()));
+
+    // tampered sibling
+    AuditPath tampered = path;
+    tampered.steps[1].sibling[0] ^= 1;
+    assert(!prover.verify(inputs[5], tampered, tree.root()));
+
+    // replayed for another position
+    AuditPath moved = path;
+    moved.leafIndex = 4;
+    assert(!prover.verify(inputs[5], moved, tree.root()));
+
+    // flipped flag, truncated and extended paths
+    AuditPath flipped = path;
+    flipped.steps[0].siblingOnLeft = !flipped.steps[0].siblingOnLeft;
+    assert(!prover.verify(inputs[5], flipped, tree.root()));
+    AuditPath shorter = path;
+    shorter.steps.pop_back();
+    assert(!prover.verify(inputs[5], shorter, tree.root()));
+    AuditPath longer = path;
+    longer.steps.push_back(path.steps.back());
+    assert(!prover.verify(inputs[5], longer, tree.root()));
+
+    // hash mode mismatch
+    MerkleProof hexProver = MerkleProof(HashMode::Hex);
+    assert(!hexProver.verify(inputs[5], path, tree.root()));
+
+    cout << "test_rejectBadPaths()...Pass!" << endl;
+}
+
+/**
+ * @test test_multiProofs() proves sets of leaves together and checks the proof verifies, ships each
+ * sibling once and stays no larger than the separate paths
+*/
+void test_multiProofs(){
+
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        MerkleTree merkelTree = MerkleTree(mode);
+        MerkleProof prover = MerkleProof(mode);
+
+        for (size_t n : {1, 2, 5, 9, 16, 33}){
+            vector<string> inputs = makeInputs(n);
+            FlatTree tree = merkelTree.buildTree(inputs);
+
+            vector<vector<size_t>> sets = {{0}, {n - 1}, {0, n - 1}, {n / 2, 0, n / 2}};
+            vector<size_t> all;
+            for (size_t i=0; i<n; i++){ all.push_back(i); }
+            sets.push_back(all);
+
+            for (vector<size_t>& set : sets){
+                MultiProof proof = prover.proveMany(tree, set);
+
+                vector<Digest> leaves;
+                size_t separateSiblings = 0;
+                for (size_t i : proof.leafIndices){
+                    leaves.push_back(prover.leafHash(inputs[i]));
+                    for (const ProofStep& step : prover.prove(tree, i).steps){
+                        separateSiblings += step.alone ? 0 : 1;
+                    }
+                }
+                assert(proof.siblings.size() <= separateSiblings);
+                assert(prover.verifyMany(leaves, proof, tree.root()));
+
+                // a tampered leaf fails
+                leaves[0][0] ^= 1;
+                assert(!prover.verifyMany(leaves, proof, tree.root()));
+            }
+
+            // proving every leaf needs no siblings at all
+            assert(prover.proveMany(tree, all).siblings.empty());
+        }
+    }
+
+    // adjacent leaves share their whole path above the first level
+    MerkleTree merkelTree = MerkleTree();
+    MerkleProof prover = MerkleProof();
+    FlatTree tree = merkelTree.buildTree(makeInputs(16));
+    assert(prover.proveMany(tree, {4, 5}).siblings.size() == 3);
+
+    // extra siblings are rejected
+    MultiProof proof = prover.proveMany(tree, {4, 5});
+    vector<Digest> leaves = {prover.leafHash("record 4"), prover.leafHash("record 5")};
+    assert(prover.verifyMany(leaves, proof, tree.root()));
+    proof.siblings.push_back(proof.siblings[0]);
+    assert(!prover.verifyMany(leaves, proof, tree.root()));
+
+    cout << "test_multiProofs()...Pass!" << endl;
+}
+
+/**
+ * @test test_verifyBatch() verifies thousands of proofs on a thread pool with one bad proof mixed in
+*/
+void test_verifyBatch(){
+
+    MerkleTree merkelTree = MerkleTree(HashMode::Binary);
+    MerkleProof prover = MerkleProof(HashMode::Binary);
+    vector<string> inputs = makeInputs(3000);
+    FlatTree tree = merkelTree.buildTree(inputs);
+
+    vector<Digest> leaves;
+    vector<AuditPath> paths;
+    for (size_t i=0; i<inputs.size(); i++){
+        leaves.push_back(tree.node(0, i));
+        paths.push_back(prover.prove(tree, i));
+    }
+    leaves[1234][5] ^= 0x80;
+
+    ThreadPool pool(4);
+    vector<uint8_t> results = prover.verifyBatch(leaves, paths, tree.root(), pool);
+    for (size_t i=0; i<results.size(); i++){
+        assert(results[i] == (i == 1234 ? 0 : 1));
+    }
+
+    cout << "test_verifyBatch()...Pass!" << endl;
+}
+
+
+int main(void){
+    test_auditPaths();
+    test_rejectBadPaths();
+    test_multiProofs();
+    test_verifyBatch();
+    return 0;
+}
@@ -0,0 +1,298 @@
+#include "lib.hpp"
+#include "testUtil.hpp"
+
+
+/**
+ * @note rejects() returns true if decoding bytes as T throws
+*/
+template<class T>
+bool rejects(const vector<uint8_t>& bytes){
+    T view;
+    try {
+        ProofCodec::decode(bytes, view);
+    } catch (const std::runtime_error&){
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @note bodyStart() returns the offset of a message's body, after its header
+*/
+size_t bodyStart(const vector<uint8_t>& bytes){
+    uint64_t length;
+    return 2 + ProofCodec::getVarint(bytes.data() + 2, bytes.size() - 2, length);
+}
+
+/**
+ * @test test_varints() round trips values around every 7 bit boundary and rejects truncated, too
+ * long and non-canonical encodings
+*/
+void test_varints(){
+
+    uint8_t buffer[10];
+    for (size_t bits=0; bits<=64; bits++){
+        for (int64_t delta : {-1, 0, 1}){
+            uint64_t value = (bits == 64 ? 0 : (uint64_t(1) << bits)) + delta;
+            size_t n = ProofCodec::putVarint(value, buffer);
+            assert(n == ProofCodec::varintSize(value));
+
+            uint64_t decoded;
+            assert(ProofCodec::getVarint(buffer, n, decoded) == n && decoded == value);
+            assert(ProofCodec::getVarint(buffer, n - 1, decoded) == 0);
+        }
+    }
+
+    uint64_t value;
+    const uint8_t padded[] = {0x81, 0x00};
+    assert(ProofCodec::getVarint(padded, 2, value) == 0);
+    const uint8_t zero[] = {0x00};
+    assert(ProofCodec::getVarint(zero, 1, value) == 1 && value == 0);
+    const uint8_t overflow[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x02};
+    assert(ProofCodec::getVarint(overflow, 10, value) == 0);
+    const uint8_t tooLong[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01};
+    assert(ProofCodec::getVarint(tooLong, 11, value) == 0);
+
+    cout << "test_varints()...Pass!" << endl;
+}
+
+/**
+ * @test test_auditPaths() encodes every path of trees of 1 to 40 leaves in both hash modes, checks
+ * the views verify in place and convert back to the original path
+*/
+void test_auditPaths(){
+
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        MerkleTree merkelTree(mode);
+        MerkleProof prover(mode);
+
+        for (size_t n=1; n<=40; n++){
+            FlatTree tree = merkelTree.buildTree(makeInputs(n));
+
+            // all paths of the tree back to back in one buffer
+            vector<uint8_t> bytes;
+            for (size_t i=0; i<n; i++){
+                ProofCodec::encode(prover.prove(tree, i), bytes);
+            }
+
+            std::span<const uint8_t> rest(bytes);
+            for (size_t i=0; i<n; i++){
+                assert(ProofCodec::peekKind(rest) == WireKind::AuditPath);
+                AuditPathView view;
+                rest = rest.subspan(ProofCodec::decode(rest, view));
+                assert(view.leafIndex == i && view.leafCount == n);
+                assert(view.siblings.empty() || (const uint8_t*)view.siblings.data() > bytes.data());
+
+                Digest root;
+                assert(prover.computeRoot(tree.node(0, i), i, n, view.siblings, root));
+                assert(root == tree.root());
+
+                AuditPath path = ProofCodec::toAuditPath(view);
+                AuditPath expected = prover.prove(tree, i);
+                assert(path.steps.size() == expected.steps.size());
+                for (size_t s=0; s<path.steps.size(); s++){
+                    assert(path.steps[s].alone == expected.steps[s].alone);
+                    assert(path.steps[s].siblingOnLeft == expected.steps[s].siblingOnLeft);
+                    assert(path.steps[s].alone || path.steps[s].sibling == expected.steps[s].sibling);
+                }
+                assert(prover.verify(tree.node(0, i), path, tree.root()));
+            }
+            assert(rest.empty());
+        }
+    }
+
+    // a path of a million leaf tree is about half its hex form
+    AuditPath path;
+    path.leafIndex = 123456;
+    path.leafCount = 1000000;
+    for (size_t i=path.leafIndex, size=path.leafCount; size>1; i/=2, size=(size + 1)/2){
+        path.steps.push_back({Digest{}, i % 2 == 1, i % 2 == 0 && i + 1 == size});
+    }
+    size_t siblings = std::count_if(path.steps.begin(), path.steps.end(), [](const ProofStep& step){ return !step.alone; });
+    vector<uint8_t> bytes;
+    ProofCodec::encode(path, bytes);
+    assert(bytes.size() == 2 + 2 + 3 + 3 + 1 + 32 * siblings);
+    assert(bytes.size() < 64 * path.steps.size());
+
+    cout << "test_auditPaths()...Pass!" << endl;
+}
+
+/**
+ * @test test_multiProofs() round trips multiproofs of several index sets and checks the decoded
+ * indices and siblings verify
+*/
+void test_multiProofs(){
+
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        MerkleTree merkelTree(mode);
+        MerkleProof prover(mode);
+        FlatTree tree = merkelTree.buildTree(makeInputs(300));
+
+        vector<vector<size_t>> sets = {{0}, {299}, {0, 299}, {5, 6, 7, 8}, {1, 64, 129, 200, 298}};
+        vector<size_t> all(300);
+        for (size_t i=0; i<300; i++){
+            all[i] = i;
+        }
+        sets.push_back(all);
+
+        for (const vector<size_t>& set : sets){
+            MultiProof proof = prover.proveMany(tree, set);
+            vector<uint8_t> bytes;
+            ProofCodec::encode(proof, bytes);
+
+            MultiProofView view;
+            assert(ProofCodec::decode(bytes, view) == bytes.size());
+            assert(view.leafCount == 300 && view.leafIndices == set);
+            assert(view.siblings.size() == proof.siblings.size());
+
+            vector<Digest> leaves;
+            for (size_t i : set){
+                leaves.push_back(tree.node(0, i));
+            }
+            Digest root;
+            assert(prover.computeRoot(leaves, 300, view.leafIndices, view.siblings, root));
+            assert(root == tree.root());
+            assert(prover.verifyMany(leaves, ProofCodec::toMultiProof(view), tree.root()));
+        }
+    }
+
+    cout << "test_multiProofs()...Pass!" << endl;
+}
+
+/**
+ * @test test_subtrees() encodes the subtree under every node of trees with odd levels, checks the
+ * decoded levels match the tree and rehash, and that a changed node is caught
+*/
+void test_subtrees(){
+
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        MerkleTree merkelTree(mode);
+        for (size_t n : {1, 2, 3, 7, 13, 33}){
+            FlatTree tree = merkelTree.buildTree(makeInputs(n));
+
+            for (size_t level=0; level<tree.levelCount(); level++){
+                for (size_t index=0; index<tree.levelSize(level); index++){
+                    vector<uint8_t> bytes;
+                    ProofCodec::encodeSubtree(tree, level, index, bytes);
+
+                    SubtreeView view;
+                    assert(ProofCodec::decode(bytes, view) == bytes.size());
+                    assert(view.mode == mode && view.leafCount == n);
+                    assert(view.level == level && view.index == index);
+                    assert(view.levels[level].size() == 1 && view.levels[level][0] == tree.node(level, index));
+                    for (size_t l=0; l<=level; l++){
+                        size_t first = index << (level - l);
+                        for (size_t k=0; k<view.levels[l].size(); k++){
+                            assert(view.levels[l][k] == tree.node(l, first + k));
+                        }
+                    }
+                    assert(ProofCodec::checkSubtree(view));
+
+                    // flip a bit in the first leaf
+                    if (level > 0){
+                        size_t header = bytes.size() - 32 * (view.levels[0].size());
+                        for (size_t l=1; l<=level; l++){
+                            header -= 32 * view.levels[l].size();
+                        }
+                        bytes[header] ^= 1;
+                        SubtreeView changed;
+                        ProofCodec::decode(bytes, changed);
+                        assert(!ProofCodec::checkSubtree(changed));
+                    }
+                }
+            }
+        }
+    }
+
+    cout << "test_subtrees()...Pass!" << endl;
+}
+
+/**
+ * @test test_malformed() checks the decoders reject truncated messages, unknown versions and kinds,
+ * wrong counts and trailing bytes
+*/
+void test_malformed(){
+
+    MerkleTree merkelTree(HashMode::Binary);
+    MerkleProof prover(HashMode::Binary);
+    FlatTree tree = merkelTree.buildTree(makeInputs(9));
+
+    vector<uint8_t> path;
+    ProofCodec::encode(prover.prove(tree, 8), path);
+    assert(!rejects<AuditPathView>(path));
+
+    // every truncation
+    for (size_t len=0; len<path.size(); len++){
+        assert(rejects<AuditPathView>(vector<uint8_t>(path.begin(), path.begin() + len)));
+    }
+
+    // version and kind
+    vector<uint8_t> bytes = path;
+    bytes[0] = 2;
+    assert(rejects<AuditPathView>(bytes));
+    assert(rejects<MultiProofView>(path) && rejects<SubtreeView>(path));
+
+    // leaf 8 of 9 has one sibling, at the top, claim it is leaf 7
+    bytes = path;
+    assert(bytes[3] == 8);
+    bytes[3] = 7;
+    assert(rejects<AuditPathView>(bytes));
+
+    // leaf index past the tree
+    bytes = path;
+    bytes[3] = 9;
+    assert(rejects<AuditPathView>(bytes));
+
+    // a byte after the body is the next message, a byte inside it is not
+    bytes = path;
+    bytes.push_back(0);
+    AuditPathView view;
+    assert(ProofCodec::decode(bytes, view) == path.size());
+    bytes = path;
+    bytes.push_back(0);
+    bytes[2]++;
+    assert(rejects<AuditPathView>(bytes));
+
+    // non-canonical body length
+    bytes = path;
+    bytes[2] |= 0x80;
+    bytes.insert(bytes.begin() + 3, 0x00);
+    assert(rejects<AuditPathView>(bytes));
+
+    // multiproof indices must increase
+    vector<uint8_t> multi;
+    ProofCodec::encode(prover.proveMany(tree, {2, 5}), multi);
+    assert(!rejects<MultiProofView>(multi));
+    bytes = multi;
+    size_t body = bodyStart(bytes);
+    assert(bytes[body + 2] == 2 && bytes[body + 3] == 3);
+    bytes[body + 3] = 0;
+    assert(rejects<MultiProofView>(bytes));
+    bytes[body + 3] = 7;
+    assert(rejects<MultiProofView>(bytes));
+
+    // subtree outside the tree
+    vector<uint8_t> subtree;
+    ProofCodec::encodeSubtree(tree, 1, 4, subtree);
+    assert(!rejects<SubtreeView>(subtree));
+    bytes = subtree;
+    body = bodyStart(bytes);
+    assert(bytes[body + 2] == 1 && bytes[body + 3] == 4);
+    bytes[body + 3] = 5;
+    assert(rejects<SubtreeView>(bytes));
+    bytes[body + 3] = 4;
+    bytes[body + 2] = 5;
+    assert(rejects<SubtreeView>(bytes));
+
+    cout << "test_malformed()...Pass!" << endl;
+}
+
+
+int main(void){
+    test_varints();
+    test_auditPaths();
+    test_multiProofs();
+    test_subtrees();
+    test_malformed();
+    return 0;
+}
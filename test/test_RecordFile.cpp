@@ -0,0 +1,124 @@
+#include "lib.hpp"
+#include "testUtil.hpp"
+
+#include <list>
+
+
+/**
+ * @note viewsOf() views strings in place
+*/
+vector<std::string_view> viewsOf(const vector<string>& inputs){
+    return vector<std::string_view>(inputs.begin(), inputs.end());
+}
+
+/**
+ * @test test_viewInputs() checks that the string_view, iterator and BatchMessage inputs give the
+ * same leaves, hex digests and roots as the string inputs, across several leaf blocks
+*/
+void test_viewInputs(){
+
+    ThreadPool pool(3);
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        MerkleTree merkelTree = MerkleTree(mode);
+        for (size_t n : {1, 2, 255, 256, 257, 1000}){
+            vector<string> inputs = makeInputs(n);
+            vector<std::string_view> views = viewsOf(inputs);
+            FlatTree expected = merkelTree.buildTree(inputs);
+
+            assert(merkelTree.buildTree(std::span<const std::string_view>(views)).root() == expected.root());
+            assert(merkelTree.buildTree(std::span<const std::string_view>(views), pool, 64).root() == expected.root());
+
+            // a range that is not contiguous
+            std::list<string> linked(inputs.begin(), inputs.end());
+            assert(merkelTree.buildTree(linked.begin(), linked.end()).root() == expected.root());
+
+            vector<BatchMessage> msgs;
+            for (std::string_view v : views){
+                msgs.push_back({reinterpret_cast<const uint8_t*>(v.data()), v.size()});
+            }
+            assert(merkelTree.buildTree(msgs.begin(), msgs.end()).root() == expected.root());
+
+            // caller provided outputs
+            vector<Digest> leaves(n);
+            merkelTree.hashLeaves(views, leaves.data());
+            assert(leaves == merkelTree.hashLeaves(inputs));
+
+            string hex(64 * n, '\0');
+            merkelTree.hashStrings(views, hex.data());
+            vector<string> hashes = merkelTree.hashStrings(inputs);
+            for (size_t i=0; i<n; i++){
+                assert(hex.compare(64 * i, 64, hashes[i]) == 0);
+            }
+
+            TreeNode* root = merkelTree.assembleTree(std::span<const std::string_view>(views));
+            assert(root->digest == expected.root());
+            merkelTree.freeTree(&root);
+        }
+    }
+
+    cout << "test_viewInputs()...Pass!" << endl;
+}
+
+/**
+ * @test test_recordFiles() writes records in both framings and checks that the mapped records
+ * match and build the same tree, including empty records and a missing final newline
+*/
+void test_recordFiles(){
+
+    string path = "bin/test_RecordFile.rec";
+    vector<string> inputs = makeInputs(1000);
+    inputs[10] = "";
+    inputs[500] = string(5000, 'x');
+    vector<std::string_view> views = viewsOf(inputs);
+    Digest expected = MerkleTree(HashMode::Binary).buildTree(inputs).root();
+
+    for (RecordFormat format : {RecordFormat::Lines, RecordFormat::LengthPrefixed}){
+        RecordFile::write(views, path, format);
+        RecordFile file(path, format);
+        assert(file.size() == inputs.size());
+        for (size_t i=0; i<inputs.size(); i++){
+            assert(file[i] == inputs[i]);
+        }
+        assert(MerkleTree(HashMode::Binary).buildTree(file.records()).root() == expected);
+
+        RecordFile moved(std::move(file));
+        assert(moved.size() == inputs.size() && moved[999] == inputs[999]);
+    }
+
+    // the last line may end without a newline
+    {
+        ofstream out(path, ios::binary | ios::trunc);
+        out << "a\nb\n\nc";
+    }
+    RecordFile lines(path, RecordFormat::Lines);
+    assert(lines.size() == 4 && lines[2].empty() && lines[3] == "c");
+
+    // empty files hold no records
+    ofstream(path, ios::binary | ios::trunc).close();
+    assert(RecordFile(path, RecordFormat::Lines).size() == 0);
+    assert(RecordFile(path, RecordFormat::LengthPrefixed).size() == 0);
+
+    // a length past the end of the file is rejected
+    {
+        ofstream out(path, ios::binary | ios::trunc);
+        out.write("\x05\x00\x00\x00" "abc", 7);
+    }
+    bool threw = false;
+    try {
+        RecordFile truncated(path, RecordFormat::LengthPrefixed);
+    }
+    catch (const std::runtime_error&){
+        threw = true;
+    }
+    assert(threw);
+
+    std::remove(path.c_str());
+    cout << "test_recordFiles()...Pass!" << endl;
+}
+
+
+int main(void){
+    test_viewInputs();
+    test_recordFiles();
+    return 0;
+}
@@ -153,6 +153,280 @@ void test_hashEmptyString() {
     }
 }
 
+/**
+ * @test test_byteHashMatchesBitHash() ensures the byte-oriented computeHash() agrees with the
+ * vector<bool> path across the padding boundaries (55, 56, 63, 64 bytes and multi-block messages)
+*/
+void test_byteHashMatchesBitHash() {
+
+    size_t lengths[] = {0, 1, 3, 55, 56, 63, 64, 65, 119, 120, 128, 1000};
+    for (size_t len : lengths) {
+
+        // deterministic message of the given length
+        string msg;
+        for (size_t i = 0; i < len; i++) {
+            msg.push_back(char('a' + (i % 26)));
+        }
+
+        // fresh instances so neither hash sees the other's state
+        SHA256 bitSha, byteSha, spanSha;
+        string bitHash = bitSha.computeHash(bitSha.stringToBinary(msg));
+        string byteHash = byteSha.computeHash(reinterpret_cast<const uint8_t*>(msg.data()), msg.size());
+        string spanHash = spanSha.computeHash(std::as_bytes(std::span<const char>(msg.data(), msg.size())));
+
+        assert(bitHash == byteHash);
+        assert(byteHash == spanHash);
+    }
+
+    // known answer for "abc"
+    SHA256 sha256;
+    const uint8_t abc[] = {'a', 'b', 'c'};
+    assert(sha256.computeHash(abc, 3) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+    std::cout << "test_byteHashMatchesBitHash()...Pass!" << std::endl;
+}
+
+/**
+ * @test test_streamingHash() ensures that streaming a message through update() in arbitrary pieces
+ * gives the same digest as hashing it in one call, and that a context can be reused.
+*/
+void test_streamingHash() {
+
+    // message spanning several blocks
+    vector<uint8_t> msg(1000);
+    for (size_t i = 0; i < msg.size(); i++) {
+        msg[i] = uint8_t(i * 31 + 7);
+    }
+
+    SHA256 reference;
+    string expected = reference.computeHash(msg.data(), msg.size());
+
+    // feed the message in pieces of varying size
+    size_t pieceSizes[] = {1, 7, 63, 64, 65, 200};
+    for (size_t piece : pieceSizes) {
+        SHA256 sha256;
+        uint8_t digest[32];
+        sha256.init();
+        for (size_t offset = 0; offset < msg.size(); offset += piece) {
+            sha256.update(msg.data() + offset, std::min(piece, msg.size() - offset));
+        }
+        sha256.final(digest);
+        assert(sha256.collectDigest() == expected);
+    }
+
+    // hashing twice with the same instance must not leak state between messages
+    SHA256 sha256;
+    const uint8_t abc[] = {'a', 'b', 'c'};
+    string first = sha256.computeHash(abc, 3);
+    string second = sha256.computeHash(abc, 3);
+    assert(first == second);
+    assert(sha256.computeHash(sha256.stringToBinary("abc")) == first);
+
+    std::cout << "test_streamingHash()...Pass!" << std::endl;
+}
+
+/**
+ * @test test_hashFile() writes a file larger than a single block and checks hashFile() against
+ * hashing the same bytes in memory
+*/
+void test_hashFile() {
+
+    string path = "/tmp/test_SHA256_hashFile.bin";
+    vector<uint8_t> contents(3 * 1024 * 1024 + 17);
+    for (size_t i = 0; i < contents.size(); i++) {
+        contents[i] = uint8_t((i * 2654435761u) >> 13);
+    }
+
+    ofstream out(path, ios::binary);
+    out.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+    out.close();
+
+    SHA256 sha256;
+    assert(sha256.hashFile(path) == sha256.computeHash(contents.data(), contents.size()));
+
+    // empty file
+    ofstream(path, ios::binary).close();
+    assert(sha256.hashFile(path) == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+
+    std::remove(path.c_str());
+
+    std::cout << "test_hashFile()...Pass!" << std::endl;
+}
+
+/**
+ * @test test_backends() runs the known-answer vectors against every compression backend this CPU
+ * supports, and checks each backend against the scalar one on multi-block messages
+*/
+void test_backends() {
+
+    // known answers: "", "abc", the 448-bit NIST vector and one million 'a'
+    string millionA(1000000, 'a');
+    vector<std::pair<string, string>> vectors = {
+        {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+        {"abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+        {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+        {millionA, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"}
+    };
+
+    // random-ish multi-block message for cross-checking the state update
+    vector<uint8_t> msg(4096 + 37);
+    for (size_t i = 0; i < msg.size(); i++) {
+        msg[i] = uint8_t((i * 2654435761u) >> 11);
+    }
+    uint32_t reference[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    SHA256Compress::compressScalar(reference, msg.data(), msg.size() / 64);
+
+    string initial = SHA256Compress::active().name;
+    for (const CompressBackend& backend : SHA256Compress::available()) {
+        bool selected = SHA256Compress::select(backend.name);
+        assert(selected);
+
+        SHA256 sha256;
+        for (auto& [input, expected] : vectors) {
+            assert(sha256.computeHash(reinterpret_cast<const uint8_t*>(input.data()), input.size()) == expected);
+        }
+
+        uint32_t state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+        backend.compress(state, msg.data(), msg.size() / 64);
+        assert(std::equal(state, state + 8, reference));
+
+        std::cout << "  backend " << backend.name << "...Pass!" << std::endl;
+    }
+
+    // unknown backends are rejected and leave the selection alone
+    bool unknown = SHA256Compress::select("no-such-backend");
+    assert(!unknown);
+    bool restored = SHA256Compress::select(initial);
+    assert(restored);
+
+    std::cout << "test_backends()...Pass!" << std::endl;
+}
+
+/**
+ * @test test_batchHash() hashes a batch of messages of uneven lengths with every batch backend and
+ * compares each digest against hashing the message on its own. The batch size is not a multiple
+ * of the lane count, so lanes go idle at the end.
+*/
+void test_batchHash() {
+
+    // messages 0..300 bytes long, crossing every padding boundary
+    vector<vector<uint8_t>> storage;
+    for (size_t len = 0; len <= 300; len += 7) {
+        vector<uint8_t> msg(len);
+        for (size_t i = 0; i < len; i++) {
+            msg[i] = uint8_t(len * 131 + i);
+        }
+        storage.push_back(msg);
+    }
+    storage.push_back(vector<uint8_t>(55, 'x'));
+    storage.push_back(vector<uint8_t>(56, 'y'));
+    storage.push_back(vector<uint8_t>(64, 'z'));
+    storage.push_back(vector<uint8_t>(5000, 'w'));
+
+    vector<BatchMessage> msgs;
+    for (auto& msg : storage) {
+        msgs.push_back({msg.data(), msg.size()});
+    }
+
+    string initial = SHA256Batch::active().name;
+    for (const BatchBackend& backend : SHA256Batch::available()) {
+        bool selected = SHA256Batch::select(backend.name);
+        assert(selected);
+
+        vector<uint8_t> digests(32 * msgs.size());
+        SHA256Batch::hash(msgs.data(), msgs.size(), digests.data());
+
+        SHA256 sha256;
+        for (size_t i = 0; i < msgs.size(); i++) {
+            assert(SHA256::toHex(&digests[32 * i], 32) == sha256.computeHash(msgs[i].data, msgs[i].len));
+        }
+
+        // empty batch writes nothing
+        SHA256Batch::hash(msgs.data(), 0, digests.data());
+
+        std::cout << "  batch backend " << backend.name << "...Pass!" << std::endl;
+    }
+    bool restored = SHA256Batch::select(initial);
+    assert(restored);
+
+    std::cout << "test_batchHash()...Pass!" << std::endl;
+}
+
+/**
+ * @test test_constexprHash() checks the compile time SHA-256 with static_assert known answers from
+ * FIPS 180-2, then against the runtime hash for every length across the padding boundaries
+*/
+void test_constexprHash() {
+
+    static_assert(SHA256Const::hash("") == SHA256Const::fromHex("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"));
+    static_assert(SHA256Const::hash("abc") == SHA256Const::fromHex("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"));
+    static_assert(SHA256Const::hash("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+                  SHA256Const::fromHex("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"));
+
+    // a parent of the leaves "1" and "2" in both modes
+    constexpr Digest one = SHA256Const::hash("1");
+    constexpr Digest two = SHA256Const::hash("2");
+    static_assert(SHA256Const::nodeHash(one, &two, true) != SHA256Const::nodeHash(one, &two, false));
+
+    SHA256 sha256;
+    vector<uint8_t> msg(200);
+    for (size_t len = 0; len < msg.size(); len++) {
+        msg[len] = uint8_t(len * 37 + 11);
+        Digest digest = SHA256Const::hash(msg.data(), len);
+        assert(SHA256::toHex(digest.data(), 32) == sha256.computeHash(msg.data(), len));
+    }
+
+    MerkleTree merkelTree;
+    assert(SHA256Const::nodeHash(one, &two, true) == merkelTree.buildTree(vector<string>{"1", "2"}).root());
+
+    std::cout << "test_constexprHash()...Pass!" << std::endl;
+}
+
+/**
+ * @test test_pairHash() hashes parents with the fixed length pair kernel of every compression
+ * backend and compares them against hashing the catted children with SHA256, in both hash modes
+*/
+void test_pairHash() {
+
+    static_assert(SHA256Pair::paddingSchedule(64)[15] == SHA256::k[15] + 512);
+
+    vector<Digest> nodes(64);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        for (size_t j = 0; j < 32; j++) {
+            nodes[i][j] = uint8_t((i * 2654435761u + j * 97) >> 7);
+        }
+    }
+
+    string initial = SHA256Compress::active().name;
+    for (const CompressBackend& backend : SHA256Compress::available()) {
+        bool selected = SHA256Compress::select(backend.name);
+        assert(selected);
+
+        for (HashMode mode : {HashMode::Hex, HashMode::Binary}) {
+            vector<Digest> parents(nodes.size() / 2);
+            SHA256Pair::hashPairs(nodes.data(), parents.size(), parents.data(), mode);
+
+            for (size_t i = 0; i < parents.size(); i++) {
+                Digest expected = SHA256Const::nodeHash(nodes[2*i], &nodes[2*i + 1], mode == HashMode::Hex);
+                assert(parents[i] == expected);
+                assert(SHA256Pair::hashPair(nodes[2*i], nodes[2*i + 1], mode) == expected);
+            }
+        }
+
+        std::cout << "  pair backend " << backend.name << "...Pass!" << std::endl;
+    }
+    bool restored = SHA256Compress::select(initial);
+    assert(restored);
+
+    // the portable kernel against the generic path
+    SHA256 sha256;
+    Digest parent;
+    SHA256Pair::pairScalar<HashMode::Binary>(nodes[0].data(), nodes[1].data(), parent.data());
+    assert(SHA256::toHex(parent.data(), 32) == sha256.computeHash(nodes[0].data(), 64));
+
+    std::cout << "test_pairHash()...Pass!" << std::endl;
+}
+
 
 // test driver
 int main() {
@@ -162,6 +436,13 @@ int main() {
     test_padding_56byte_message();
     test_convertToWords();
     test_hashEmptyString();
+    test_byteHashMatchesBitHash();
+    test_streamingHash();
+    test_hashFile();
+    test_backends();
+    test_batchHash();
+    test_constexprHash();
+    test_pairHash();
 
 
     return 0;
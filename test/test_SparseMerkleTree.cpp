@@ -0,0 +1,185 @@
+#include "lib.hpp"
+
+#include <map>
+
+
+/**
+ * @note makeKey() derives a pseudo random 256-bit key
+*/
+Digest makeKey(size_t i){
+    return SparseMerkleTree::leafHash("key " + std::to_string(i));
+}
+
+/**
+ * @note referenceRoot() computes the root of a sorted key range recursively, splitting on one key
+ * bit per level, without the stored nodes
+*/
+Digest referenceRoot(const vector<std::pair<Digest, Digest>>& leaves, size_t begin, size_t end, size_t height, HashMode mode){
+    if (begin == end){
+        return ZeroHashes::at(mode, height);
+    }
+    if (height == 0){
+        return leaves[begin].second;
+    }
+
+    // keys with bit height - 1 clear come first
+    size_t bit = height - 1;
+    size_t split = begin;
+    while (split < end && ((leaves[split].first[31 - bit / 8] >> (bit % 8)) & 1) == 0){
+        split++;
+    }
+    Digest left = referenceRoot(leaves, begin, split, height - 1, mode);
+    Digest right = referenceRoot(leaves, split, end, height - 1, mode);
+    return SHA256Const::nodeHash(left, &right, mode == HashMode::Hex);
+}
+
+Digest referenceRoot(std::map<Digest, string> entries, HashMode mode){
+    vector<std::pair<Digest, Digest>> leaves;
+    for (auto& [key, value] : entries){
+        leaves.push_back({key, SparseMerkleTree::leafHash(value)});
+    }
+    return referenceRoot(leaves, 0, leaves.size(), SparseMerkleTree::depth, mode);
+}
+
+/**
+ * @test test_updates() checks inserts, updates and deletes against the recursive reference root,
+ * including keys that share all but their last bit
+*/
+void test_updates(){
+
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        SparseMerkleTree tree = SparseMerkleTree(mode);
+        assert(tree.root() == ZeroHashes::at(mode, 256));
+
+        std::map<Digest, string> entries;
+        for (size_t i=0; i<40; i++){
+            Digest key = makeKey(i);
+            entries[key] = "value " + std::to_string(i);
+            tree.insert(key, entries[key]);
+        }
+
+        // neighbours of key 0, differing in the lowest bit only
+        Digest neighbour = makeKey(0);
+        neighbour[31] ^= 1;
+        entries[neighbour] = "neighbour";
+        tree.insert(neighbour, "neighbour");
+        assert(tree.size() == 41);
+        assert(tree.root() == referenceRoot(entries, mode));
+
+        // update and delete
+        entries[makeKey(7)] = "changed";
+        tree.insert(makeKey(7), "changed");
+        entries.erase(makeKey(3));
+        tree.erase(makeKey(3));
+        tree.erase(makeKey(1000));
+        assert(tree.size() == 40 && !tree.contains(makeKey(3)) && tree.contains(makeKey(7)));
+        assert(tree.root() == referenceRoot(entries, mode));
+
+        // memory is bounded by the populated paths
+        assert(tree.nodeCount() <= tree.size() * (SparseMerkleTree::depth + 1));
+
+        // deleting every key returns to the empty tree
+        for (auto& [key, value] : entries){
+            tree.erase(key);
+        }
+        assert(tree.size() == 0 && tree.nodeCount() == 0);
+        assert(tree.root() == ZeroHashes::at(mode, 256));
+    }
+
+    cout << "test_updates()...Pass!" << endl;
+}
+
+/**
+ * @test test_batchUpdates() checks that batch updates, in any order and on a pool, give the same
+ * root as single updates
+*/
+void test_batchUpdates(){
+
+    ThreadPool pool(4);
+    SparseMerkleTree single = SparseMerkleTree(HashMode::Binary);
+    vector<std::pair<Digest, string>> entries;
+    for (size_t i=0; i<2000; i++){
+        entries.push_back({makeKey(i), "v" + std::to_string(i)});
+        single.insert(entries.back().first, entries.back().second);
+    }
+
+    SparseMerkleTree batch = SparseMerkleTree(HashMode::Binary);
+    batch.insertMany(entries);
+    assert(batch.root() == single.root());
+
+    vector<std::pair<Digest, string>> reversed(entries.rbegin(), entries.rend());
+    SparseMerkleTree parallel = SparseMerkleTree(HashMode::Binary);
+    parallel.insertMany(reversed, &pool);
+    assert(parallel.root() == single.root() && parallel.nodeCount() == single.nodeCount());
+
+    // a repeated key keeps its last value
+    batch.insertMany({{makeKey(5), "first"}, {makeKey(5), "last"}});
+    single.insert(makeKey(5), "last");
+    assert(batch.root() == single.root());
+
+    // an empty batch changes nothing
+    batch.insertMany({});
+    assert(batch.root() == single.root());
+
+    vector<Digest> doomed;
+    for (size_t i=0; i<2000; i+=2){
+        doomed.push_back(makeKey(i));
+        single.erase(makeKey(i));
+    }
+    batch.eraseMany(doomed, &pool);
+    assert(batch.size() == 1000 && batch.root() == single.root());
+
+    cout << "test_batchUpdates()...Pass!" << endl;
+}
+
+/**
+ * @test test_proofs() checks membership and non-membership proofs, and that tampered proofs fail
+*/
+void test_proofs(){
+
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        SparseMerkleTree tree = SparseMerkleTree(mode);
+        for (size_t i=0; i<100; i++){
+            tree.insert(makeKey(i), "value " + std::to_string(i));
+        }
+        Digest root = tree.root();
+
+        SparseProof member = tree.prove(makeKey(42));
+        assert(SparseMerkleTree::verifyMember(member, "value 42", root, mode));
+        assert(!SparseMerkleTree::verifyMember(member, "value 43", root, mode));
+        assert(!SparseMerkleTree::verifyNonMember(member, root, mode));
+
+        // about log2(100) siblings are not empty
+        assert(member.siblings.size() < 20);
+
+        SparseProof absent = tree.prove(makeKey(500));
+        assert(SparseMerkleTree::verifyNonMember(absent, root, mode));
+        assert(!SparseMerkleTree::verifyMember(absent, "anything", root, mode));
+
+        // tampering with a sibling, the bitmap or the key breaks the proof
+        SparseProof tampered = member;
+        tampered.siblings[0][0] ^= 1;
+        assert(!SparseMerkleTree::verifyMember(tampered, "value 42", root, mode));
+        tampered = member;
+        tampered.siblings.pop_back();
+        assert(!SparseMerkleTree::verifyMember(tampered, "value 42", root, mode));
+        tampered = member;
+        tampered.key[0] ^= 0x80;
+        assert(!SparseMerkleTree::verifyMember(tampered, "value 42", root, mode));
+
+        // a proof is bound to the root it was made for
+        tree.insert(makeKey(500), "now present");
+        assert(!SparseMerkleTree::verifyNonMember(absent, tree.root(), mode));
+        assert(SparseMerkleTree::verifyMember(tree.prove(makeKey(500)), "now present", tree.root(), mode));
+    }
+
+    cout << "test_proofs()...Pass!" << endl;
+}
+
+
+int main(void){
+    test_updates();
+    test_batchUpdates();
+    test_proofs();
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "lib.hpp"
+
+
+/**
+ * @test test_counters() checks the hot path counters against hand counted blocks and allocations
+*/
+void test_counters(){
+
+    // 1000 bytes: 15 full blocks in update(), the 40 byte tail and padding in one final block
+    vector<uint8_t> message(1000, 'a');
+    SHA256 sha256;
+    HashCounters before = Stats::snapshot();
+    sha256.computeHash(message.data(), message.size());
+    HashCounters hashed = Stats::delta(before);
+    assert(hashed.compressions == 16);
+    assert(hashed.bytesHashed == 1000);
+
+    // the batch backends count the same blocks
+    for (const BatchBackend& backend : SHA256Batch::available()){
+        BatchMessage msgs[2] = {{message.data(), 1000}, {message.data(), 55}};
+        uint8_t digests[64];
+        before = Stats::snapshot();
+        backend.hash(msgs, 2, digests);
+        HashCounters batched = Stats::delta(before);
+        assert(batched.compressions == 17);
+        assert(batched.bytesHashed == 1055);
+    }
+
+    // bit conversion path
+    before = Stats::snapshot();
+    sha256.computeHash(sha256.stringToBinary("abc"));
+    assert(Stats::delta(before).bitsConverted == 2 * 24);
+
+    cout << "test_counters()...Pass!" << endl;
+}
+
+/**
+ * @test test_buildStats() checks the per build statistics of assembleTree() and buildTree()
+*/
+void test_buildStats(){
+
+    vector<string> inputs;
+    for (int i=1; i<=9; i++){
+        inputs.push_back(std::to_string(i));
+    }
+
+    // 9 leaves of one block, then 5 + 3 + 2 + 1 parents: 8 over 128 bytes of hex text (3 blocks)
+    // and the 3 hashed alone over 64 bytes (2 blocks)
+    MerkleTree merkelTree;
+    TreeNode* root = merkelTree.assembleTree(inputs);
+    assert(merkelTree.stats.counters.nodesAllocated == 9 + 5 + 3 + 2 + 1);
+    assert(merkelTree.stats.counters.compressions == 9 + 8 * 3 + 3 * 2);
+    assert(merkelTree.stats.counters.bytesAllocated == 20 * sizeof(Digest));
+    assert(merkelTree.stats.totalNs > 0);
+    merkelTree.freeTree(&root);
+
+    FlatTree tree = merkelTree.buildTree(inputs);
+    assert(merkelTree.stats.levelNs.size() == tree.levelCount() - 1);
+    assert(merkelTree.stats.counters.nodesAllocated == 0);
+    uint64_t parts = merkelTree.stats.leafNs;
+    for (uint64_t ns : merkelTree.stats.levelNs){
+        parts += ns;
+    }
+    assert(parts <= merkelTree.stats.totalNs);
+
+    ThreadPool pool(2);
+    merkelTree.buildTree(inputs, pool, 2);
+    assert(merkelTree.stats.levelNs.size() == tree.levelCount() - 1);
+    assert(merkelTree.stats.counters.compressions == 9 + 8 * 3 + 3 * 2);
+
+    cout << "test_buildStats()...Pass!" << endl;
+}
+
+/**
+ * @test test_trace() records a parallel build and checks the Chrome trace JSON holds its scopes
+*/
+void test_trace(){
+
+    vector<string> inputs;
+    for (int i=0; i<5000; i++){
+        inputs.push_back(std::to_string(i));
+    }
+
+    string path = "bin/test_Stats.trace.json";
+    ThreadPool pool(2);
+    MerkleTree merkelTree;
+    Stats::startTrace();
+    merkelTree.buildTree(inputs, pool, 1024);
+    Stats::stopTrace();
+    Stats::writeTrace(path);
+
+    std::ifstream in(path);
+    string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    assert(json.find("\"traceEvents\"") != string::npos);
+    assert(json.find("\"name\": \"buildTree\"") != string::npos);
+    assert(json.find("\"name\": \"subtree\", \"ph\": \"X\"") != string::npos);
+    assert(json.find("\"name\": \"level\"") != string::npos);
+    std::remove(path.c_str());
+
+    cout << "test_trace()...Pass!" << endl;
+}
+
+
+int main(void){
+    test_counters();
+    test_buildStats();
+    test_trace();
+    return 0;
+}
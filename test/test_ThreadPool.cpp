@@ -0,0 +1,165 @@
+#include "lib.hpp"
+#include "testUtil.hpp"
+
+
+/**
+ * @test test_submitAndWait() runs many small tasks and checks every one ran exactly once
+*/
+void test_submitAndWait(){
+
+    ThreadPool pool(4);
+    vector<std::atomic<int>> counts(10000);
+    for (size_t i=0; i<counts.size(); i++){
+        pool.submit([&counts, i]{ counts[i]++; });
+    }
+    pool.wait();
+
+    for (auto& count : counts){
+        assert(count.load() == 1);
+    }
+
+    // the pool is reusable after wait()
+    std::atomic<int> total{0};
+    for (int i=0; i<100; i++){
+        pool.submit([&total]{ total++; });
+    }
+    pool.wait();
+    assert(total.load() == 100);
+
+    cout << "test_submitAndWait()...Pass!" << endl;
+}
+
+/**
+ * @test test_nestedSubmit() has tasks spawn subtasks onto their own deques, the way a recursive
+ * descent spreads work, and checks wait() covers the nested tasks too
+*/
+void test_nestedSubmit(){
+
+    ThreadPool pool(3);
+    std::atomic<int> leaves{0};
+
+    // binary fan out to depth 10
+    std::function<void(int)> spawn = [&](int depth){
+        if (depth == 0){
+            leaves++;
+            return;
+        }
+        pool.submit([&spawn, depth]{ spawn(depth - 1); });
+        pool.submit([&spawn, depth]{ spawn(depth - 1); });
+    };
+    pool.submit([&spawn]{ spawn(10); });
+    pool.wait();
+
+    assert(leaves.load() == 1024);
+
+    cout << "test_nestedSubmit()...Pass!" << endl;
+}
+
+/**
+ * @test test_parallelFor() checks that the ranges handed out by parallelFor() cover every item once,
+ * including uneven tasks that idle workers have to steal around
+*/
+void test_parallelFor(){
+
+    ThreadPool pool(4);
+    vector<int> hits(1003, 0);
+    pool.parallelFor(hits.size(), 10, [&](size_t begin, size_t end){
+        for (size_t i=begin; i<end; i++){
+            hits[i]++;
+        }
+
+        // make one range far slower than the rest
+        if (begin == 0){
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    });
+
+    for (int hit : hits){
+        assert(hit == 1);
+    }
+
+    // empty range is a no-op
+    pool.parallelFor(0, 10, [&](size_t, size_t){ assert(false); });
+
+    cout << "test_parallelFor()...Pass!" << endl;
+}
+
+/**
+ * @test test_nestedParallelFor() calls parallelFor() from inside parallelFor() ranges and from a
+ * submitted task, which waits for its own ranges only, and builds a tree in parallel from a task
+*/
+void test_nestedParallelFor(){
+
+    ThreadPool pool(2);
+    vector<std::atomic<int>> hits(64 * 64);
+    pool.parallelFor(64, 1, [&](size_t outer, size_t){
+        pool.parallelFor(64, 8, [&](size_t begin, size_t end){
+            for (size_t i=begin; i<end; i++){
+                hits[outer * 64 + i]++;
+            }
+        });
+    });
+    for (auto& hit : hits){
+        assert(hit.load() == 1);
+    }
+
+    // a default group task that runs a parallel build
+    vector<string> inputs = makeInputs(5000);
+    MerkleTree merkelTree(HashMode::Binary);
+    Digest expected = merkelTree.buildTree(inputs).root();
+    Digest root;
+    pool.submit([&]{ root = merkelTree.buildTree(inputs, pool, 1024).root(); });
+    pool.wait();
+    assert(root == expected);
+
+    cout << "test_nestedParallelFor()...Pass!" << endl;
+}
+
+/**
+ * @test test_throwingTasks() checks an exception from a task reaches wait() or parallelFor() on the
+ * calling thread, the other tasks still run, and the pool stays usable
+*/
+void test_throwingTasks(){
+
+    ThreadPool pool(3);
+    std::atomic<int> ran{0};
+    bool caught = false;
+    try {
+        pool.parallelFor(100, 1, [&](size_t begin, size_t){
+            ran++;
+            if (begin % 10 == 3){
+                throw std::runtime_error("range " + std::to_string(begin));
+            }
+        });
+    } catch (const std::runtime_error& error){
+        caught = string(error.what()).rfind("range ", 0) == 0;
+    }
+    assert(caught && ran.load() == 100);
+
+    caught = false;
+    pool.submit([]{ throw std::runtime_error("task"); });
+    pool.submit([&]{ ran++; });
+    try {
+        pool.wait();
+    } catch (const std::runtime_error& error){
+        caught = string(error.what()) == "task";
+    }
+    assert(caught && ran.load() == 101);
+
+    // the error is reported once
+    pool.submit([&]{ ran++; });
+    pool.wait();
+    assert(ran.load() == 102);
+
+    cout << "test_throwingTasks()...Pass!" << endl;
+}
+
+
+int main(void){
+    test_submitAndWait();
+    test_nestedSubmit();
+    test_parallelFor();
+    test_nestedParallelFor();
+    test_throwingTasks();
+    return 0;
+}
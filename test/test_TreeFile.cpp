@@ -0,0 +1,161 @@
+#include "lib.hpp"
+#include "testUtil.hpp"
+
+#include <filesystem>
+
+
+/**
+ * @note expectThrow() checks that opening path is rejected
+*/
+void expectThrow(const string& path){
+    bool threw = false;
+    try {
+        TreeFile file(path);
+    }
+    catch (const std::runtime_error&){
+        threw = true;
+    }
+    assert(threw);
+}
+
+/**
+ * @test test_roundTrip() writes trees of several shapes in both hash modes and checks that the mapped
+ * file serves the same nodes, root and proofs as the tree in memory
+*/
+void test_roundTrip(){
+
+    string path = "bin/test_TreeFile.mklt";
+    for (HashMode mode : {HashMode::Hex, HashMode::Binary}){
+        MerkleTree merkelTree = MerkleTree(mode);
+        MerkleProof prover(mode);
+        for (size_t n : {1, 2, 3, 9, 100, 1025}){
+            FlatTree tree = merkelTree.buildTree(makeInputs(n));
+            TreeFile::write(tree, path);
+
+            TreeFile file(path);
+            assert(file.leafCount() == n);
+            assert(file.hashMode() == mode);
+            assert(file.levelCount() == tree.levelCount());
+            assert(file.rootHex() == tree.rootHex());
+            assert(file.verify());
+            for (size_t l=0; l<tree.levelCount(); l++){
+                assert(file.levelSize(l) == tree.levelSize(l));
+                assert(std::equal(tree.level(l), tree.level(l) + tree.levelSize(l), file.level(l)));
+                assert(reinterpret_cast<uintptr_t>(file.level(l)) % 64 == 0);
+            }
+
+            // proofs straight from the mapping
+            for (size_t i=0; i<n; i+=7){
+                AuditPath path = prover.prove(file, i);
+                assert(prover.verify(tree.node(0, i), path, file.root()));
+            }
+            MultiProof proof = prover.proveMany(file, {0, n / 2, n - 1});
+            assert(proof.siblings == prover.proveMany(tree, {0, n / 2, n - 1}).siblings);
+
+            // back into memory
+            FlatTree copy = file.toFlatTree();
+            assert(copy.rootHex() == tree.rootHex());
+        }
+    }
+    std::remove(path.c_str());
+
+    cout << "test_roundTrip()...Pass!" << endl;
+}
+
+/**
+ * @test test_corruption() damages a written file and checks that header damage is caught on open
+ * and level damage by verify()
+*/
+void test_corruption(){
+
+    string path = "bin/test_TreeFile.mklt";
+    MerkleTree merkelTree = MerkleTree(HashMode::Binary);
+    TreeFile::write(merkelTree.buildTree(makeInputs(50)), path);
+
+    std::ifstream in(path, std::ios::binary);
+    vector<char> original((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    auto rewrite = [&](size_t offset, size_t newSize){
+        vector<char> bytes = original;
+        if (offset < bytes.size()) { bytes[offset] ^= 1; }
+        bytes.resize(newSize);
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), bytes.size());
+    };
+
+    // magic, leaf count, level offset table, truncated file
+    rewrite(0, original.size());
+    expectThrow(path);
+    rewrite(16, original.size());
+    expectThrow(path);
+    rewrite(64, original.size());
+    expectThrow(path);
+    rewrite(original.size(), original.size() - 64);
+    expectThrow(path);
+    expectThrow("bin/no_such_tree.mklt");
+
+    // a flipped leaf opens fine but fails the full check
+    rewrite(original.size() - 32 * 3, original.size());
+    {
+        TreeFile file(path);
+        assert(!file.verify());
+    }
+
+    std::remove(path.c_str());
+
+    cout << "test_corruption()...Pass!" << endl;
+}
+
+/**
+ * @test test_concurrentWrites() writes two trees to one path from two threads at once and checks
+ * that the file ends up as one of them, and that a failed write leaves no temp file behind
+*/
+void test_concurrentWrites(){
+
+    string dir = "bin/test_TreeFile_writes";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    string path = dir + "/tree.mklt";
+
+    MerkleTree merkelTree = MerkleTree(HashMode::Binary);
+    FlatTree small = merkelTree.buildTree(makeInputs(1000));
+    FlatTree large = merkelTree.buildTree(makeInputs(3000));
+    for (int round=0; round<20; round++){
+        std::thread other([&]{ TreeFile::write(small, path); });
+        TreeFile::write(large, path);
+        other.join();
+
+        TreeFile file(path);
+        assert(file.verify());
+        assert(file.leafCount() == 1000 || file.leafCount() == 3000);
+    }
+
+    // a level that ends early fails the write and cleans up
+    bool threw = false;
+    try {
+        TreeFile::write(dir + "/short.mklt", HashMode::Binary, 10, [](size_t, Digest*, size_t){ return size_t(0); });
+    }
+    catch (const std::runtime_error&){
+        threw = true;
+    }
+    assert(threw);
+    size_t entries = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(dir)){
+        (void)entry;
+        entries++;
+    }
+    assert(entries == 1);
+
+    std::filesystem::remove_all(dir);
+
+    cout << "test_concurrentWrites()...Pass!" << endl;
+}
+
+
+int main(void){
+    test_roundTrip();
+    test_corruption();
+    test_concurrentWrites();
+    return 0;
+}